@@ -0,0 +1,123 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "ThreadPool.h"
+
+// 对比默认堆分配与slab分配器
+// 1. 纯分配/释放: 同线程释放 与 生产者分配、消费者释放(跨线程归还)
+// 2. 线程池提交吞吐: 多个生产者同时enqueue 比较HEAP与POOLED策略
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printRow(const std::string& name, double ms, size_t ops) {
+    std::cout << "  " << std::left << std::setw(36) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << ms << " ms"
+              << std::setw(12) << std::setprecision(1) << (ops / ms * 1000.0 / 1e6) << " Mops/s" << std::endl;
+}
+
+struct Record {
+    char payload[200];
+};
+
+template<class Alloc>
+double sameThreadAlloc(size_t threads, size_t perThread) {
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([perThread]() {
+            Alloc alloc;
+            std::vector<Record*> batch(64);
+            for (size_t i = 0; i < perThread; i += batch.size()) {
+                for (auto& p : batch) p = alloc.allocate(1);
+                for (auto& p : batch) alloc.deallocate(p, 1);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    return elapsedMs(start);
+}
+
+template<class Alloc>
+double crossThreadAlloc(size_t pairs, size_t perPair) {
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < pairs; ++t) {
+        auto queue = std::make_shared<std::vector<std::atomic<Record*>>>(1024);
+        workers.emplace_back([queue, perPair]() {
+            Alloc alloc;
+            for (size_t i = 0; i < perPair; ++i) {
+                auto& slot = (*queue)[i % queue->size()];
+                Record* p = alloc.allocate(1);
+                while (slot.load(std::memory_order_acquire) != nullptr) std::this_thread::yield();
+                slot.store(p, std::memory_order_release);
+            }
+        });
+        workers.emplace_back([queue, perPair]() {
+            Alloc alloc;
+            for (size_t i = 0; i < perPair; ++i) {
+                auto& slot = (*queue)[i % queue->size()];
+                Record* p;
+                while ((p = slot.load(std::memory_order_acquire)) == nullptr) std::this_thread::yield();
+                slot.store(nullptr, std::memory_order_release);
+                alloc.deallocate(p, 1);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    return elapsedMs(start);
+}
+
+double poolSubmit(AllocationPolicy policy, size_t producers, size_t perProducer) {
+    ThreadPool pool(4, LogLevel::ERROR, false);
+    pool.setAllocationPolicy(policy);
+    std::atomic<size_t> counter{0};
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&pool, &counter, perProducer]() {
+            std::vector<std::future<void>> futures;
+            futures.reserve(perProducer);
+            for (size_t i = 0; i < perProducer; ++i) {
+                futures.push_back(pool.enqueue([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }));
+            }
+            for (auto& f : futures) f.get();
+        });
+    }
+    for (auto& t : threads) t.join();
+    return elapsedMs(start);
+}
+
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t threads = std::max<size_t>(2, std::thread::hardware_concurrency());
+
+    std::cout << "分配器基准测试 (每项 " << ops << " 次操作, " << threads << " 线程)" << std::endl;
+
+    std::cout << "\n[同线程分配/释放]" << std::endl;
+    printRow("std::allocator", sameThreadAlloc<std::allocator<Record>>(threads, ops / threads), ops);
+    printRow("PoolAllocator", sameThreadAlloc<PoolAllocator<Record>>(threads, ops / threads), ops);
+
+    std::cout << "\n[生产者分配 消费者释放]" << std::endl;
+    size_t pairs = std::max<size_t>(1, threads / 2);
+    printRow("std::allocator", crossThreadAlloc<std::allocator<Record>>(pairs, ops / pairs / 4), ops / 4);
+    printRow("PoolAllocator", crossThreadAlloc<PoolAllocator<Record>>(pairs, ops / pairs / 4), ops / 4);
+
+    std::cout << "\n[线程池enqueue吞吐]" << std::endl;
+    size_t tasks = ops / 5;
+    printRow("AllocationPolicy::HEAP", poolSubmit(AllocationPolicy::HEAP, threads, tasks / threads), tasks);
+    printRow("AllocationPolicy::POOLED", poolSubmit(AllocationPolicy::POOLED, threads, tasks / threads), tasks);
+
+    std::cout << "\nslab数量: " << SlabAllocator::slabCount()
+              << ", 跨线程归还块数: " << SlabAllocator::remoteFreeCount() << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "ThreadPoolMetrics.h"
+
+// 对比改造前的紧凑原子计数器与按工作线程分片的计数器
+// 每个线程模拟工作线程完成任务时的计数: 完成数 + 执行时间
+// 在多核机器上线程数越多 紧凑布局因缓存行来回迁移而越慢
+
+using Clock = std::chrono::steady_clock;
+
+// 改造前的布局: 所有计数器相邻 所有线程写同一组原子量
+struct LegacyMetrics {
+    std::atomic<size_t> totalTasks{0};
+    std::atomic<size_t> completedTasks{0};
+    std::atomic<size_t> failedTasks{0};
+    std::atomic<size_t> activeThreads{0};
+    std::atomic<size_t> peakThreads{0};
+    std::atomic<size_t> peakQueueSize{0};
+    std::atomic<size_t> timeOutTasks{0};
+    std::atomic<uint64_t> totalTaskTimeNs{0};
+};
+
+template<class Body>
+double run(size_t threads, Body body) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&go, &body, t]() {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            body(t);
+        });
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t perThread = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    size_t maxThreads = argc > 2 ? std::stoul(argv[2]) : 64;
+
+    std::cout << "指标计数器扩展性 (每线程 " << perThread << " 次任务计数, "
+              << std::thread::hardware_concurrency() << " 个CPU)" << std::endl;
+    std::cout << std::left << std::setw(10) << "线程数"
+              << std::right << std::setw(18) << "紧凑(Mops/s)"
+              << std::setw(18) << "分片(Mops/s)" << std::setw(10) << "加速比" << std::endl;
+
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        auto legacy = std::make_unique<LegacyMetrics>();
+        double legacyMs = run(threads, [&legacy, perThread](size_t) {
+            for (size_t i = 0; i < perThread; ++i) {
+                legacy->completedTasks++;
+                legacy->totalTaskTimeNs.fetch_add(100);
+            }
+        });
+
+        auto sharded = std::make_unique<ThreadPoolMetrics>();
+        double shardedMs = run(threads, [&sharded, perThread](size_t id) {
+            for (size_t i = 0; i < perThread; ++i) {
+                sharded->addCompleted(id);
+                sharded->addTaskTime(id, 100);
+            }
+        });
+
+        if (sharded->getCompletedTasks() != threads * perThread) {
+            std::cerr << "计数错误" << std::endl;
+            return 1;
+        }
+
+        double ops = static_cast<double>(threads * perThread);
+        std::cout << std::left << std::setw(10) << threads << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << ops / legacyMs / 1000.0
+                  << std::setw(14) << ops / shardedMs / 1000.0
+                  << std::setw(10) << std::setprecision(2) << legacyMs / shardedMs << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+#include "BasicThreadPool.h"
+#include "ThreadPool.h"
+
+// 对比不同策略组合的BasicThreadPool与ThreadPool
+// 1. post空任务吞吐(不分配promise)
+// 2. submit + future.get 往返
+// 用法: bench_policies [任务数] [工作线程数]
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<size_t> checksum{0};
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printRow(const std::string& name, double postMs, double submitMs, size_t ops) {
+    std::cout << "  " << std::left << std::setw(34) << name << std::right << std::fixed
+              << std::setw(10) << std::setprecision(2) << postMs << " ms"
+              << std::setw(8) << std::setprecision(2) << (ops / postMs * 1000.0 / 1e6) << " Mops/s"
+              << std::setw(10) << std::setprecision(2) << submitMs << " ms"
+              << std::setw(8) << std::setprecision(2) << (ops / submitMs * 1000.0 / 1e6) << " Mops/s" << std::endl;
+}
+
+template<class Pool>
+double postThroughput(Pool& pool, size_t ops) {
+    std::atomic<size_t> counter{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        pool.post([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }, TaskPriority::MEDIUM);
+    }
+    pool.waitForTasks();
+    return elapsedMs(start);
+}
+
+template<class Pool>
+double submitThroughput(Pool& pool, size_t ops) {
+    std::vector<std::future<size_t>> futures;
+    futures.reserve(1024);
+    auto start = Clock::now();
+    size_t sum = 0;
+    for (size_t done = 0; done < ops; done += futures.size()) {
+        futures.clear();
+        for (size_t i = 0; i < 1024 && done + i < ops; ++i) {
+            futures.push_back(pool.submit([i]() { return i; }));
+        }
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+    }
+    double ms = elapsedMs(start);
+    checksum.fetch_add(sum, std::memory_order_relaxed);    // 防止结果被优化掉
+    return ms;
+}
+
+template<class Pool>
+void runBasic(const std::string& name, size_t ops, size_t threads) {
+    Pool pool(threads);
+    if constexpr (std::is_same_v<Pool, FullBasicThreadPool>) {
+        pool.setLogLevel(LogLevel::ERROR);
+    }
+    postThroughput(pool, ops / 10);   // 预热
+    double postMs = postThroughput(pool, ops);
+    double submitMs = submitThroughput(pool, ops);
+    printRow(name + " (" + std::to_string(sizeof(Pool)) + "B)", postMs, submitMs, ops);
+}
+
+// ThreadPool的post参数顺序不同 单独包装
+struct ThreadPoolAdapter {
+    explicit ThreadPoolAdapter(size_t threads) : pool(threads, LogLevel::ERROR, false) {}
+    void post(std::function<void()> task, TaskPriority priority) { pool.post(priority, std::move(task)); }
+    template<class F>
+    auto submit(F&& f) { return pool.enqueue(std::forward<F>(f)); }
+    void waitForTasks() { pool.waitForTasks(); }
+    ThreadPool pool;
+};
+
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+
+    std::cout << "任务数 " << ops << ", 工作线程 " << threads << std::endl;
+    std::cout << "  " << std::left << std::setw(34) << "配置" << std::right
+              << std::setw(28) << "post吞吐" << std::setw(28) << "submit吞吐" << std::endl;
+
+    runBasic<MinimalThreadPool>("Minimal(FIFO)", ops, threads);
+    runBasic<BasicThreadPool<PriorityQueuePolicy, NoMetricsPolicy, NoLoggingPolicy, NoTrackingPolicy>>(
+        "+优先级队列", ops, threads);
+    runBasic<BasicThreadPool<PriorityQueuePolicy, PoolMetricsPolicy, NoLoggingPolicy, NoTrackingPolicy>>(
+        "+优先级队列+指标", ops, threads);
+    runBasic<BasicThreadPool<PriorityQueuePolicy, PoolMetricsPolicy, LoggerPolicy, NoTrackingPolicy>>(
+        "+优先级队列+指标+日志", ops, threads);
+    runBasic<FullBasicThreadPool>("Full(全部策略)", ops, threads);
+
+    {
+        // waitForTasks会打印提示 这里只关心耗时
+        std::streambuf* saved = std::cout.rdbuf(nullptr);
+        ThreadPoolAdapter pool(threads);
+        postThroughput(pool, ops / 10);
+        double postMs = postThroughput(pool, ops);
+        double submitMs = submitThroughput(pool, ops);
+        std::cout.rdbuf(saved);
+        printRow("ThreadPool", postMs, submitMs, ops);
+    }
+    return 0;
+}
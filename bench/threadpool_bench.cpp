@@ -0,0 +1,634 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <algorithm>
+#include "ThreadPool.h"
+
+// 线程池综合基准测试
+//   threadpool_bench [--format=table|csv|json] [--ops=N] [--max-threads=N] [--filter=子串] [--output=文件]
+// 每个场景同时测试ThreadPool和两个基线: 朴素的mutex+deque线程池、std::async(每个任务一个线程)
+// 结果可以输出为CSV或JSON 便于在CI中与历史结果比较
+
+using Clock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------------------
+// 基线: 单个互斥锁保护的FIFO队列 没有优先级、超时和指标
+
+class NaivePool {
+public:
+    explicit NaivePool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this]() {
+                for (;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [this]() { return stop || !tasks.empty(); });
+                        if (stop && tasks.empty()) return;
+                        task = std::move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~NaivePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+    template<class F>
+    std::future<void> enqueue(F f) {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::move(f));
+        std::future<void> result = task->get_future();
+        post([task]() { (*task)(); });
+        return result;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stop = false;
+};
+
+// ---------------------------------------------------------------------------
+// 结果记录与输出
+
+struct BenchResult {
+    std::string scenario;
+    std::string implementation;
+    size_t workers = 0;
+    size_t producers = 0;
+    size_t ops = 0;
+    double elapsedMs = 0.0;
+    // 延迟类场景的分位数(纳秒) 吞吐类场景为0
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double p999Ns = 0.0;
+
+    double opsPerSec() const { return elapsedMs > 0.0 ? ops / elapsedMs * 1000.0 : 0.0; }
+};
+
+struct BenchOptions {
+    std::string format = "table";
+    size_t ops = 200000;
+    size_t maxThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::string filter;
+    std::string output;
+};
+
+std::vector<BenchResult> results;
+BenchOptions options;
+
+bool selected(const std::string& scenario) {
+    return options.filter.empty() || scenario.find(options.filter) != std::string::npos;
+}
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count());
+}
+
+// 就地排序后取分位数
+void fillPercentiles(BenchResult& result, std::vector<uint64_t>& samples) {
+    if (samples.empty()) return;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double p) {
+        size_t index = static_cast<size_t>(p / 100.0 * (samples.size() - 1));
+        return static_cast<double>(samples[index]);
+    };
+    result.p50Ns = at(50);
+    result.p99Ns = at(99);
+    result.p999Ns = at(99.9);
+}
+
+void addResult(BenchResult result) {
+    if (options.format == "table") {
+        std::cerr << "  " << std::left << std::setw(22) << result.scenario << std::setw(14) << result.implementation
+                  << std::right << " w=" << std::setw(3) << result.workers << " p=" << std::setw(3) << result.producers
+                  << std::setw(12) << std::fixed << std::setprecision(0) << result.opsPerSec() << " ops/s";
+        if (result.p50Ns > 0.0) {
+            std::cerr << "  p50=" << std::setprecision(1) << result.p50Ns / 1000.0 << "us p99="
+                      << result.p99Ns / 1000.0 << "us p99.9=" << result.p999Ns / 1000.0 << "us";
+        }
+        std::cerr << std::endl;
+    }
+    results.push_back(std::move(result));
+}
+
+// 计数闩: 任务完成时递减 主线程等待归零 不依赖线程池自身的waitForTasks
+class Latch {
+public:
+    explicit Latch(size_t count) : remaining(count) {}
+    void countDown() { remaining.fetch_sub(1, std::memory_order_acq_rel); }
+    void wait() const {
+        while (remaining.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    }
+private:
+    std::atomic<size_t> remaining;
+};
+
+std::vector<size_t> threadSteps() {
+    std::vector<size_t> steps;
+    for (size_t t = 1; t < options.maxThreads; t *= 2) steps.push_back(t);
+    steps.push_back(options.maxThreads);
+    return steps;
+}
+
+// 忙等指定纳秒 模拟短小的计算任务
+void spinFor(uint64_t ns) {
+    uint64_t end = nowNs() + ns;
+    while (nowNs() < end) {
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 场景
+
+// 空任务吞吐: 单个生产者提交ops个空任务 等待全部完成
+void benchEmptyThroughput() {
+    const std::string scenario = "empty_throughput";
+    if (!selected(scenario)) return;
+    size_t ops = options.ops;
+
+    for (size_t workers : threadSteps()) {
+        {
+            ThreadPool pool(workers, LogLevel::ERROR);
+            std::vector<std::future<void>> futures;
+            futures.reserve(ops);
+            auto start = Clock::now();
+            for (size_t i = 0; i < ops; ++i) futures.push_back(pool.enqueue([]() {}));
+            for (auto& f : futures) f.get();
+            addResult({scenario, "threadpool", workers, 1, ops, elapsedMs(start)});
+        }
+        {
+            ThreadPool pool(workers, LogLevel::ERROR);
+            Latch latch(ops);
+            auto start = Clock::now();
+            for (size_t i = 0; i < ops; ++i) pool.post(TaskPriority::MEDIUM, [&latch]() { latch.countDown(); });
+            latch.wait();
+            addResult({scenario, "threadpool_post", workers, 1, ops, elapsedMs(start)});
+        }
+        {
+            NaivePool pool(workers);
+            std::vector<std::future<void>> futures;
+            futures.reserve(ops);
+            auto start = Clock::now();
+            for (size_t i = 0; i < ops; ++i) futures.push_back(pool.enqueue([]() {}));
+            for (auto& f : futures) f.get();
+            addResult({scenario, "naive", workers, 1, ops, elapsedMs(start)});
+        }
+    }
+
+    // std::async每个任务创建一个线程 只跑少量任务
+    size_t asyncOps = std::max<size_t>(1, ops / 50);
+    std::vector<std::future<void>> futures;
+    futures.reserve(asyncOps);
+    auto start = Clock::now();
+    for (size_t i = 0; i < asyncOps; ++i) futures.push_back(std::async(std::launch::async, []() {}));
+    for (auto& f : futures) f.get();
+    addResult({scenario, "std_async", 0, 1, asyncOps, elapsedMs(start)});
+}
+
+// 生产者扩展性: 工作线程数固定为最大值 增加并发提交的生产者
+void benchProducerScaling() {
+    const std::string scenario = "producer_scaling";
+    if (!selected(scenario)) return;
+    size_t workers = options.maxThreads;
+
+    for (size_t producers : threadSteps()) {
+        size_t perProducer = options.ops / producers;
+        size_t ops = perProducer * producers;
+
+        auto run = [&](const std::string& name, auto&& submit) {
+            Latch latch(ops);
+            auto start = Clock::now();
+            std::vector<std::thread> threads;
+            for (size_t p = 0; p < producers; ++p) {
+                threads.emplace_back([&]() {
+                    for (size_t i = 0; i < perProducer; ++i) submit([&latch]() { latch.countDown(); });
+                });
+            }
+            for (auto& t : threads) t.join();
+            latch.wait();
+            addResult({scenario, name, workers, producers, ops, elapsedMs(start)});
+        };
+
+        {
+            ThreadPool pool(workers, LogLevel::ERROR);
+            run("threadpool_post", [&pool](std::function<void()> task) {
+                pool.post(TaskPriority::MEDIUM, std::move(task));
+            });
+        }
+        {
+            NaivePool pool(workers);
+            run("naive", [&pool](std::function<void()> task) { pool.post(std::move(task)); });
+        }
+    }
+}
+
+// 提交延迟: 单次enqueue调用本身的耗时分布(不含执行)
+void benchSubmitLatency() {
+    const std::string scenario = "submit_latency";
+    if (!selected(scenario)) return;
+    size_t ops = options.ops;
+    size_t workers = options.maxThreads;
+
+    {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        std::vector<std::future<void>> futures;
+        futures.reserve(ops);
+        std::vector<uint64_t> samples(ops);
+        auto start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            uint64_t t0 = nowNs();
+            futures.push_back(pool.enqueue([]() {}));
+            samples[i] = nowNs() - t0;
+        }
+        for (auto& f : futures) f.get();
+        BenchResult result{scenario, "threadpool", workers, 1, ops, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+    {
+        NaivePool pool(workers);
+        std::vector<std::future<void>> futures;
+        futures.reserve(ops);
+        std::vector<uint64_t> samples(ops);
+        auto start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            uint64_t t0 = nowNs();
+            futures.push_back(pool.enqueue([]() {}));
+            samples[i] = nowNs() - t0;
+        }
+        for (auto& f : futures) f.get();
+        BenchResult result{scenario, "naive", workers, 1, ops, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+}
+
+// 端到端延迟: 一问一答(提交后等待完成再提交下一个) 测量空闲线程池的调度延迟
+void benchEndToEndLatency() {
+    const std::string scenario = "end_to_end_latency";
+    if (!selected(scenario)) return;
+    size_t ops = std::min<size_t>(options.ops, 20000);
+    size_t workers = options.maxThreads;
+
+    auto run = [&](const std::string& name, size_t count, auto&& submitAndWait) {
+        std::vector<uint64_t> samples(count);
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t t0 = nowNs();
+            submitAndWait();
+            samples[i] = nowNs() - t0;
+        }
+        BenchResult result{scenario, name, workers, 1, count, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    };
+
+    {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        run("threadpool", ops, [&pool]() { pool.enqueue([]() {}).get(); });
+        run("threadpool_async", ops, [&pool]() { pool.enqueueAsync(TaskPriority::MEDIUM, []() {}).get(); });
+    }
+    {
+        NaivePool pool(workers);
+        run("naive", ops, [&pool]() { pool.enqueue([]() {}).get(); });
+    }
+    run("std_async", std::max<size_t>(1, ops / 10), []() { std::async(std::launch::async, []() {}).get(); });
+}
+
+// 优先级反转: 队列里堆积大量LOW任务时 新提交的HIGH任务要等多久才开始执行
+// 朴素线程池是FIFO 必须等前面的任务全部执行完
+void benchPriorityInversion() {
+    const std::string scenario = "priority_inversion";
+    if (!selected(scenario)) return;
+    const size_t rounds = 20;
+    const size_t backlog = 2000;
+    const uint64_t lowTaskNs = 2000;
+    size_t workers = std::min<size_t>(2, options.maxThreads);
+
+    {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        std::vector<uint64_t> samples;
+        auto start = Clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            Latch latch(backlog);
+            for (size_t i = 0; i < backlog; ++i) {
+                pool.post(TaskPriority::LOW, [&latch, lowTaskNs]() { spinFor(lowTaskNs); latch.countDown(); });
+            }
+            uint64_t t0 = nowNs();
+            std::atomic<uint64_t> startedAt{0};
+            pool.enqueueWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), [&startedAt]() {
+                startedAt.store(nowNs());
+            }).get();
+            samples.push_back(startedAt.load() - t0);
+            latch.wait();
+        }
+        BenchResult result{scenario, "threadpool", workers, 1, rounds, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+    {
+        NaivePool pool(workers);
+        std::vector<uint64_t> samples;
+        auto start = Clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            Latch latch(backlog);
+            for (size_t i = 0; i < backlog; ++i) {
+                pool.post([&latch, lowTaskNs]() { spinFor(lowTaskNs); latch.countDown(); });
+            }
+            uint64_t t0 = nowNs();
+            std::atomic<uint64_t> startedAt{0};
+            pool.enqueue([&startedAt]() { startedAt.store(nowNs()); }).get();
+            samples.push_back(startedAt.load() - t0);
+            latch.wait();
+        }
+        BenchResult result{scenario, "naive", workers, 1, rounds, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+}
+
+// 超时任务开销: 带超时的任务在内部额外启动一个std::async线程
+void benchTimeoutOverhead() {
+    const std::string scenario = "timeout_overhead";
+    if (!selected(scenario)) return;
+    size_t ops = std::max<size_t>(1, options.ops / 50);
+    size_t workers = options.maxThreads;
+
+    for (auto timeout : {std::chrono::milliseconds(0), std::chrono::milliseconds(1000)}) {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        std::vector<std::future<void>> futures;
+        futures.reserve(ops);
+        auto start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            futures.push_back(pool.enqueueWithPriority(TaskPriority::MEDIUM, timeout, []() {}));
+        }
+        for (auto& f : futures) f.get();
+        addResult({scenario, timeout.count() == 0 ? "no_timeout" : "timeout_1s", workers, 1, ops, elapsedMs(start)});
+    }
+}
+
+// 批量提交: enqueueMany 与 逐个enqueue
+void benchEnqueueMany() {
+    const std::string scenario = "enqueue_many";
+    if (!selected(scenario)) return;
+    size_t ops = options.ops;
+    size_t workers = options.maxThreads;
+    std::vector<std::function<void()>> tasks(ops, []() {});
+
+    {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        auto start = Clock::now();
+        auto futures = pool.enqueueMany(tasks);
+        for (auto& f : futures) f.get();
+        addResult({scenario, "enqueue_many", workers, 1, ops, elapsedMs(start)});
+    }
+    {
+        ThreadPool pool(workers, LogLevel::ERROR);
+        std::vector<std::future<void>> futures;
+        futures.reserve(ops);
+        auto start = Clock::now();
+        for (const auto& task : tasks) futures.push_back(pool.enqueue(task));
+        for (auto& f : futures) f.get();
+        addResult({scenario, "enqueue_loop", workers, 1, ops, elapsedMs(start)});
+    }
+}
+
+// 取消开销: 唯一的工作线程被阻塞 队列中堆积带ID的任务 测量逐个cancelTask的耗时
+void benchCancellation() {
+    const std::string scenario = "cancellation";
+    if (!selected(scenario)) return;
+    size_t ops = std::min<size_t>(options.ops, 50000);
+
+    ThreadPool pool(1, LogLevel::ERROR);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    auto blocker = pool.enqueue([opened]() { opened.wait(); });
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        futures.push_back(pool.enqueueWithInfo("bench-cancel-" + std::to_string(i), "",
+                                               TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {}));
+    }
+
+    std::vector<uint64_t> samples(ops);
+    auto start = Clock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        std::string id = "bench-cancel-" + std::to_string(i);
+        uint64_t t0 = nowNs();
+        pool.cancelTask(id);
+        samples[i] = nowNs() - t0;
+    }
+    BenchResult result{scenario, "threadpool", 1, 1, ops, elapsedMs(start)};
+    fillPercentiles(result, samples);
+    addResult(result);
+
+    gate.set_value();
+    blocker.get();
+}
+
+// 预留通道: 所有共享线程都在运行1毫秒的低优先级任务 测量CRITICAL任务从提交到开始执行的时间
+void benchCriticalLane() {
+    const std::string scenario = "critical_lane";
+    if (!selected(scenario)) return;
+    const size_t rounds = 50;
+    const size_t backlog = 20;
+    const uint64_t lowTaskNs = 1000000;
+    size_t workers = std::min<size_t>(2, options.maxThreads);
+
+    for (size_t reserved : {0, 1}) {
+        ThreadPool pool(workers, LogLevel::ERROR, false);
+        pool.setReservedWorkers(reserved);
+        std::vector<uint64_t> samples;
+        auto start = Clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            Latch latch(backlog);
+            for (size_t i = 0; i < backlog; ++i) {
+                pool.post(TaskPriority::LOW, [&latch, lowTaskNs]() { spinFor(lowTaskNs); latch.countDown(); });
+            }
+            spinFor(lowTaskNs / 2);
+            uint64_t t0 = nowNs();
+            std::atomic<uint64_t> startedAt{0};
+            pool.enqueueWithPriority(TaskPriority::CRITICAL, std::chrono::milliseconds(0), [&startedAt]() {
+                startedAt.store(nowNs());
+            }).get();
+            samples.push_back(startedAt.load() - t0);
+            latch.wait();
+        }
+        BenchResult result{scenario, reserved == 0 ? "shared_only" : "reserved_1", workers, 1, rounds,
+                           elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+}
+
+// 按任务调整nice值的开销: 交替提交LOW/HIGH任务 每个任务前一次setpriority
+// 调回较小的nice值需要CAP_SYS_NICE或RLIMIT_NICE 没有权限时线程池构造时就关闭按任务调整 per_task一组测的也是固定nice值
+void benchPerTaskNice() {
+    const std::string scenario = "per_task_nice";
+    if (!selected(scenario)) return;
+    size_t ops = std::max<size_t>(1, options.ops / 10);
+    size_t workers = std::min<size_t>(2, options.maxThreads);
+
+    for (bool perTask : {false, true}) {
+        WorkerStartOptions startOptions;
+        startOptions.scheduling.perTaskNice = perTask;
+        startOptions.scheduling.taskNice[static_cast<size_t>(TaskPriority::LOW)] = 1;
+        startOptions.scheduling.taskNice[static_cast<size_t>(TaskPriority::HIGH)] = 0;
+        ThreadPool pool(workers, startOptions, LogLevel::NONE, false);
+        Latch latch(ops);
+        auto start = Clock::now();
+        for (size_t i = 0; i < ops; ++i) {
+            pool.post(i % 2 == 0 ? TaskPriority::LOW : TaskPriority::HIGH, [&latch]() { latch.countDown(); });
+        }
+        latch.wait();
+        addResult({scenario, perTask ? "per_task" : "fixed", workers, 1, ops, elapsedMs(start)});
+    }
+}
+
+// 启动开销:构造一个maxThreads线程的池并执行一个任务 对比立即创建与按需创建
+void benchStartup() {
+    const std::string scenario = "startup";
+    if (!selected(scenario)) return;
+    size_t rounds = std::max<size_t>(1, std::min<size_t>(options.ops / 2000, 200));
+    size_t workers = options.maxThreads;
+
+    for (bool lazy : {false, true}) {
+        WorkerStartOptions startOptions;
+        startOptions.lazyStart = lazy;
+        std::vector<uint64_t> samples(rounds);
+        auto start = Clock::now();
+        for (size_t i = 0; i < rounds; ++i) {
+            uint64_t t0 = nowNs();
+            ThreadPool pool(workers, startOptions, LogLevel::ERROR, false);
+            pool.enqueue([]() {}).get();
+            samples[i] = nowNs() - t0;
+        }
+        BenchResult result{scenario, lazy ? "lazy" : "eager", workers, 1, rounds, elapsedMs(start)};
+        fillPercentiles(result, samples);
+        addResult(result);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+void writeCsv(std::ostream& out) {
+    out << std::fixed << std::setprecision(3);
+    out << "scenario,implementation,workers,producers,ops,elapsed_ms,ops_per_sec,p50_ns,p99_ns,p999_ns\n";
+    for (const auto& r : results) {
+        out << r.scenario << "," << r.implementation << "," << r.workers << "," << r.producers << ","
+            << r.ops << "," << r.elapsedMs << "," << r.opsPerSec() << ","
+            << r.p50Ns << "," << r.p99Ns << "," << r.p999Ns << "\n";
+    }
+}
+
+void writeJson(std::ostream& out) {
+    out << std::fixed << std::setprecision(3);
+    out << "{\"hardware_concurrency\":" << std::thread::hardware_concurrency() << ",\"results\":[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "  {\"scenario\":\"" << r.scenario << "\",\"implementation\":\"" << r.implementation
+            << "\",\"workers\":" << r.workers << ",\"producers\":" << r.producers
+            << ",\"ops\":" << r.ops << ",\"elapsed_ms\":" << r.elapsedMs
+            << ",\"ops_per_sec\":" << r.opsPerSec()
+            << ",\"p50_ns\":" << r.p50Ns << ",\"p99_ns\":" << r.p99Ns << ",\"p999_ns\":" << r.p999Ns << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+}
+
+bool parseOptions(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&arg]() { return arg.substr(arg.find('=') + 1); };
+        if (arg.rfind("--format=", 0) == 0) {
+            options.format = value();
+        } else if (arg.rfind("--ops=", 0) == 0) {
+            options.ops = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg.rfind("--max-threads=", 0) == 0) {
+            options.maxThreads = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            options.filter = value();
+        } else if (arg.rfind("--output=", 0) == 0) {
+            options.output = value();
+        } else {
+            std::cerr << "用法: threadpool_bench [--format=table|csv|json] [--ops=N] [--max-threads=N]"
+                         " [--filter=场景] [--output=文件]" << std::endl;
+            return false;
+        }
+    }
+    return options.format == "table" || options.format == "csv" || options.format == "json";
+}
+
+int main(int argc, char* argv[]) {
+    if (!parseOptions(argc, argv)) return 1;
+
+    if (options.format == "table") {
+        std::cerr << "线程池基准测试 (ops=" << options.ops << ", 最大线程数=" << options.maxThreads << ")" << std::endl;
+    }
+
+    benchEmptyThroughput();
+    benchProducerScaling();
+    benchSubmitLatency();
+    benchEndToEndLatency();
+    benchPriorityInversion();
+    benchTimeoutOverhead();
+    benchEnqueueMany();
+    benchCancellation();
+    benchCriticalLane();
+    benchPerTaskNice();
+    benchStartup();
+
+    //表格打印到stderr 机器可读结果写到stdout或文件 线程池自身的控制台输出不会混入
+    if (options.format == "table") return 0;
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file.is_open()) {
+            std::cerr << "无法写入 " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+    if (options.format == "csv") {
+        writeCsv(out);
+    } else {
+        writeJson(out);
+    }
+    return 0;
+}
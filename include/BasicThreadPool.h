@@ -0,0 +1,114 @@
+#ifndef BASIC_THREAD_POOL_H
+#define BASIC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PoolPolicies.h"
+
+// 按编译期策略组装的线程池
+//   QueuePolicy    FifoQueuePolicy / PriorityQueuePolicy
+//   MetricsPolicy  NoMetricsPolicy / PoolMetricsPolicy(ThreadPoolMetrics)
+//   LoggingPolicy  NoLoggingPolicy / LoggerPolicy(Logger)
+//   TrackingPolicy NoTrackingPolicy / TaskTrackingPolicy(任务ID、状态、取消、暂停)
+// 关闭的策略是空基类(空基类优化 不占空间) 相关代码在if constexpr中整体消失
+// 需要看门狗、追踪、延迟直方图等完整功能时使用ThreadPool
+template<class QueuePolicy = PriorityQueuePolicy,
+         class MetricsPolicy = PoolMetricsPolicy,
+         class LoggingPolicy = LoggerPolicy,
+         class TrackingPolicy = TaskTrackingPolicy>
+class BasicThreadPool : private MetricsPolicy, private LoggingPolicy, private TrackingPolicy {
+public:
+  explicit BasicThreadPool(size_t threads);
+  ~BasicThreadPool();
+
+  BasicThreadPool(const BasicThreadPool&) = delete;
+  BasicThreadPool& operator=(const BasicThreadPool&) = delete;
+
+  // 提交任务 返回std::future
+  template<class F, class... Args>
+  auto submit(F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  template<class F, class... Args>
+  auto submitWithPriority(TaskPriority priority, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  // 带ID提交 之后可以查询状态或取消(需要TaskTrackingPolicy)
+  template<class F, class... Args>
+  auto submitWithId(std::string taskId, TaskPriority priority, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  // 提交不关心结果的任务 不分配promise
+  void post(std::function<void()> task, TaskPriority priority = TaskPriority::MEDIUM);
+
+  // 等待所有已提交的任务执行完(或被取消)
+  void waitForTasks();
+
+  size_t getThreadCount() const { return workers.size(); }
+
+  size_t getTaskCount();
+
+  // 以下接口需要TaskTrackingPolicy
+  TaskStatus getTaskStatus(const std::string& taskId);
+  bool cancelTask(const std::string& taskId);
+  void pause();
+  void resume();
+
+  // 需要PoolMetricsPolicy
+  const ThreadPoolMetrics& getMetrics() const;
+  std::string getMetricsReport() const;
+
+  // 需要LoggerPolicy
+  void setLogLevel(LogLevel level);
+
+private:
+  // 跟踪句柄作为基类 NoTrackingPolicy时不增加任务大小
+  struct Job : TrackingPolicy::Handle {
+    std::function<void()> task;
+  };
+
+  using Queue = typename QueuePolicy::template Queue<Job>;
+
+  template<class R, class F, class... Args>
+  static std::function<void()> makeTask(std::shared_ptr<std::promise<R>> promise, F&& f, Args&&... args);
+
+  // taskId为nullptr表示匿名任务
+  void enqueueJob(std::function<void()> task, TaskPriority priority, const std::string* taskId);
+
+  void workerThread(size_t id);
+  void runJob(size_t id, Job& job);
+
+  // 一个任务结束(或被取消跳过) 最后一个任务结束时唤醒waitForTasks
+  void finishOne();
+
+  static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  Queue queue;
+  std::vector<std::thread> workers;
+  std::mutex queueMutex;
+  std::condition_variable condition;
+  std::condition_variable waitCondition;
+  bool stop = false;                      // 受queueMutex保护
+  std::atomic<size_t> pending{0};         // 已提交未结束的任务数
+};
+
+// 与ThreadPool功能相同的组合(优先级队列、指标、日志、任务跟踪)
+using FullBasicThreadPool = BasicThreadPool<PriorityQueuePolicy, PoolMetricsPolicy, LoggerPolicy, TaskTrackingPolicy>;
+
+// 内层计算用的最小线程池: FIFO队列 不统计 不记日志 不跟踪
+using MinimalThreadPool = BasicThreadPool<FifoQueuePolicy, NoMetricsPolicy, NoLoggingPolicy, NoTrackingPolicy>;
+
+#include "BasicThreadPool.inl"
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef BASIC_THREAD_POOL_INL
+#define BASIC_THREAD_POOL_INL
+
+#define BASIC_THREAD_POOL_TEMPLATE \
+  template<class QueuePolicy, class MetricsPolicy, class LoggingPolicy, class TrackingPolicy>
+#define BASIC_THREAD_POOL BasicThreadPool<QueuePolicy, MetricsPolicy, LoggingPolicy, TrackingPolicy>
+
+BASIC_THREAD_POOL_TEMPLATE
+BASIC_THREAD_POOL::BasicThreadPool(size_t threads) {
+  workers.reserve(threads);
+  for(size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([this, i]() { this->workerThread(i); });
+  }
+  if constexpr(MetricsPolicy::kEnabled) {
+    this->metrics().setThreadCount(threads);
+  }
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+BASIC_THREAD_POOL::~BasicThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stop = true;
+  }
+  condition.notify_all();
+  waitCondition.notify_all();
+  for(std::thread& worker : workers) {
+    if(worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+// 打包任务 异常写入promise后继续抛出 由工作线程计入失败
+BASIC_THREAD_POOL_TEMPLATE
+template<class R, class F, class... Args>
+std::function<void()> BASIC_THREAD_POOL::makeTask(std::shared_ptr<std::promise<R>> promise,
+                                                  F&& f, Args&&... args) {
+  return [promise, f = std::forward<F>(f),
+    args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+    try {
+      if constexpr(std::is_void_v<R>) {
+        std::apply(f, args);
+        promise->set_value();
+      } else {
+        promise->set_value(std::apply(f, args));
+      }
+    }
+    catch(...) {
+      promise->set_exception(std::current_exception());
+      throw;
+    }
+  };
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+template<class F, class... Args>
+auto BASIC_THREAD_POOL::submit(F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+  return submitWithPriority(TaskPriority::MEDIUM, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+template<class F, class... Args>
+auto BASIC_THREAD_POOL::submitWithPriority(TaskPriority priority, F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto promise = std::make_shared<std::promise<return_type>>();
+  std::future<return_type> result = promise->get_future();
+  enqueueJob(makeTask(promise, std::forward<F>(f), std::forward<Args>(args)...), priority, nullptr);
+  return result;
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+template<class F, class... Args>
+auto BASIC_THREAD_POOL::submitWithId(std::string taskId, TaskPriority priority, F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+  static_assert(TrackingPolicy::kEnabled, "submitWithId需要TaskTrackingPolicy");
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto promise = std::make_shared<std::promise<return_type>>();
+  std::future<return_type> result = promise->get_future();
+  enqueueJob(makeTask(promise, std::forward<F>(f), std::forward<Args>(args)...), priority, &taskId);
+  return result;
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::post(std::function<void()> task, TaskPriority priority) {
+  enqueueJob(std::move(task), priority, nullptr);
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::enqueueJob(std::function<void()> task, TaskPriority priority,
+                                   const std::string* taskId) {
+  Job job;
+  job.task = std::move(task);
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if(stop) {
+      throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+    if constexpr(TrackingPolicy::kEnabled) {
+      static_cast<typename TrackingPolicy::Handle&>(job) = this->track(taskId ? *taskId : std::string());
+    }
+    queue.push(std::move(job), priority);
+    pending.fetch_add(1, std::memory_order_relaxed);
+    this->onSubmit(queue.size());
+    if constexpr(LoggingPolicy::kEnabled) {
+      TP_LOG(this->logger(), LogLevel::DEBUG, "提交" + priorityToString(priority) + "优先级任务" +
+        (taskId ? " " + *taskId : std::string()));
+    }
+  }
+  condition.notify_one();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::workerThread(size_t id) {
+  while(true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      condition.wait(lock, [this]() {
+        return stop || (!this->isPaused() && !queue.empty());
+      });
+      if(stop) {
+        return;
+      }
+      job = queue.pop();
+      if(!this->beginRun(job)) {
+        //已取消的任务直接跳过
+        lock.unlock();
+        finishOne();
+        continue;
+      }
+    }
+    runJob(id, job);
+  }
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::runJob(size_t id, Job& job) {
+  bool succeeded = true;
+  uint64_t beginNs = 0;
+  if constexpr(MetricsPolicy::kEnabled) {
+    this->onStart();
+    beginNs = nowNs();
+  }
+
+  try {
+    job.task();
+  } catch(const std::exception& e) {
+    succeeded = false;
+    if constexpr(LoggingPolicy::kEnabled) {
+      TP_LOG(this->logger(), LogLevel::ERROR, "任务异常: " + std::string(e.what()));
+    }
+  } catch(...) {
+    succeeded = false;
+    if constexpr(LoggingPolicy::kEnabled) {
+      TP_LOG(this->logger(), LogLevel::ERROR, "任务异常: 未知异常");
+    }
+  }
+
+  if constexpr(MetricsPolicy::kEnabled) {
+    this->onFinish(id, nowNs() - beginNs, succeeded);
+  } else {
+    (void)id;
+    (void)succeeded;
+  }
+  if constexpr(TrackingPolicy::kEnabled) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    this->finish(job);
+  }
+  finishOne();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::finishOne() {
+  if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    //在锁内通知 避免waitForTasks检查条件后、进入等待前错过通知
+    std::lock_guard<std::mutex> lock(queueMutex);
+    waitCondition.notify_all();
+  }
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::waitForTasks() {
+  std::unique_lock<std::mutex> lock(queueMutex);
+  waitCondition.wait(lock, [this]() {
+    return stop || pending.load(std::memory_order_acquire) == 0;
+  });
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+size_t BASIC_THREAD_POOL::getTaskCount() {
+  std::lock_guard<std::mutex> lock(queueMutex);
+  return queue.size();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+TaskStatus BASIC_THREAD_POOL::getTaskStatus(const std::string& taskId) {
+  static_assert(TrackingPolicy::kEnabled, "getTaskStatus需要TaskTrackingPolicy");
+  std::lock_guard<std::mutex> lock(queueMutex);
+  return this->status(taskId);
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+bool BASIC_THREAD_POOL::cancelTask(const std::string& taskId) {
+  static_assert(TrackingPolicy::kEnabled, "cancelTask需要TaskTrackingPolicy");
+  std::lock_guard<std::mutex> lock(queueMutex);
+  bool canceled = this->cancel(taskId);
+  if constexpr(LoggingPolicy::kEnabled) {
+    if(!canceled) {
+      TP_LOG(this->logger(), LogLevel::WARN, "无法取消任务 " + taskId);
+    }
+  }
+  return canceled;
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::pause() {
+  static_assert(TrackingPolicy::kEnabled, "pause需要TaskTrackingPolicy");
+  std::lock_guard<std::mutex> lock(queueMutex);
+  this->setPaused(true);
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::resume() {
+  static_assert(TrackingPolicy::kEnabled, "resume需要TaskTrackingPolicy");
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    this->setPaused(false);
+  }
+  condition.notify_all();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+const ThreadPoolMetrics& BASIC_THREAD_POOL::getMetrics() const {
+  static_assert(MetricsPolicy::kEnabled, "getMetrics需要PoolMetricsPolicy");
+  return this->metrics();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+std::string BASIC_THREAD_POOL::getMetricsReport() const {
+  static_assert(MetricsPolicy::kEnabled, "getMetricsReport需要PoolMetricsPolicy");
+  return this->metrics().getReport();
+}
+
+BASIC_THREAD_POOL_TEMPLATE
+void BASIC_THREAD_POOL::setLogLevel(LogLevel level) {
+  static_assert(LoggingPolicy::kEnabled, "setLogLevel需要LoggerPolicy");
+  this->logger().setLevel(level);
+}
+
+#undef BASIC_THREAD_POOL
+#undef BASIC_THREAD_POOL_TEMPLATE
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "TaskInfo.h"
+
+// 延迟类型
+enum class LatencyKind {
+  WAIT,         // 提交 -> 开始执行(排队时间)
+  EXECUTION,    // 开始执行 -> 执行结束
+  END_TO_END    // 提交 -> 执行结束
+};
+
+constexpr size_t kLatencyKindCount = 3;
+
+// HDR风格的对数线性分桶(单位纳秒)
+// [0, 64)每个值一个桶 之后每个2的幂区间再均分为32个子桶 相对误差不超过1/32
+// 超过kMaxTrackableNs(约18分钟)的值计入最后一个桶
+struct LatencyBuckets {
+  static constexpr unsigned kSubBucketBits = 5;
+  static constexpr uint64_t kSubBucketCount = uint64_t(1) << kSubBucketBits;   // 32
+  static constexpr uint64_t kLinearLimit = kSubBucketCount * 2;                // 64
+  static constexpr unsigned kMaxMagnitude = 40;
+  static constexpr uint64_t kMaxTrackableNs = (uint64_t(1) << kMaxMagnitude) - 1;
+  static constexpr size_t kBucketCount =
+    kLinearLimit + (kMaxMagnitude - kSubBucketBits - 1) * kSubBucketCount;
+
+  static size_t indexOf(uint64_t valueNs);
+  static uint64_t lowerBound(size_t index);
+  static uint64_t upperBound(size_t index);   // 桶内最大值(含)
+};
+
+// 某一时刻的直方图拷贝 普通整数 可以合并、相减和查询分位数
+class HistogramSnapshot {
+public:
+  HistogramSnapshot() : counts(LatencyBuckets::kBucketCount, 0) {}
+
+  uint64_t count() const { return totalCount; }
+  uint64_t sum() const { return totalSum; }
+  double mean() const;
+
+  // 分位数 p取[0, 100] 返回所在桶的上界(纳秒) 空直方图返回0
+  uint64_t percentile(double p) const;
+
+  // 最小值/最大值 精度为所在桶
+  uint64_t min() const;
+  uint64_t max() const;
+
+  void merge(const HistogramSnapshot& other);
+  void subtract(const HistogramSnapshot& other);
+
+  const std::vector<uint64_t>& bucketCounts() const { return counts; }
+
+private:
+  friend class LatencyHistogram;
+
+  std::vector<uint64_t> counts;
+  uint64_t totalCount = 0;
+  uint64_t totalSum = 0;
+};
+
+// 无锁直方图 每个桶一个原子计数器
+// 只由一个分片的写者频繁写入 读取时拷贝成HistogramSnapshot
+class LatencyHistogram {
+public:
+  void record(uint64_t valueNs) noexcept {
+    counts[LatencyBuckets::indexOf(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    totalSum.fetch_add(valueNs, std::memory_order_relaxed);
+  }
+
+  // 累加到snapshot中
+  void addTo(HistogramSnapshot& snapshot) const;
+
+private:
+  std::atomic<uint64_t> counts[LatencyBuckets::kBucketCount] = {};
+  std::atomic<uint64_t> totalSum{0};
+};
+
+// 一个指标分片的全部直方图 按[延迟类型][优先级]组织
+struct LatencyShard {
+  LatencyHistogram histograms[kLatencyKindCount][kPriorityCount];
+};
+
+// 所有分片合并后的直方图
+struct LatencySnapshot {
+  HistogramSnapshot histograms[kLatencyKindCount][kPriorityCount];
+
+  const HistogramSnapshot& get(LatencyKind kind, TaskPriority priority) const {
+    return histograms[static_cast<size_t>(kind)][static_cast<size_t>(priority)];
+  }
+
+  // 合并所有优先级
+  HistogramSnapshot merged(LatencyKind kind) const;
+
+  void subtract(const LatencySnapshot& other);
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef LOCK_PROFILER_H
+#define LOCK_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 编译期开关: 为0时ProfiledLock只是std::unique_lock的薄包装 不读时钟也不写统计
+// 由CMake选项THREADPOOL_PROFILE_LOCKS控制 默认关闭
+#ifndef THREADPOOL_PROFILE_LOCKS
+#define THREADPOOL_PROFILE_LOCKS 0
+#endif
+
+constexpr bool kLockProfilingEnabled = THREADPOOL_PROFILE_LOCKS != 0;
+
+// queue_mutex的加锁位置
+enum class LockSite {
+  ENQUEUE,
+  GET_NEXT_TASK,
+  CLEANUP_TASK,
+  GET_TASK_STATUS,
+  CANCEL_TASK,
+  WAIT_FOR_TASKS,
+  HELP_WAIT,        // helpWait/helpWaitForTasks取任务
+  OTHER,            // resize、pause、clearTasks等低频操作
+  kCount
+};
+
+constexpr size_t kLockSiteCount = static_cast<size_t>(LockSite::kCount);
+
+const char* lockSiteName(LockSite site);
+
+// 单个加锁位置的统计 各占一条缓存行
+struct alignas(64) LockSiteStats {
+  std::atomic<uint64_t> acquisitions{0};
+  std::atomic<uint64_t> contended{0};     // try_lock失败后才拿到锁的次数
+  std::atomic<uint64_t> waitNs{0};        // 等锁时间
+  std::atomic<uint64_t> holdNs{0};        // 持锁时间(条件变量等待期间不计)
+  std::atomic<uint64_t> maxWaitNs{0};
+  std::atomic<uint64_t> maxHoldNs{0};
+};
+
+// 读取时的普通拷贝
+struct LockSiteReport {
+  LockSite site;
+  uint64_t acquisitions;
+  uint64_t contended;
+  uint64_t waitNs;
+  uint64_t holdNs;
+  uint64_t maxWaitNs;
+  uint64_t maxHoldNs;
+};
+
+// 一把锁按加锁位置的统计
+class LockProfile {
+public:
+  void recordAcquire(LockSite site, bool wasContended, uint64_t waitNs);
+  void recordHold(LockSite site, uint64_t holdNs);
+
+  LockSiteReport get(LockSite site) const;
+  void reset();
+
+  // 文本报告 编译期关闭时说明如何开启
+  std::string getReport() const;
+
+private:
+  LockSiteStats sites[kLockSiteCount];
+};
+
+// 带统计的unique_lock 构造时加锁
+// 先try_lock 失败才计为一次竞争并测量等待时间; 解锁时累计持锁时间
+class ProfiledLock {
+public:
+  ProfiledLock(std::mutex& mutex, LockProfile& profile, LockSite site)
+    : guard(mutex, std::defer_lock), profile(profile), site(site) {
+    lock();
+  }
+
+  ~ProfiledLock() {
+    if(guard.owns_lock()) unlock();
+  }
+
+  ProfiledLock(const ProfiledLock&) = delete;
+  ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+  void lock() {
+    if constexpr(kLockProfilingEnabled) {
+      if(guard.try_lock()) {
+        profile.recordAcquire(site, false, 0);
+      } else {
+        uint64_t begin = nowNs();
+        guard.lock();
+        profile.recordAcquire(site, true, nowNs() - begin);
+      }
+      heldSince = nowNs();
+    } else {
+      guard.lock();
+    }
+  }
+
+  void unlock() {
+    if constexpr(kLockProfilingEnabled) {
+      profile.recordHold(site, nowNs() - heldSince);
+    }
+    guard.unlock();
+  }
+
+  // 条件变量等待 等待期间锁已释放 不计入持锁时间
+  template<class Predicate>
+  void wait(std::condition_variable& condition, Predicate predicate) {
+    if constexpr(kLockProfilingEnabled) {
+      while(!predicate()) {
+        profile.recordHold(site, nowNs() - heldSince);
+        condition.wait(guard);
+        heldSince = nowNs();
+      }
+    } else {
+      condition.wait(guard, predicate);
+    }
+  }
+
+  // 带超时的条件变量等待 不检查条件 由调用者循环判断
+  template<class Rep, class Period>
+  void waitFor(std::condition_variable& condition, const std::chrono::duration<Rep, Period>& timeout) {
+    if constexpr(kLockProfilingEnabled) {
+      profile.recordHold(site, nowNs() - heldSince);
+      condition.wait_for(guard, timeout);
+      heldSince = nowNs();
+    } else {
+      condition.wait_for(guard, timeout);
+    }
+  }
+
+  std::unique_lock<std::mutex>& native() { return guard; }
+
+private:
+  static uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  std::unique_lock<std::mutex> guard;
+  LockProfile& profile;
+  LockSite site;
+  uint64_t heldSince = 0;
+};
+
+#endif
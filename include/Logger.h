@@ -3,6 +3,13 @@
 
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
 
 enum class LogLevel {
   NONE = 0,
@@ -12,15 +19,63 @@ enum class LogLevel {
   DEBUG = 4
 };
 
+// 编译期日志级别上限: 比它更详细的日志调用在编译期被整体移除(数值同LogLevel)
+// 由CMake按构建类型设置 Release默认为INFO(3) 其他构建为DEBUG(4)
+#ifndef THREADPOOL_COMPILED_LOG_LEVEL
+#define THREADPOOL_COMPILED_LOG_LEVEL 4
+#endif
+
+constexpr bool isLogLevelCompiled(LogLevel msgLevel) {
+  return static_cast<int>(msgLevel) <= THREADPOOL_COMPILED_LOG_LEVEL;
+}
+
+// 先检查级别再求值消息表达式 级别关闭时不会构造任何字符串
+#define TP_LOG_ENABLED(logger, msgLevel) \
+  (isLogLevelCompiled(msgLevel) && (logger).shouldLog(msgLevel))
+
+#define TP_LOG(logger, msgLevel, ...)                   \
+  do {                                                  \
+    if constexpr(isLogLevelCompiled(msgLevel)) {        \
+      if((logger).shouldLog(msgLevel)) {                \
+        (logger).log((msgLevel), (__VA_ARGS__));        \
+      }                                                 \
+    }                                                   \
+  } while(0)
+
+// 异步日志配置
+struct AsyncLogOptions {
+  size_t ringCapacity = 1024;                       // 每个生产者线程的环形缓冲区记录数(向上取2的幂)
+  std::chrono::milliseconds flushInterval{50};      // 后台线程空闲时的轮询/刷盘间隔
+};
+
 
 class Logger {
 public:
   Logger(LogLevel level = LogLevel::INFO, bool consoleOutput = true,
         const std::string& logFile = "");
 
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  ~Logger();
+
   // 写日志
   void log(LogLevel msgLevel, const std::string& message);
 
+  // 运行期级别检查 无锁 供TP_LOG在格式化消息之前调用
+  bool shouldLog(LogLevel msgLevel) const {
+    LogLevel current = level.load(std::memory_order_relaxed);
+    return current != LogLevel::NONE && msgLevel <= current;
+  }
+
+  // lambda形式的延迟格式化: 只有级别通过时才调用makeMessage
+  template<class MakeMessage>
+  void logLazy(LogLevel msgLevel, MakeMessage&& makeMessage) {
+    if(shouldLog(msgLevel)) {
+      log(msgLevel, makeMessage());
+    }
+  }
+
   // 设置日志级别
   void setLevel(LogLevel newLevel);
 
@@ -29,13 +84,89 @@ public:
 
   // 启用/禁用控制台输出
   void setConsoleOutput(bool enable);
-  
+
+  // 按文件大小轮转: 超过maxFileSize字节时 file -> file.1 -> ... -> file.maxBackupFiles
+  // maxFileSize为0表示不轮转
+  void setRotation(size_t maxFileSize, size_t maxBackupFiles);
+
+  // 启用异步模式: 生产者把定长记录写入各自线程的无锁环形缓冲区 后台线程格式化并写出
+  // 缓冲区满时丢弃新消息并计数 不阻塞生产者
+  void enableAsync(const AsyncLogOptions& options = AsyncLogOptions());
+
+  // 写完已缓冲的记录并回到同步模式 先关闭开关并等待正在写缓冲区的生产者 之后的日志走同步路径 不会丢失
+  void disableAsync();
+
+  bool isAsync() const { return asyncEnabled.load(std::memory_order_acquire); }
+
+  // 异步模式下因缓冲区满被丢弃的消息数
+  size_t getDroppedCount() const;
+
+  // 等待已缓冲的记录全部写出并刷盘
+  void flush();
 
 private:
-  LogLevel level;
+  // 定长日志记录 超长消息在UTF-8字符边界截断
+  struct LogRecord {
+    static constexpr size_t kMaxText = 240;
+    int64_t timestampNs;
+    LogLevel level;
+    uint16_t length;
+    char text[kMaxText];
+  };
+
+  // 单生产者单消费者环形缓冲区 生产者是写日志的线程 消费者是后台线程
+  struct LogRing {
+    explicit LogRing(size_t capacity);
+    bool push(LogLevel level, int64_t timestampNs, const std::string& message);
+
+    std::vector<LogRecord> records;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};     // 生产者写位置
+    std::atomic<size_t> dropped{0};              // 只由生产者递增
+    std::atomic<bool> writing{false};            // 生产者正在写入 disableAsync等它结束
+    alignas(64) std::atomic<size_t> tail{0};     // 消费者读位置
+    std::atomic<bool> retired{false};            // 生产者线程已退出
+  };
+
+  LogRing* localRing();
+  void backgroundLoop();
+  size_t drainRings();
+
+  // 格式化并写到控制台/文件 调用者持有mutex
+  void writeLine(LogLevel msgLevel, int64_t timestampNs, const char* text, size_t length);
+  void openLogFile();
+  void closeLogFile();
+  void rotateIfNeeded(size_t incoming);
+
+  std::atomic<LogLevel> level;
   bool consoleOutput;
   std::string logFile;
-  std::mutex mutex;
+  std::mutex mutex;   // 保护输出目标(文件句柄、轮转状态)
+
+  // 持久文件句柄 只在设置文件时打开一次
+  std::FILE* fileHandle = nullptr;
+  size_t fileSize = 0;
+  size_t maxFileSize = 0;
+  size_t maxBackupFiles = 0;
+
+  // 时间戳前缀缓存 同一秒内不重复调用localtime
+  int64_t cachedSecond = -1;
+  char cachedTimestamp[32] = {};
+
+  // 异步模式
+  const uint64_t loggerId;
+  std::atomic<bool> asyncEnabled{false};
+  AsyncLogOptions asyncOptions;
+  mutable std::mutex ringsMutex;
+  std::vector<std::shared_ptr<LogRing>> rings;
+  std::atomic<size_t> retiredDropped{0};   // 已移除缓冲区的丢弃计数
+  std::thread backgroundThread;
+  std::mutex backgroundMutex;
+  std::condition_variable backgroundCondition;
+  std::condition_variable flushedCondition;
+  bool backgroundStop = false;
+  uint64_t flushRequests = 0;
+  uint64_t flushesDone = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,58 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "ThreadPoolMetrics.h"
+
+// 机器可读的指标导出 只读取原子量和直方图分片 不需要线程池的queue_mutex
+
+// OpenMetrics文本格式(Prometheus可直接抓取)
+// 计数器以_total结尾 延迟直方图按优先级打标签 单位秒 使用固定的桶边界
+std::string formatOpenMetrics(const ThreadPoolMetrics& metrics);
+
+// JSON快照 延迟直方图给出次数、均值和常用分位数(纳秒)
+std::string formatMetricsJson(const ThreadPoolMetrics& metrics);
+
+
+// 极简HTTP服务 只监听本机(127.0.0.1或Unix域套接字)
+//   GET /metrics       OpenMetrics文本
+//   GET /metrics.json  JSON快照
+// 单个后台线程串行处理连接 每个请求处理完即关闭连接
+class MetricsHttpServer {
+public:
+  explicit MetricsHttpServer(const ThreadPoolMetrics& metrics);
+  ~MetricsHttpServer();
+
+  MetricsHttpServer(const MetricsHttpServer&) = delete;
+  MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+  // 监听127.0.0.1:port port为0时由系统分配 用getPort查询
+  bool listenTcp(uint16_t port);
+
+  // 监听Unix域套接字 已存在的同名文件会被删除
+  bool listenUnix(const std::string& path);
+
+  uint16_t getPort() const { return boundPort; }
+
+  bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+  void stop();
+
+private:
+  bool startLoop(int fd);
+  void serveLoop();
+  void handleConnection(int fd);
+
+  const ThreadPoolMetrics& metrics;
+  int listenFd = -1;
+  uint16_t boundPort = 0;
+  std::string unixPath;
+  std::atomic<bool> running{false};
+  std::thread serverThread;
+};
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef POOL_FUTURE_H
+#define POOL_FUTURE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <optional>
+#include <variant>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include "TaskInfo.h"
+
+class ThreadPool;
+
+template<class T>
+class PoolPromise;
+
+// 续延节点: 共享状态完成时调用一次invoke()
+// invoke()负责释放节点自身(堆上节点delete this, 内嵌在聚合状态里的节点只减引用)
+struct PoolContinuation {
+  virtual ~PoolContinuation() = default;
+  virtual void invoke() = 0;
+};
+
+// PoolFuture的共享状态
+// 结果写入后用一次原子exchange取走续延槽 整个完成路径不加锁
+// 只有真正阻塞在wait()上的线程才会用到waitMutex/waitCond
+template<class T>
+class PoolFutureState {
+public:
+  using StorageType = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  PoolFutureState() = default;
+  PoolFutureState(const PoolFutureState&) = delete;
+  PoolFutureState& operator=(const PoolFutureState&) = delete;
+  virtual ~PoolFutureState() = default;
+
+  template<class... V>
+  void setValue(V&&... v) {
+    value.emplace(std::forward<V>(v)...);
+    complete();
+  }
+
+  void setException(std::exception_ptr e) {
+    error = std::move(e);
+    complete();
+  }
+
+  bool isReady() const {
+    return ready.load(std::memory_order_acquire);
+  }
+
+  void wait() {
+    if(isReady()) return;
+
+    //先登记等待者再检查ready 与complete()里的"先置ready再读waiters"配对 不会丢唤醒
+    waiters.fetch_add(1);
+    {
+      std::unique_lock<std::mutex> lock(waitMutex);
+      waitCond.wait(lock, [this]() { return ready.load(); });
+    }
+    waiters.fetch_sub(1);
+  }
+
+  // 挂上唯一的续延 如果状态已完成则在当前线程直接触发
+  void setContinuation(PoolContinuation* c) {
+    PoolContinuation* expected = nullptr;
+    if(continuation.compare_exchange_strong(expected, c, std::memory_order_acq_rel)) {
+      return;
+    }
+    if(expected == firedTag()) {
+      c->invoke();
+      return;
+    }
+    throw std::logic_error("PoolFuture 只支持一个续延");
+  }
+
+  // 取结果 异常状态下重新抛出
+  StorageType take() {
+    if(error) {
+      std::rethrow_exception(error);
+    }
+    return std::move(*value);
+  }
+
+  std::optional<StorageType> value;
+  std::exception_ptr error;
+
+private:
+  friend class PoolPromise<T>;
+
+  void complete() {
+    ready.store(true);
+    if(waiters.load() > 0) {
+      std::lock_guard<std::mutex> lock(waitMutex);
+      waitCond.notify_all();
+    }
+
+    PoolContinuation* c = continuation.exchange(firedTag(), std::memory_order_acq_rel);
+    if(c != nullptr) {
+      c->invoke();
+    }
+  }
+
+  // 标记"续延已触发"的哨兵地址
+  static PoolContinuation* firedTag() {
+    struct FiredTag : PoolContinuation { void invoke() override {} };
+    static FiredTag tag;
+    return &tag;
+  }
+
+  std::atomic<bool> ready{false};
+  std::atomic<PoolContinuation*> continuation{nullptr};
+  std::atomic<int> waiters{0};
+  std::atomic<int> producers{0};    // 存活的PoolPromise个数
+  std::mutex waitMutex;
+  std::condition_variable waitCond;
+};
+
+
+// 生产端句柄 由任务闭包持有(std::function要求可复制 副本共用状态里的计数)
+// 最后一个副本析构时状态仍未完成(任务被clearTasks丢弃或随线程池销毁 从未执行) 以broken_promise失败
+// 否则等待方会永远阻塞
+template<class T>
+class PoolPromise {
+public:
+  explicit PoolPromise(std::shared_ptr<PoolFutureState<T>> s) : state(std::move(s)) {
+    state->producers.fetch_add(1, std::memory_order_relaxed);
+  }
+  PoolPromise(const PoolPromise& other) : state(other.state) {
+    if(state) {
+      state->producers.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  PoolPromise(PoolPromise&& other) noexcept = default;
+  PoolPromise& operator=(const PoolPromise&) = delete;
+  PoolPromise& operator=(PoolPromise&&) = delete;
+
+  ~PoolPromise() {
+    if(state && state->producers.fetch_sub(1, std::memory_order_acq_rel) == 1 && !state->isReady()) {
+      state->setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+  }
+
+  PoolFutureState<T>* operator->() const { return state.get(); }
+
+private:
+  std::shared_ptr<PoolFutureState<T>> state;
+};
+
+
+// 线程池原生future 支持then续延 可转换为std::future
+// 与std::future一样只能get()一次
+template<class T>
+class PoolFuture {
+public:
+  using value_type = T;
+
+  PoolFuture() = default;
+  PoolFuture(std::shared_ptr<PoolFutureState<T>> state, ThreadPool* pool)
+    : state(std::move(state)), pool(pool) {}
+
+  bool valid() const { return state != nullptr; }
+
+  bool isReady() const { return state && state->isReady(); }
+
+  void wait() const {
+    checkValid();
+    state->wait();
+  }
+
+  // 阻塞直到结果就绪 取走结果(或重新抛出任务异常)
+  T get() {
+    checkValid();
+    auto s = std::move(state);
+    s->wait();
+    if constexpr(std::is_void_v<T>) {
+      s->take();
+    } else {
+      return s->take();
+    }
+  }
+
+  // 结果就绪后把f作为新任务提交到线程池(使用给定优先级)
+  // 前一阶段失败时跳过f 异常直接传递给返回的future
+  template<class F>
+  auto then(F&& f, TaskPriority priority = TaskPriority::MEDIUM)
+    -> PoolFuture<typename std::conditional_t<std::is_void_v<T>,
+                                              std::invoke_result<F>,
+                                              std::invoke_result<F, T>>::type>;
+
+  // 转换为std::future 结果就绪时在完成线程上直接设置promise
+  std::future<T> toStdFuture();
+
+  ThreadPool* getPool() const { return pool; }
+
+  // 供组合器取走共享状态
+  std::shared_ptr<PoolFutureState<T>> releaseState() { return std::move(state); }
+
+private:
+  void checkValid() const {
+    if(!state) {
+      throw std::future_error(std::future_errc::no_state);
+    }
+  }
+
+  std::shared_ptr<PoolFutureState<T>> state;
+  ThreadPool* pool = nullptr;
+};
+
+
+// whenAll的结果类型: 非void为各结果组成的vector
+template<class T>
+using WhenAllResult = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+// 所有future完成后就绪 任一失败则以第一个异常失败 输入为空时抛出std::invalid_argument
+// 整个组合只分配一个聚合状态 续延节点内嵌其中
+template<class T>
+PoolFuture<WhenAllResult<T>> whenAll(std::vector<PoolFuture<T>> futures);
+
+// 任一future完成后就绪 结果为最先完成的下标(成功或失败都算完成) 输入为空时抛出std::invalid_argument
+template<class T>
+PoolFuture<size_t> whenAny(std::vector<PoolFuture<T>> futures);
+
+#endif
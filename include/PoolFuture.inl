@@ -0,0 +1,256 @@
+#ifndef POOL_FUTURE_INL
+#define POOL_FUTURE_INL
+
+// then续延: 前一阶段完成时把用户函数作为新任务投递到线程池
+template<class T, class R, class F>
+struct ThenContinuation : PoolContinuation {
+  ThenContinuation(std::shared_ptr<PoolFutureState<T>> source,
+                  std::shared_ptr<PoolFutureState<R>> target,
+                  F func, ThreadPool* pool, TaskPriority priority)
+    : source(std::move(source)), target(std::move(target))
+    , func(std::move(func)), pool(pool), priority(priority) {}
+
+  void invoke() override {
+    std::unique_ptr<ThenContinuation> self(this);
+
+    //post失败时由这里的promise设置异常 run被丢弃时由它的副本设置broken_promise
+    PoolPromise<R> promise(target);
+    auto run = [source = source, target = promise, func = std::move(func)]() mutable {
+      if(source->error) {
+        target->setException(source->error);
+        return;
+      }
+      try {
+        if constexpr(std::is_void_v<T>) {
+          if constexpr(std::is_void_v<R>) {
+            func();
+            target->setValue();
+          } else {
+            target->setValue(func());
+          }
+        } else {
+          if constexpr(std::is_void_v<R>) {
+            func(std::move(*source->value));
+            target->setValue();
+          } else {
+            target->setValue(func(std::move(*source->value)));
+          }
+        }
+      } catch(...) {
+        target->setException(std::current_exception());
+      }
+    };
+
+    try {
+      pool->post(priority, std::move(run));
+    } catch(...) {
+      //线程池已停止 续延无法调度
+      promise->setException(std::current_exception());
+    }
+  }
+
+  std::shared_ptr<PoolFutureState<T>> source;
+  std::shared_ptr<PoolFutureState<R>> target;
+  F func;
+  ThreadPool* pool;
+  TaskPriority priority;
+};
+
+template<class T>
+template<class F>
+auto PoolFuture<T>::then(F&& f, TaskPriority priority)
+  -> PoolFuture<typename std::conditional_t<std::is_void_v<T>,
+                                            std::invoke_result<F>,
+                                            std::invoke_result<F, T>>::type> {
+  using R = typename std::conditional_t<std::is_void_v<T>,
+                                        std::invoke_result<F>,
+                                        std::invoke_result<F, T>>::type;
+  using Func = std::decay_t<F>;
+  checkValid();
+
+  auto source = std::move(state);
+  auto target = std::make_shared<PoolFutureState<R>>();
+  source->setContinuation(new ThenContinuation<T, R, Func>(
+    source, target, std::forward<F>(f), pool, priority));
+
+  return PoolFuture<R>(std::move(target), pool);
+}
+
+
+// std::future桥接: 在完成线程上直接设置promise 不额外调度
+template<class T>
+struct StdFutureBridge : PoolContinuation {
+  explicit StdFutureBridge(std::shared_ptr<PoolFutureState<T>> source)
+    : source(std::move(source)) {}
+
+  void invoke() override {
+    std::unique_ptr<StdFutureBridge> self(this);
+    if(source->error) {
+      promise.set_exception(source->error);
+    } else if constexpr(std::is_void_v<T>) {
+      promise.set_value();
+    } else {
+      promise.set_value(std::move(*source->value));
+    }
+  }
+
+  std::shared_ptr<PoolFutureState<T>> source;
+  std::promise<T> promise;
+};
+
+template<class T>
+std::future<T> PoolFuture<T>::toStdFuture() {
+  checkValid();
+  auto source = std::move(state);
+  auto* bridge = new StdFutureBridge<T>(source);
+  std::future<T> result = bridge->promise.get_future();
+  source->setContinuation(bridge);
+  return result;
+}
+
+
+// whenAll聚合状态 本身就是输出future的共享状态
+// 每个输入的续延节点内嵌在nodes中 最后一个完成的输入释放keepAlive
+template<class T>
+class WhenAllState : public PoolFutureState<WhenAllResult<T>> {
+public:
+  struct Node : PoolContinuation {
+    WhenAllState* owner = nullptr;
+    PoolFutureState<T>* input = nullptr;
+    size_t index = 0;
+    void invoke() override { owner->onInputReady(*this); }
+  };
+
+  explicit WhenAllState(size_t n) : nodes(n), remaining(n) {
+    if constexpr(!std::is_void_v<T>) {
+      results.resize(n);
+    }
+  }
+
+  void onInputReady(Node& node) {
+    if(node.input->error) {
+      if(!failed.exchange(true, std::memory_order_relaxed)) {
+        firstError = node.input->error;
+      }
+    } else if constexpr(!std::is_void_v<T>) {
+      results[node.index] = std::move(*node.input->value);
+    }
+
+    if(remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+
+    //最后一个输入: 发布结果后释放自引用(this可能随之析构 之后不能再访问成员)
+    auto self = std::move(keepAlive);
+    if(failed.load(std::memory_order_relaxed)) {
+      this->setException(firstError);
+    } else if constexpr(std::is_void_v<T>) {
+      this->setValue();
+    } else {
+      std::vector<T> values;
+      values.reserve(results.size());
+      for(auto& r : results) {
+        values.push_back(std::move(*r));
+      }
+      this->setValue(std::move(values));
+    }
+  }
+
+  std::vector<Node> nodes;
+  std::vector<std::optional<typename PoolFutureState<T>::StorageType>> results;
+  std::atomic<size_t> remaining;
+  std::atomic<bool> failed{false};
+  std::exception_ptr firstError;
+  std::shared_ptr<WhenAllState> keepAlive;
+};
+
+template<class T>
+PoolFuture<WhenAllResult<T>> whenAll(std::vector<PoolFuture<T>> futures) {
+  //没有输入就没有线程池可以投递then续延
+  if(futures.empty()) {
+    throw std::invalid_argument("whenAll: 至少需要一个PoolFuture");
+  }
+  ThreadPool* pool = nullptr;
+  for(auto& f : futures) {
+    if(!f.valid()) {
+      throw std::invalid_argument("whenAll: 无效的PoolFuture");
+    }
+    pool = f.getPool();
+  }
+
+  auto agg = std::make_shared<WhenAllState<T>>(futures.size());
+  agg->keepAlive = agg;
+  std::vector<std::shared_ptr<PoolFutureState<T>>> inputs;
+  inputs.reserve(futures.size());
+  for(size_t i = 0; i < futures.size(); ++i) {
+    inputs.push_back(futures[i].releaseState());
+    agg->nodes[i].owner = agg.get();
+    agg->nodes[i].input = inputs.back().get();
+    agg->nodes[i].index = i;
+  }
+  //节点全部就位后再挂续延 已完成的输入会在这里同步触发
+  for(size_t i = 0; i < inputs.size(); ++i) {
+    inputs[i]->setContinuation(&agg->nodes[i]);
+  }
+
+  return PoolFuture<WhenAllResult<T>>(std::move(agg), pool);
+}
+
+
+// whenAny聚合状态 第一个完成的输入发布下标 所有输入完成后释放自引用
+template<class T>
+class WhenAnyState : public PoolFutureState<size_t> {
+public:
+  struct Node : PoolContinuation {
+    WhenAnyState* owner = nullptr;
+    size_t index = 0;
+    void invoke() override { owner->onInputReady(index); }
+  };
+
+  explicit WhenAnyState(size_t n) : nodes(n), remaining(n) {}
+
+  void onInputReady(size_t index) {
+    if(!done.exchange(true, std::memory_order_acq_rel)) {
+      this->setValue(index);
+    }
+    if(remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      auto self = std::move(keepAlive);
+    }
+  }
+
+  std::vector<Node> nodes;
+  std::atomic<size_t> remaining;
+  std::atomic<bool> done{false};
+  std::shared_ptr<WhenAnyState> keepAlive;
+};
+
+template<class T>
+PoolFuture<size_t> whenAny(std::vector<PoolFuture<T>> futures) {
+  if(futures.empty()) {
+    throw std::invalid_argument("whenAny: 至少需要一个PoolFuture");
+  }
+  ThreadPool* pool = nullptr;
+  for(auto& f : futures) {
+    if(!f.valid()) {
+      throw std::invalid_argument("whenAny: 无效的PoolFuture");
+    }
+    pool = f.getPool();
+  }
+
+  auto agg = std::make_shared<WhenAnyState<T>>(futures.size());
+  agg->keepAlive = agg;
+  std::vector<std::shared_ptr<PoolFutureState<T>>> inputs;
+  inputs.reserve(futures.size());
+  for(size_t i = 0; i < futures.size(); ++i) {
+    inputs.push_back(futures[i].releaseState());
+    agg->nodes[i].owner = agg.get();
+    agg->nodes[i].index = i;
+  }
+  for(size_t i = 0; i < inputs.size(); ++i) {
+    inputs[i]->setContinuation(&agg->nodes[i]);
+  }
+
+  return PoolFuture<size_t>(std::move(agg), pool);
+}
+
+#endif
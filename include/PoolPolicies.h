@@ -0,0 +1,215 @@
+#ifndef POOL_POLICIES_H
+#define POOL_POLICIES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TaskInfo.h"
+#include "Logger.h"
+#include "ThreadPoolMetrics.h"
+
+// BasicThreadPool的编译期策略
+// 每类策略提供一个"关闭"版本: 空类(作为基类不占空间) 钩子都是空的内联函数
+// 线程池在if constexpr(Policy::kEnabled)中调用开启版本特有的接口 关闭时这些代码不会被实例化
+
+// ---------------- 队列策略 ----------------
+
+// 先进先出 忽略优先级
+struct FifoQueuePolicy {
+  template<class Job>
+  class Queue {
+  public:
+    void push(Job&& job, TaskPriority) { jobs.push_back(std::move(job)); }
+    bool empty() const { return jobs.empty(); }
+    size_t size() const { return jobs.size(); }
+
+    Job pop() {
+      Job job = std::move(jobs.front());
+      jobs.pop_front();
+      return job;
+    }
+
+  private:
+    std::deque<Job> jobs;
+  };
+};
+
+// 按优先级出队 同优先级先进先出(与ThreadPool的任务队列一致)
+struct PriorityQueuePolicy {
+  template<class Job>
+  class Queue {
+  public:
+    void push(Job&& job, TaskPriority priority) {
+      heap.push_back(Entry{priority, nextSequence++, std::move(job)});
+      std::push_heap(heap.begin(), heap.end(), Less());
+    }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    Job pop() {
+      std::pop_heap(heap.begin(), heap.end(), Less());
+      Job job = std::move(heap.back().job);
+      heap.pop_back();
+      return job;
+    }
+
+  private:
+    struct Entry {
+      TaskPriority priority;
+      uint64_t sequence;
+      Job job;
+    };
+
+    struct Less {
+      bool operator()(const Entry& a, const Entry& b) const {
+        if(a.priority != b.priority) {
+          return a.priority < b.priority;
+        }
+        return a.sequence > b.sequence;
+      }
+    };
+
+    std::vector<Entry> heap;
+    uint64_t nextSequence = 0;
+  };
+};
+
+// ---------------- 指标策略 ----------------
+
+// 不统计 不读时钟
+struct NoMetricsPolicy {
+  static constexpr bool kEnabled = false;
+
+  void onSubmit(size_t) {}
+  void onStart() {}
+  void onFinish(size_t, uint64_t, bool) {}
+};
+
+// 复用ThreadPoolMetrics的分片计数器、直方图和导出
+class PoolMetricsPolicy {
+public:
+  static constexpr bool kEnabled = true;
+
+  // 在队列锁内调用
+  void onSubmit(size_t queueSize) {
+    poolMetrics.addSubmitted(ThreadPoolMetrics::kExternalWorkerId);
+    poolMetrics.updateQueueSize(queueSize);
+  }
+  void onStart() { poolMetrics.threadStarted(); }
+
+  void onFinish(size_t workerId, uint64_t executionNs, bool succeeded) {
+    if(succeeded) {
+      poolMetrics.addCompleted(workerId);
+    } else {
+      poolMetrics.addFailed(workerId);
+    }
+    poolMetrics.addTaskTime(workerId, executionNs);
+    poolMetrics.threadFinished();
+  }
+
+  ThreadPoolMetrics& metrics() { return poolMetrics; }
+  const ThreadPoolMetrics& metrics() const { return poolMetrics; }
+
+private:
+  ThreadPoolMetrics poolMetrics;
+};
+
+// ---------------- 日志策略 ----------------
+
+struct NoLoggingPolicy {
+  static constexpr bool kEnabled = false;
+};
+
+// 使用线程池的Logger 默认只输出WARN及以上
+class LoggerPolicy {
+public:
+  static constexpr bool kEnabled = true;
+
+  LoggerPolicy() : poolLogger(LogLevel::WARN, true, "") {}
+
+  Logger& logger() { return poolLogger; }
+
+private:
+  Logger poolLogger;
+};
+
+// ---------------- 任务跟踪策略 ----------------
+// 任务ID映射、状态查询、取消等待中的任务以及暂停/恢复
+
+struct NoTrackingPolicy {
+  static constexpr bool kEnabled = false;
+
+  struct Handle {};
+
+  bool isPaused() const { return false; }
+  bool beginRun(Handle&) { return true; }
+};
+
+// 所有方法都在线程池的队列锁内调用 任务结束后从映射表移除(查询返回NOT_FOUND 与ThreadPool一致)
+class TaskTrackingPolicy {
+public:
+  static constexpr bool kEnabled = true;
+
+  struct Handle {
+    std::string taskId;   // 为空表示匿名任务 不进入映射表
+  };
+
+  // 登记任务 ID重复时抛出异常
+  Handle track(std::string taskId) {
+    if(!taskId.empty() && !tasks.emplace(taskId, TaskStatus::WAITING).second) {
+      throw std::runtime_error("Task ID " + taskId + " already exists");
+    }
+    return Handle{std::move(taskId)};
+  }
+
+  bool isPaused() const { return paused; }
+  void setPaused(bool value) { paused = value; }
+
+  // 出队时调用 已取消的任务返回false并从映射表移除
+  bool beginRun(Handle& handle) {
+    if(handle.taskId.empty()) {
+      return true;
+    }
+    auto it = tasks.find(handle.taskId);
+    if(it != tasks.end() && it->second == TaskStatus::CANCELED) {
+      tasks.erase(it);
+      return false;
+    }
+    if(it != tasks.end()) {
+      it->second = TaskStatus::RUNNING;
+    }
+    return true;
+  }
+
+  void finish(Handle& handle) {
+    if(!handle.taskId.empty()) {
+      tasks.erase(handle.taskId);
+    }
+  }
+
+  TaskStatus status(const std::string& taskId) const {
+    auto it = tasks.find(taskId);
+    return it == tasks.end() ? TaskStatus::NOT_FOUND : it->second;
+  }
+
+  // 只能取消等待中的任务
+  bool cancel(const std::string& taskId) {
+    auto it = tasks.find(taskId);
+    if(it == tasks.end() || it->second != TaskStatus::WAITING) {
+      return false;
+    }
+    it->second = TaskStatus::CANCELED;
+    return true;
+  }
+
+private:
+  std::unordered_map<std::string, TaskStatus> tasks;
+  bool paused = false;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TaskInfo.h"
+
+// 一个限流类别的状态
+struct RateLimitStats {
+  std::string category;
+  double tasksPerSecond = 0.0;
+  double burst = 0.0;
+  double tokens = 0.0;          // 当前可用的令牌
+  size_t queued = 0;            // 在侧队列中等待令牌的任务数
+  size_t peakQueued = 0;
+  uint64_t admitted = 0;        // 已放行到主队列的任务数(含立即放行的)
+  uint64_t throttled = 0;       // 提交时没有令牌、进入侧队列的任务数
+};
+
+// 按类别的令牌桶限流
+// 每个类别以tasksPerSecond的速率补充令牌 最多积攒burst个 每个任务消耗一个令牌
+// 有令牌且侧队列为空时任务直接放行 否则按提交顺序进入该类别的侧队列
+// 一个定时线程(第一次设置限流时启动)在下一个令牌到来时把侧队列中的任务交给放行回调
+class RateLimiter {
+public:
+  // 在定时线程上调用 不持有限流器的锁
+  using ReleaseHandler = std::function<void(std::vector<std::shared_ptr<TaskInfo>>&&)>;
+
+  explicit RateLimiter(ReleaseHandler onRelease);
+  ~RateLimiter();
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  // 创建或修改类别 修改时保留已积攒的令牌(不超过新的burst) tasksPerSecond为0时暂停放行
+  void setLimit(const std::string& category, double tasksPerSecond, double burst);
+
+  // 删除类别 侧队列中的任务移入released由调用者直接放行 类别不存在时返回false
+  bool removeLimit(const std::string& category, std::vector<std::shared_ptr<TaskInfo>>& released);
+
+  bool hasLimit(const std::string& category) const;
+
+  // 有令牌可用时消耗一个并返回true 否则把task移入侧队列并返回false
+  // 类别不存在时抛出std::invalid_argument
+  bool admit(const std::string& category, std::shared_ptr<TaskInfo>& task);
+
+  // 取出所有侧队列中的任务 调用者在自己的锁外释放它们(析构时可能完成future并触发续延)
+  std::vector<std::shared_ptr<TaskInfo>> clear();
+
+  // 停止定时线程 侧队列中的任务不再放行
+  void stop();
+
+  // 各类别的状态 按类别名排序
+  std::vector<RateLimitStats> snapshot() const;
+
+  // 文本报告 每个类别一行 没有类别时为空
+  std::string getReport() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Category {
+    RateLimitStats stats;
+    Clock::time_point refilledAt;
+    std::deque<std::shared_ptr<TaskInfo>> pending;
+  };
+
+  // 按经过的时间补充令牌(持有mutex)
+  static void refill(Category& category, Clock::time_point now);
+  void timerLoop();
+
+  ReleaseHandler onRelease;
+  mutable std::mutex mutex;
+  std::condition_variable timerCondition;
+  std::map<std::string, Category> categories;
+  bool stopRequested = false;
+  std::thread timer;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef SHARED_TASK_QUEUE_H
+#define SHARED_TASK_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "TaskInfo.h"
+
+// 共享内存段的尺寸
+struct SharedQueueOptions {
+  size_t slots = 1024;        // 每个环的槽位数 向上取整为2的幂
+  size_t slotBytes = 4096;    // 每个槽位的字节数(含32字节槽位头) 处理函数名和参数/结果共用剩余空间
+};
+
+// 从请求环取出的任务描述
+struct SharedTaskRequest {
+  uint64_t requestId = 0;
+  TaskPriority priority = TaskPriority::MEDIUM;
+  std::string handler;
+  std::string payload;
+  bool valid = true;    // 槽位头中的长度越界(对端损坏或恶意) 内容已丢弃 只有requestId可用
+};
+
+// 从完成环取出的结果 ok为false时result是错误信息
+struct SharedTaskCompletion {
+  uint64_t requestId = 0;
+  bool ok = false;
+  std::string result;
+  bool valid = true;    // 同SharedTaskRequest::valid 无效时ok为false
+};
+
+// 跨进程共享的任务队列: shm_open/mmap的一个段里放两个无锁环(请求环和完成环)
+// 每个环是有界多生产者多消费者环(每个槽位一个序号) 消息按值拷贝进槽位 不做任何指针传递
+// 消费者在环为空时通过共享futex等待 生产者只在有等待者时才做唤醒系统调用
+// 某个进程在写槽位的中途崩溃会让该槽位永远不可读 段需要重新创建
+class SharedTaskQueue {
+public:
+  // 创建(或重新初始化)名为name的段 如"/pool-queue" 创建者析构时删除段名 失败返回nullptr(errno保留)
+  static std::unique_ptr<SharedTaskQueue> create(const std::string& name,
+                                                 const SharedQueueOptions& options = SharedQueueOptions());
+
+  // 打开已经初始化的段 不存在或格式不符时返回nullptr
+  static std::unique_ptr<SharedTaskQueue> open(const std::string& name);
+
+  static bool unlink(const std::string& name);
+
+  ~SharedTaskQueue();
+
+  SharedTaskQueue(const SharedTaskQueue&) = delete;
+  SharedTaskQueue& operator=(const SharedTaskQueue&) = delete;
+
+  const std::string& name() const { return segmentName; }
+  size_t slotCount() const;
+  // 一条消息(处理函数名 + 参数或结果)的最大字节数
+  size_t maxMessageBytes() const;
+
+  // 段内全局递增的请求ID(所有进程共享) 从1开始
+  uint64_t nextRequestId();
+
+  // 以下try操作都不阻塞 环满或为空时返回false
+  // 消息超过maxMessageBytes时抛出std::invalid_argument
+  bool pushRequest(uint64_t requestId, TaskPriority priority, const std::string& handler,
+                   const std::string& payload);
+  bool popRequest(SharedTaskRequest& request);
+  bool pushCompletion(uint64_t requestId, bool ok, const std::string& result);
+  bool popCompletion(SharedTaskCompletion& completion);
+
+  // 等待请求环/完成环非空 最多等待timeout
+  void waitForRequest(std::chrono::milliseconds timeout);
+  void waitForCompletion(std::chrono::milliseconds timeout);
+
+private:
+  SharedTaskQueue(std::string name, void* base, size_t bytes, uint64_t slots, uint64_t slotBytes, bool owner);
+
+  std::string segmentName;
+  void* base;
+  size_t mappedBytes;
+  // 映射时校验过的尺寸 不再读取段头中可被其他进程改写的副本
+  uint64_t slots;
+  uint64_t slotBytes;
+  bool owner;
+};
+
+
+// 前端进程使用的客户端: 提交返回future 一个后台线程读取完成环并按请求ID设置结果
+// 完成环不区分提交者 同一个段只应有一个客户端
+class SharedTaskClient {
+public:
+  explicit SharedTaskClient(std::unique_ptr<SharedTaskQueue> queue);
+  // 仍未完成的future收到broken_promise
+  ~SharedTaskClient();
+
+  SharedTaskClient(const SharedTaskClient&) = delete;
+  SharedTaskClient& operator=(const SharedTaskClient&) = delete;
+
+  // 请求环满时短暂休眠后重试 直到有空位
+  // 处理函数抛出异常或不存在时 future抛出std::runtime_error(错误信息来自消费进程)
+  std::future<std::string> submit(const std::string& handler, const std::string& payload,
+                                  TaskPriority priority = TaskPriority::MEDIUM);
+
+  SharedTaskQueue& queue() { return *sharedQueue; }
+
+  // 已提交但尚未收到结果的请求数
+  size_t pendingCount() const;
+
+private:
+  void completionLoop();
+
+  std::unique_ptr<SharedTaskQueue> sharedQueue;
+  mutable std::mutex pendingMutex;
+  std::unordered_map<uint64_t, std::promise<std::string>> pending;
+  std::atomic<bool> stopping{false};
+  std::thread completionThread;
+};
+
+
+// 线程池一侧的消费者: 一个拉取线程在本地执行中的共享任务少于maxInFlight时从请求环取任务
+// 只拉取能马上执行的数量 其余请求留在环里给其他进程的线程池 以此在进程间分担负载
+// 提交到线程池的任务持有消费者的共享指针 拉取线程停止后仍在执行的任务照常写回结果
+// 任务没有执行就被丢弃(线程池析构、clearTasks)时写回失败结果
+class SharedQueueConsumer : public std::enable_shared_from_this<SharedQueueConsumer> {
+public:
+  using Handler = std::function<std::string(const std::string&)>;
+  // 按名字查找处理函数 没有时返回空的Handler
+  using HandlerLookup = std::function<Handler(const std::string&)>;
+  // 把任务提交给线程池
+  using Submit = std::function<void(TaskPriority, std::function<void()>)>;
+  // 完成环一直满(前端停止读取)超过completionTimeout 结果被丢弃时调用
+  using Dropped = std::function<void()>;
+
+  SharedQueueConsumer(std::unique_ptr<SharedTaskQueue> queue, size_t maxInFlight,
+                      HandlerLookup lookup, Submit submit,
+                      std::chrono::milliseconds completionTimeout = std::chrono::seconds(5),
+                      Dropped dropped = Dropped());
+  ~SharedQueueConsumer();
+
+  void start();
+  void stop();
+
+  size_t inFlight() const { return running.load(std::memory_order_relaxed); }
+  size_t droppedCount() const { return droppedCompletions.load(std::memory_order_relaxed); }
+
+private:
+  struct PostedRequest;
+
+  void pullLoop();
+  // 在线程池的工作线程上执行一个请求并写回结果
+  void execute(const SharedTaskRequest& request);
+  // 写回结果并释放一个执行名额
+  void finish(uint64_t requestId, bool ok, const std::string& result);
+  void complete(uint64_t requestId, bool ok, const std::string& result);
+
+  std::unique_ptr<SharedTaskQueue> sharedQueue;
+  const size_t maxInFlight;
+  const std::chrono::milliseconds completionTimeout;
+  HandlerLookup lookup;
+  Submit submit;
+  Dropped dropped;
+  std::atomic<size_t> droppedCompletions{0};
+
+  std::atomic<size_t> running{0};
+  std::mutex slotMutex;
+  std::condition_variable slotFreed;
+  std::atomic<bool> stopping{false};
+  std::thread puller;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef SPILL_STORE_H
+#define SPILL_STORE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "TaskInfo.h"
+
+// 溢出到磁盘的配置
+struct SpillOptions {
+  std::string directory = "/tmp";       // 段文件所在目录
+  size_t maxQueuedTasks = 100000;       // 内存队列中的任务数达到它后 可序列化的LOW/MEDIUM任务写入段文件
+  size_t segmentBytes = 64 * 1024 * 1024;   // 每个段文件的大小 超过它的单条记录独占一个段
+};
+
+// 从段文件读回的任务
+struct SpilledTask {
+  std::string handler;
+  std::string payload;
+  std::chrono::steady_clock::time_point submitTime;
+};
+
+// 一个只追加的内存映射段文件 创建后立即删除文件名 进程退出(包括崩溃)时不留下文件
+struct SpillSegment;
+
+// 按优先级的溢出队列 每个优先级是一串段文件 写入追加到最后一个段 读取从第一个段按FIFO进行
+// 写满的段发起异步回写并放弃映射中的页 内存紧张时内核可以回收它们 读取时再按需缺页读入
+// 读完的段立即解除映射并关闭 不是线程安全的 由线程池在自己的spillMutex内调用(不持有queue_mutex)
+class SpillStore {
+public:
+  SpillStore();
+  ~SpillStore();
+
+  SpillStore(const SpillStore&) = delete;
+  SpillStore& operator=(const SpillStore&) = delete;
+
+  // 目录不可写时返回false 已写入的段不受新配置影响
+  bool enable(const SpillOptions& options);
+  bool isEnabled() const { return enabled; }
+  const SpillOptions& options() const { return config; }
+
+  // 只有LOW和MEDIUM任务可以溢出
+  static bool canSpill(TaskPriority priority) {
+    return priority == TaskPriority::LOW || priority == TaskPriority::MEDIUM;
+  }
+
+  // 追加一条记录 返回写入的字节数 创建或映射段文件失败时返回0(errno保留)
+  size_t append(TaskPriority priority, const std::string& handler, const std::string& payload,
+                std::chrono::steady_clock::time_point submitTime);
+  // 按FIFO读出一条记录 返回读取的字节数 该优先级没有溢出的任务时返回0
+  size_t pop(TaskPriority priority, SpilledTask& task);
+
+  size_t size(TaskPriority priority) const { return counts[static_cast<size_t>(priority)]; }
+  size_t size() const;
+  // 丢弃全部溢出的任务 返回丢弃的任务数
+  size_t clear();
+
+private:
+  std::unique_ptr<SpillSegment> createSegment(size_t minBytes);
+
+  bool enabled = false;
+  SpillOptions config;
+  std::deque<std::unique_ptr<SpillSegment>> segments[kPriorityCount];
+  size_t counts[kPriorityCount] = {};
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef STRAND_H
+#define STRAND_H
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "ThreadPool.h"
+
+// 串行执行器: 投递到同一个Strand的任务按FIFO顺序执行且互不重叠
+// 不同Strand之间在线程池上并行
+//
+// 任务放在无锁MPSC链表里 pendingCount从0变为1的生产者负责把drain任务投递到线程池
+// 所以同一时刻最多只有一个工作线程在执行该Strand 其他工作线程不会因为它阻塞
+// drain任务没有执行就被丢弃(例如clearTasks)时 已投递的任务随之丢弃 之后的post重新调度
+class Strand : public std::enable_shared_from_this<Strand> {
+public:
+  // Strand必须由shared_ptr持有(已调度的drain任务会保持它存活)
+  static std::shared_ptr<Strand> create(ThreadPool& pool,
+                                        TaskPriority priority = TaskPriority::MEDIUM);
+
+  Strand(const Strand&) = delete;
+  Strand& operator=(const Strand&) = delete;
+  ~Strand();
+
+  // 投递不关心结果的任务 任务抛出的异常会被丢弃
+  // 调度drain任务失败(线程池已停止)时丢弃已入队但未执行的任务并重新抛出异常
+  void post(std::function<void()> task);
+
+  // 投递任务并通过future获取结果
+  template<class F, class... Args>
+  auto enqueue(F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  // 已投递但尚未执行完的任务数
+  size_t pending() const { return pendingCount.load(std::memory_order_acquire); }
+
+private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    std::function<void()> task;
+  };
+
+  Strand(ThreadPool& pool, TaskPriority priority);
+
+  void push(Node* node);
+  Node* pop();
+  struct DrainGuard;
+  void schedule();
+  void discardPending();
+  void run();
+
+  // 每次drain最多连续执行的任务数 超过后重新排队 让出工作线程给其他Strand
+  static constexpr size_t kBatchSize = 64;
+
+  ThreadPool& pool;
+  TaskPriority priority;
+
+  std::atomic<Node*> head;  // 生产者端 用exchange追加
+  Node* tail;               // 消费者端 只有正在drain的线程访问
+  Node stub;
+  std::atomic<size_t> pendingCount{0};
+};
+
+template<class F, class... Args>
+auto Strand::enqueue(F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto promise = std::make_shared<std::promise<return_type>>();
+  std::future<return_type> result = promise->get_future();
+
+  post([promise, f = std::forward<F>(f),
+    args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+    try {
+      if constexpr(std::is_void_v<return_type>) {
+        std::apply(f, args);
+        promise->set_value();
+      } else {
+        promise->set_value(std::apply(f, args));
+      }
+    } catch(...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return result;
+}
+
+
+// 按key分派的串行执行器: 相同key的任务串行FIFO 不同key并行
+// key到Strand的映射按分片加锁 只在查找时短暂持有 执行任务时不持有任何锁
+template<class Key, class Hash = std::hash<Key>>
+class KeyedExecutor {
+public:
+  explicit KeyedExecutor(ThreadPool& pool, TaskPriority priority = TaskPriority::MEDIUM)
+    : pool(pool), priority(priority) {}
+
+  void post(const Key& key, std::function<void()> task) {
+    strandFor(key)->post(std::move(task));
+  }
+
+  template<class F, class... Args>
+  auto enqueue(const Key& key, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type> {
+    return strandFor(key)->enqueue(std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  // 获取key对应的Strand(不存在则创建)
+  std::shared_ptr<Strand> strandFor(const Key& key) {
+    Shard& shard = shards[Hash{}(key) % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& strand = shard.strands[key];
+    if(!strand) {
+      strand = Strand::create(pool, priority);
+    }
+    return strand;
+  }
+
+  // 移除没有待执行任务且没有外部引用的Strand 返回移除数量
+  size_t purgeIdle() {
+    size_t removed = 0;
+    for(auto& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for(auto it = shard.strands.begin(); it != shard.strands.end();) {
+        if(it->second.use_count() == 1 && it->second->pending() == 0) {
+          it = shard.strands.erase(it);
+          ++removed;
+        } else {
+          ++it;
+        }
+      }
+    }
+    return removed;
+  }
+
+  size_t strandCount() {
+    size_t count = 0;
+    for(auto& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      count += shard.strands.size();
+    }
+    return count;
+  }
+
+private:
+  static constexpr size_t kShardCount = 16;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Key, std::shared_ptr<Strand>, Hash> strands;
+  };
+
+  ThreadPool& pool;
+  TaskPriority priority;
+  std::array<Shard, kShardCount> shards;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef TASK_ACCOUNTING_H
+#define TASK_ACCOUNTING_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// 线程资源使用的一个采样点(当前线程)
+struct ThreadUsageSample {
+  uint64_t cpuNs = 0;                 // CLOCK_THREAD_CPUTIME_ID
+  long voluntarySwitches = 0;         // 主动让出CPU(阻塞在I/O、锁、sleep上)
+  long involuntarySwitches = 0;       // 被调度器抢占
+
+  static ThreadUsageSample now();
+};
+
+// 一类任务的累计资源使用
+struct CategoryUsage {
+  std::string category;
+  uint64_t tasks = 0;
+  uint64_t wallNs = 0;
+  uint64_t cpuNs = 0;
+  uint64_t voluntarySwitches = 0;
+  uint64_t involuntarySwitches = 0;
+
+  // CPU时间占墙钟时间的比例 越低说明任务越多时间在阻塞等待
+  double cpuRatio() const { return wallNs == 0 ? 0.0 : static_cast<double>(cpuNs) / static_cast<double>(wallNs); }
+};
+
+// 按任务描述(类别)汇总CPU时间与墙钟时间 默认关闭
+// 每个任务额外付出两次clock_gettime和两次getrusage的开销 所以需要显式启用
+// 描述中的数字串归一化为'#'("batch 17" -> "batch #") 类别数达到上限后新类别计入kOverflowCategory
+// 描述里带编号或ID的任务因此不会让类别(以及导出的标签)无限增长
+class TaskAccounting {
+public:
+  static constexpr size_t kShardCount = 16;
+  static constexpr size_t kDefaultMaxCategories = 64;
+  static constexpr const char* kOverflowCategory = "其他";
+
+  void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+  bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  // 类别数上限(不含溢出类别) 只影响之后出现的新类别
+  void setMaxCategories(size_t limit);
+
+  // 记录一个任务 begin/end是任务执行前后在工作线程上的采样 description按上面的规则映射为类别
+  void record(size_t workerId, const std::string& description, uint64_t wallNs,
+              const ThreadUsageSample& begin, const ThreadUsageSample& end);
+
+  static std::string normalizeCategory(const std::string& description);
+
+  // 所有类别的汇总 按墙钟时间从大到小排序
+  std::vector<CategoryUsage> snapshot() const;
+
+  void reset();
+
+  // 文本报告 每个类别一行
+  std::string getReport() const;
+
+private:
+  // 分片中还没有的类别: 已登记或未达上限时返回自身 否则返回溢出类别
+  const std::string& admit(const std::string& category);
+
+  // 按工作线程分片 同一个工作线程总是写同一个分片 锁基本无竞争
+  struct alignas(64) Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, CategoryUsage> categories;
+  };
+
+  std::atomic<bool> enabled{false};
+  Shard shards[kShardCount];
+
+  std::mutex registryMutex;   // 只在分片里出现新类别时获取
+  std::unordered_set<std::string> knownCategories;
+  size_t maxCategories = kDefaultMaxCategories;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef TASK_ALLOCATOR_H
+#define TASK_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// 任务记录和结果状态的分配策略
+enum class AllocationPolicy {
+  HEAP,     // 全局operator new(默认)
+  POOLED    // 线程本地slab分配器
+};
+
+// 按大小分级的线程本地slab分配器
+// 每个线程持有自己的空闲链表 本线程释放直接放回本地链表
+// 其他线程释放的块通过无锁栈还给所属线程 所属线程在本地链表用尽时一次性取回
+// slab按kSlabSize对齐 释放时由地址即可找到所属线程缓存 块本身不带头部
+class SlabAllocator {
+public:
+  static constexpr size_t kSlabSize = 64 * 1024;
+  static constexpr size_t kMinBlockSize = 16;
+  static constexpr size_t kMaxBlockSize = 1024;
+
+  static void* allocate(size_t size);
+  static void deallocate(void* p, size_t size) noexcept;
+
+  // 统计信息(近似值)
+  static size_t slabCount();
+  static size_t remoteFreeCount();
+};
+
+// 基于SlabAllocator的标准分配器 可用于std::allocate_shared和std::promise
+template<class T>
+struct PoolAllocator {
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+  template<class U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if constexpr(alignof(T) > alignof(std::max_align_t)) {
+      return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    } else {
+      return static_cast<T*>(SlabAllocator::allocate(n * sizeof(T)));
+    }
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if constexpr(alignof(T) > alignof(std::max_align_t)) {
+      ::operator delete(p, std::align_val_t(alignof(T)));
+    } else {
+      SlabAllocator::deallocate(p, n * sizeof(T));
+    }
+  }
+
+  template<class U>
+  bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+  template<class U>
+  bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+#endif
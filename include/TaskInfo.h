@@ -1,9 +1,15 @@
 #ifndef TASK_INFO_H
 #define TASK_INFO_H
 
+#include <any>
 #include <string>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+struct TenantState;
 
 //任务优先级
 enum class TaskPriority {
@@ -13,6 +19,9 @@ enum class TaskPriority {
   CRITICAL
 };
 
+// 优先级数量 按优先级分组的数组使用static_cast<size_t>(priority)作下标
+constexpr size_t kPriorityCount = 4;
+
 
 //任务状态
 enum class TaskStatus {
@@ -40,6 +49,11 @@ struct TaskInfo {
   std::string errorMessage;
   std::chrono::steady_clock::time_point submitTime;
   std::chrono::milliseconds timeout{0}; //任务超时时间(毫秒) 0表示无超时限制
+  uint64_t sequence{0};   //入队序号 入队时在锁内分配 同时作为追踪事件的任务句柄
+  std::function<void()> onTimeout;  //看门狗发现任务运行超过timeout时调用一次 未启用看门狗时为空
+  double fairTag{0.0};    //同一优先级内的虚拟结束时间(租户加权公平排队) 入队时在锁内分配 越小越先执行
+  std::shared_ptr<TenantState> tenant;  //所属租户 为空时属于默认租户
+  std::any sharedResult;  //enqueueShared提交的任务保存结果的shared_future 同ID的重复提交直接共享它
 
   TaskInfo(std::function<void()> t = nullptr,
           TaskPriority p = TaskPriority::MEDIUM,
@@ -49,6 +63,13 @@ struct TaskInfo {
   bool operator<(const TaskInfo& other) const;
 };
 
+// 任务队列中保存任务记录的共享指针 按所指向的任务排序
+struct TaskInfoPtrLess {
+  bool operator()(const std::shared_ptr<TaskInfo>& a, const std::shared_ptr<TaskInfo>& b) const {
+    return *a < *b;
+  }
+};
+
 std::string taskStatusToString(TaskStatus status);
 
 std::string priorityToString(TaskPriority prioruty);
@@ -0,0 +1,95 @@
+#ifndef TASK_TRACER_H
+#define TASK_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "TaskInfo.h"
+
+// 编译期开关: 为0时TP_TRACE展开为空 追踪代码完全不进入热路径
+#ifndef THREADPOOL_ENABLE_TRACING
+#define THREADPOOL_ENABLE_TRACING 1
+#endif
+
+// 任务生命周期事件
+enum class TraceEventType : uint8_t {
+  SUBMIT,
+  DEQUEUE,
+  START,
+  END,
+  CANCEL,
+  TIMEOUT
+};
+
+// 定长二进制事件 32字节
+struct TraceEvent {
+  uint64_t timestampNs;   // steady_clock纳秒
+  uint64_t taskHandle;    // TaskInfo::sequence
+  uint32_t workerId;
+  TraceEventType type;
+  uint8_t priority;
+  uint16_t reserved;
+  uint64_t padding;
+};
+
+// 任务生命周期追踪器
+// 每个工作线程一个环形缓冲区(提交线程等非工作线程共用一个外部环) 写满后覆盖最旧的事件
+// 存储可以是普通内存 也可以是内存映射文件(进程崩溃后仍可用convertMappedFile导出)
+class TaskTracer {
+public:
+  TaskTracer() = default;
+  TaskTracer(const TaskTracer&) = delete;
+  TaskTracer& operator=(const TaskTracer&) = delete;
+  ~TaskTracer();
+
+  // 分配workerRings个工作线程环 + 1个外部环 每个环eventsPerRing个事件(向上取2的幂)
+  // mappedFile非空时存储映射到该文件(先删除旧文件再创建 旧映射不受影响)
+  // 工作线程在record()中不加锁访问存储 可能刚读到旧指针 所以重新配置时旧存储只是退役 保留到析构
+  bool enable(size_t workerRings, size_t eventsPerRing, const std::string& mappedFile = "");
+
+  // 停止记录 已记录的事件保留到下一次enable 存储保留到析构
+  void disable();
+
+  bool isEnabled() const { return enabled.load(std::memory_order_acquire); }
+
+  // 热路径: 一次时钟读取 + 一次无竞争的fetch_add + 一次32字节写入
+  void record(TraceEventType type, size_t workerId, uint64_t taskHandle, TaskPriority priority) noexcept;
+
+  // 导出为Chrome trace JSON(chrome://tracing 或 Perfetto可直接打开)
+  void writeChromeTrace(std::ostream& out) const;
+  bool writeChromeTrace(const std::string& path) const;
+
+  // 把内存映射的追踪文件转换为Chrome trace JSON
+  static bool convertMappedFile(const std::string& binPath, const std::string& jsonPath);
+
+private:
+  struct Storage {
+    void* base;
+    size_t bytes;
+    bool mapped;
+  };
+
+  static void release(const Storage& block);
+
+  std::atomic<bool> enabled{false};
+  std::atomic<void*> storage{nullptr};    // TraceFileHeader + 各个环 先写好再发布
+  size_t storageBytes = 0;
+  bool mapped = false;
+  std::vector<Storage> retired;   // 被重新配置替换的存储 析构时才释放
+};
+
+#if THREADPOOL_ENABLE_TRACING
+#define TP_TRACE(tracer, type, workerId, taskHandle, priority)        \
+  do {                                                                \
+    if((tracer).isEnabled()) {                                        \
+      (tracer).record((type), (workerId), (taskHandle), (priority));  \
+    }                                                                 \
+  } while(0)
+#else
+#define TP_TRACE(tracer, type, workerId, taskHandle, priority) do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef TASK_WATCHDOG_H
+#define TASK_WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TaskInfo.h"
+
+// 看门狗配置
+// 超时和卡住都在扫描时判断 发现时间最多比阈值晚一个扫描间隔
+struct WatchdogOptions {
+  std::chrono::milliseconds scanInterval{100};     // 扫描间隔 也是超时检测的精度
+  std::chrono::milliseconds stuckThreshold{0};     // 全局阈值 0表示只按任务自身的超时判断
+  bool replaceStuckWorkers = false;                // 为卡住的工作线程启动临时替补线程
+};
+
+// 一个卡住的任务
+struct StuckTaskInfo {
+  size_t workerId = 0;
+  uint64_t sequence = 0;
+  std::string taskId;
+  std::string description;
+  TaskPriority priority = TaskPriority::MEDIUM;
+  std::chrono::milliseconds runningFor{0};
+  std::chrono::milliseconds timeout{0};
+  bool replaced = false;      // 是否为它启动了替补线程
+};
+
+// 每个工作线程一个槽位: 当前任务和开始时间
+// 工作线程只做几次无竞争的原子写; 结束任务时与看门狗的读取握手 保证看门狗读任务记录时记录仍然存活
+struct alignas(64) WorkerSlot {
+  std::atomic<TaskInfo*> task{nullptr};
+  std::atomic<int64_t> startNs{0};
+  std::atomic<bool> inspecting{false};
+
+  void begin(TaskInfo* taskInfo, int64_t nowNs) {
+    startNs.store(nowNs, std::memory_order_relaxed);
+    task.store(taskInfo, std::memory_order_release);
+  }
+
+  // 看门狗正在读这个槽位时等它读完 之后任务记录才可以释放
+  void end() {
+    task.store(nullptr, std::memory_order_seq_cst);
+    while(inspecting.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+  }
+};
+
+// 卡住任务看门狗: 一个后台线程周期性扫描所有槽位
+//   任务运行超过自身timeout: 调用任务记录上的onTimeout(设置promise超时异常)
+//   超过timeout或全局阈值: 报告为卡住 回调可以启动替补线程
+//   卡住的任务结束后: 回调通知(退休替补线程)
+class TaskWatchdog {
+public:
+  // 返回true表示为这个任务启动了替补线程
+  using StuckHandler = std::function<bool(const StuckTaskInfo&)>;
+  using RecoveredHandler = std::function<void(const StuckTaskInfo&)>;
+
+  // 预先为workerIds中的工作线程登记槽位
+  explicit TaskWatchdog(std::vector<size_t> workerIds);
+  ~TaskWatchdog();
+
+  TaskWatchdog(const TaskWatchdog&) = delete;
+  TaskWatchdog& operator=(const TaskWatchdog&) = delete;
+
+  size_t slotCount() const { return registeredSlots.load(std::memory_order_acquire); }
+
+  // 工作线程workerId的槽位 还没有时登记一个 下一轮扫描开始检查它
+  // 看门狗启用之后才创建的线程(扩容、预留通道)在第一次执行任务时登记 槽位地址不变 调用者可以缓存
+  WorkerSlot& slotFor(size_t workerId);
+
+  void start(const WatchdogOptions& options, StuckHandler onStuck, RecoveredHandler onRecovered);
+  // 停止扫描 仍被跟踪的卡住任务按结束处理(回调退休替补线程)
+  void stop();
+  bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+  // 当前卡住的任务
+  std::vector<StuckTaskInfo> stuckTasks() const;
+
+  static int64_t nowNs();
+
+private:
+  // 看门狗线程为每个槽位记住的状态
+  struct Tracked {
+    uint64_t sequence = 0;
+    bool timeoutFired = false;
+    bool reported = false;
+    StuckTaskInfo info;
+  };
+
+  void loop();
+  void scan();
+  void release(Tracked& t);
+
+  // 登记的槽位 只增不减 受slotsMutex保护
+  mutable std::mutex slotsMutex;
+  std::vector<std::unique_ptr<WorkerSlot>> slots;
+  std::vector<size_t> workerIds;
+  std::unordered_map<size_t, size_t> slotIndex;
+  std::atomic<size_t> registeredSlots{0};
+
+  // 以下只由看门狗线程访问(stop在线程结束后访问) 登记数变化时从上面复制
+  std::vector<WorkerSlot*> scanSlots;
+  std::vector<size_t> scanWorkerIds;
+  std::vector<Tracked> tracked;
+
+  WatchdogOptions options;
+  StuckHandler onStuck;
+  RecoveredHandler onRecovered;
+
+  std::atomic<bool> running{false};
+  std::thread thread;
+  std::mutex loopMutex;
+  std::condition_variable loopCondition;
+  bool stopRequested = false;
+
+  mutable std::mutex stuckMutex;
+  std::vector<StuckTaskInfo> stuck;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TENANT_SCHEDULER_H
+#define TENANT_SCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+// 一个租户的调度状态和统计 任务记录持有它的共享指针 执行结束时无需查表即可记录延迟
+struct TenantState {
+  explicit TenantState(std::string tenantName) : name(std::move(tenantName)) {}
+
+  const std::string name;
+  std::atomic<double> weight{1.0};
+  // 受线程池的queue_mutex保护
+  double lastTag[kPriorityCount] = {};    // 该租户在各优先级上最后一个任务的虚拟结束时间
+  bool removed = false;                   // 已被remove移出注册表 入队前要重新查找
+  // 以下无锁读取
+  std::atomic<size_t> queued{0};          // 在任务队列中等待的任务数
+  std::atomic<uint64_t> submitted{0};
+  std::atomic<uint64_t> completed{0};
+  LatencyHistogram wait;                  // 提交 -> 开始执行
+  LatencyHistogram endToEnd;              // 提交 -> 执行结束
+};
+
+// 一个租户的统计快照
+struct TenantStats {
+  std::string tenant;
+  double weight = 1.0;
+  size_t queued = 0;
+  uint64_t submitted = 0;
+  uint64_t completed = 0;
+  HistogramSnapshot wait;
+  HistogramSnapshot endToEnd;
+};
+
+// 按租户的加权公平排队(自计时公平排队 SCFQ)
+// 每个任务入队时得到虚拟结束时间 tag = max(当前虚拟时间, 该租户上一个tag) + 1/weight
+// 同一优先级内按tag从小到大执行 出队时虚拟时间推进到该任务的tag
+// 积压大量任务的租户的tag远远领先 新来的租户从当前虚拟时间开始排 不会被饿死
+// 各租户长期得到的执行次数与权重成正比 只有一个租户(或没有租户)时与FIFO相同
+// 没有租户的任务共用一个权重为1的默认租户
+// 每个租户带两个延迟直方图(约28KB) 租户数达到上限后新租户共用kOverflowTenant 不再无限增长
+// 不再使用的租户可以用remove删除
+class TenantScheduler {
+public:
+  static constexpr size_t kDefaultMaxTenants = 256;
+  static constexpr const char* kOverflowTenant = "其他";
+
+  TenantScheduler();
+
+  // 查找或创建租户(权重1) 使用独立的锁 不需要queue_mutex
+  // 租户数已达上限时返回共用的溢出租户 调用者用isOverflow区分
+  std::shared_ptr<TenantState> get(const std::string& tenant);
+  // 持有queue_mutex调用 get之后租户被remove删除时按名字重新查找 否则原样返回
+  std::shared_ptr<TenantState> revalidate(std::shared_ptr<TenantState> state);
+  bool isOverflow(const TenantState& state, const std::string& tenant) const;
+
+  // 租户数上限 已有的租户不受影响
+  void setMaxTenants(size_t limit);
+
+  // 以下持有queue_mutex
+  void setWeight(const std::shared_ptr<TenantState>& tenant, double weight);
+  // 任务进入队列时计算tag tenant为空时使用默认租户
+  double enqueue(TenantState* tenant, TaskPriority priority);
+  // 任务离开队列(执行或因取消被跳过)
+  void dequeue(TenantState* tenant, TaskPriority priority, double tag);
+  // 队列被清空 各租户的排队数和虚拟时间归零
+  void clear();
+  // 删除没有排队任务的租户及其统计 租户不存在或仍有任务排队时返回false
+  // 正在执行的任务持有状态的共享指针 结束时照常记录 之后同名的提交重新创建租户
+  bool remove(const std::string& tenant);
+
+  // 各租户的统计 按租户名排序 不含默认租户
+  std::vector<TenantStats> snapshot() const;
+
+  std::string getReport() const;
+
+private:
+  TenantState defaultTenant;
+  double virtualTime[kPriorityCount] = {};    // 受queue_mutex保护
+
+  mutable std::mutex registryMutex;
+  std::map<std::string, std::shared_ptr<TenantState>> tenants;   // 包括溢出租户 它不计入上限
+  size_t maxTenants = kDefaultMaxTenants;
+};
+
+#endif
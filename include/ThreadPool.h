@@ -13,10 +13,31 @@
 #include <atomic>              // 原子操作，线程安全的变量
 #include <unordered_set>
 #include <unordered_map>
+#include <list>
 
 #include "TaskInfo.h"
 #include "Logger.h"
 #include "ThreadPoolMetrics.h"
+#include "PoolFuture.h"
+#include "TaskAllocator.h"
+#include "TaskTracer.h"
+#include "MetricsExporter.h"
+#include "TaskWatchdog.h"
+#include "WorkerThread.h"
+#include "ThreadScheduling.h"
+#include "RateLimiter.h"
+#include "TenantScheduler.h"
+#include "SharedTaskQueue.h"
+#include "SpillStore.h"
+
+// 工作线程的启动方式
+struct WorkerStartOptions {
+  bool lazyStart = false;   // 构造时不创建线程 有任务提交且没有空闲线程时再逐个创建(不超过线程数)
+  size_t stackSize = 0;     // 工作线程栈大小(字节) 0表示系统默认
+  size_t reservedWorkers = 0;   // 预留通道的线程数 见setReservedWorkers
+  TaskPriority reservedMinPriority = TaskPriority::CRITICAL;
+  SchedulingOptions scheduling;   // 各通道线程的操作系统调度策略和nice值 线程启动时设置
+};
 
 
 class ThreadPool {
@@ -24,6 +45,10 @@ public:
   ThreadPool(size_t threads, LogLevel loglevel = LogLevel::INFO,
             bool consoleLog = true, const std::string& logFile = "");
 
+  // 指定工作线程的启动方式(按需创建、栈大小)
+  ThreadPool(size_t threads, const WorkerStartOptions& startOptions, LogLevel loglevel = LogLevel::INFO,
+            bool consoleLog = true, const std::string& logFile = "");
+
   //禁用拷贝构造函数和赋值操作符
   //一份池子 一份所有权 明令禁止拷贝赋值(内部很多资源不可复制)
   ThreadPool(const ThreadPool&) = delete;
@@ -50,6 +75,36 @@ public:
                       F&& f, Args&&... args)
     -> std::future<typename std::invoke_result<F, Args...>::type>;
 
+  // 提交任务并返回支持then续延的PoolFuture
+  template<class F, class... Args>
+  auto enqueueAsync(TaskPriority priority, F&& f, Args&&... args)
+    -> PoolFuture<typename std::invoke_result<F, Args...>::type>;
+
+  // 单飞提交: taskId已有排队或正在执行的任务时不再提交 返回该任务结果的shared_future
+  // N个并发的同ID提交只执行一次 任务结束(ID从映射表移除)后再提交会重新执行
+  // 已有任务不是用enqueueShared提交的或返回类型不同时 与enqueueWithInfo一样抛出"already exists"
+  // 已取消的同ID任务被新任务替换 taskId为空时抛出std::invalid_argument
+  template<class F, class... Args>
+  auto enqueueShared(std::string taskId, std::string description, TaskPriority priority,
+                     F&& f, Args&&... args)
+    -> std::shared_future<typename std::invoke_result<F, Args...>::type>;
+
+  // 提交属于tenant租户的任务 同一优先级内按租户加权公平排队(见setTenantWeight)
+  // 一个租户积压大量任务时 其他租户的新任务不必排在它的全部积压之后
+  template<class F, class... Args>
+  auto enqueueForTenant(const std::string& tenant, TaskPriority priority, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  // 提交限流类别的任务 类别需要先用setRateLimit创建 否则抛出std::invalid_argument
+  // 类别没有令牌时任务在该类别的侧队列中等待 由限流器的定时线程按速率放入任务队列
+  // 任务描述即类别名(任务统计按类别汇总)
+  template<class F, class... Args>
+  auto enqueueRateLimited(const std::string& category, TaskPriority priority, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+  // 提交不关心结果的任务 不分配promise(续延、strand等内部调度使用)
+  void post(TaskPriority priority, std::function<void()> task);
+
   // 批量提交任务（可选超时参数）
   template<class F>
   std::vector<std::future<void>> enqueueMany(const std::vector<F>& tasks,
@@ -64,6 +119,60 @@ public:
                                                         TaskPriority priority = TaskPriority::MEDIUM,
                                                         std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
 
+  // 令牌桶限流: category类别的任务每秒最多放行tasksPerSecond个 最多积攒burst个令牌(突发)
+  // 类别已存在时修改速率 tasksPerSecond为0时暂停放行
+  void setRateLimit(const std::string& category, double tasksPerSecond, double burst);
+
+  // 删除限流类别 侧队列中等待的任务立即放行 类别不存在时返回false
+  bool removeRateLimit(const std::string& category);
+
+  // 各限流类别的令牌、侧队列深度和限流次数
+  std::vector<RateLimitStats> getRateLimitStats() const;
+
+  // 租户权重(默认1 必须大于0) 同一优先级上长期得到的执行次数与权重成正比
+  // 没有租户的任务共同作为一个权重为1的默认租户参与排队 修改只影响之后入队的任务
+  // 租户数已达上限时不会为新租户单独设置权重 返回false
+  bool setTenantWeight(const std::string& tenant, double weight);
+
+  // 租户数上限(默认256) 达到上限后新租户的任务计入共用的"其他"租户
+  void setMaxTenants(size_t limit);
+
+  // 删除没有排队任务的租户及其统计 释放它的直方图 租户不存在或仍有任务排队时返回false
+  bool removeTenant(const std::string& tenant);
+
+  // 各租户的排队数、完成数和排队时间/端到端延迟直方图
+  std::vector<TenantStats> getTenantStats() const;
+
+  // 跨进程共享内存队列(见SharedTaskQueue)的处理函数 参数和结果都是序列化后的字节串
+  using SharedTaskHandler = SharedQueueConsumer::Handler;
+
+  // 按名字注册处理函数 请求中的处理函数名在执行时查找 可以在attach之后注册或替换
+  // enqueueSpillable提交的可序列化任务同样使用这些处理函数
+  void registerSharedHandler(const std::string& name, SharedTaskHandler handler);
+
+  // 打开名为name的共享内存段并从中拉取任务 本线程池执行中的共享任务最多maxInFlight个(0表示线程数)
+  // 多个进程的线程池可以挂在同一个段上分担负载 一个线程池同时只挂一个段 失败返回false
+  // 完成环一直满(前端不再读取)超过completionTimeout时丢弃该结果并计入threadpool_shared_queue_dropped_total
+  bool attachSharedQueue(const std::string& name, size_t maxInFlight = 0,
+                         std::chrono::milliseconds completionTimeout = std::chrono::seconds(5));
+
+  // 停止拉取 已取得的任务照常执行并写回结果 没有执行就被丢弃的任务(clearTasks、析构)写回失败
+  void detachSharedQueue();
+
+  // 启用溢出到磁盘 目录不可写时返回false
+  // 内存队列中的任务数达到options.maxQueuedTasks后 enqueueSpillable提交的LOW/MEDIUM任务
+  // 序列化写入只追加的内存映射段文件 队列降到阈值一半以下时按FIFO读回(MEDIUM先于LOW)
+  bool enableSpill(const SpillOptions& options = SpillOptions());
+
+  // 提交可序列化的任务: 执行时调用registerSharedHandler注册的处理函数handler(payload) 结果被丢弃
+  // 某个优先级已有任务在磁盘上时 该优先级的新任务也写入磁盘 同一优先级内保持FIFO
+  // 任务描述即处理函数名 处理函数不存在时任务以std::runtime_error失败
+  void enqueueSpillable(const std::string& handler, const std::string& payload,
+                        TaskPriority priority = TaskPriority::MEDIUM);
+
+  // 在段文件中等待的任务数
+  size_t getSpilledTaskCount() const;
+
   // 设置最大线程数
   void setMaxThreads(size_t max);
 
@@ -71,8 +180,19 @@ public:
   size_t getMaxThreads() const;
 
 
-  // 获取工作线程数量
+  // 获取工作线程数量(按需创建模式下为已经创建的线程数) 不含预留通道的线程
   size_t getThreadCount() const;
+
+  // 预留通道: 另外启动count个工作线程 只执行优先级不低于minPriority的任务
+  // 共享工作线程仍按优先级取任务(包括高优先级任务) 谁先空闲谁执行
+  // 高优先级任务的等待不再取决于正在运行的最长低优先级任务 count为0时撤销预留通道
+  void setReservedWorkers(size_t count, TaskPriority minPriority = TaskPriority::CRITICAL);
+
+  size_t getReservedWorkerCount() const;
+
+  // 立即创建尚未创建的工作线程并预先触碰它们的栈 返回时这些线程都已进入等待任务的循环
+  // 用于在延迟敏感的阶段之前消除线程创建和栈缺页的开销
+  void prewarm(size_t stackBytesToTouch = 64 * 1024);
   
   // 获取当前活跃的线程数量
   size_t getActiveThreadCount() const;
@@ -82,6 +202,9 @@ public:
 
     // 获取当前等待任务的线程数量
   size_t getWaitingThreadCount() const;
+
+  // 正在条件变量上等待任务的常规工作线程数(持锁读取) 不含正在启动或正在取任务的线程
+  size_t getIdleThreadCount();
   
   // 获取已完成的任务数量
   size_t getCompletedTaskCount() const;
@@ -105,6 +228,54 @@ public:
   //等待所有任务完成
   void waitForTasks();
 
+  // 帮助等待: future未就绪时调用线程从队列按优先级取任务执行 而不是阻塞在条件变量上
+  // 工作线程(任务内部)和外部线程都可以调用 任务等待同一线程池中的其他任务不会因线程全部阻塞而死锁
+  // Future可以是std::future或std::shared_future
+  // 代为执行的任务嵌套在调用线程的栈上 超过kMaxHelpDepth层后退化为阻塞等待 过深的递归分治仍可能耗尽线程
+  template<class Future>
+  void helpWait(const Future& future);
+
+  // helpWait后取结果
+  template<class R>
+  R helpGet(std::future<R>& future);
+
+  // 帮助执行排队任务直到队列为空且没有正在执行的任务(不计调用线程自身正在执行的任务)
+  void helpWaitForTasks();
+
+  // 取出一个排队任务在调用线程上执行 队列为空、暂停或嵌套过深时返回false
+  bool runPendingTask();
+
+  // 阻塞区: 任务在不可避免的阻塞调用(系统调用、同步IO等)之前进入 离开作用域时结束
+  // 期间线程池把该线程计为阻塞 若有排队任务则启动(或保留)一个临时补偿线程 阻塞结束后补偿线程退休
+  class BlockingScope {
+  public:
+    BlockingScope(BlockingScope&& other) noexcept
+      : pool(other.pool), compensated(other.compensated) {
+      other.pool = nullptr;
+    }
+    BlockingScope(const BlockingScope&) = delete;
+    BlockingScope& operator=(const BlockingScope&) = delete;
+    BlockingScope& operator=(BlockingScope&&) = delete;
+    ~BlockingScope() {
+      if(pool) {
+        pool->endBlocking(compensated);
+      }
+    }
+
+    // 是否为本次阻塞启动或保留了补偿线程
+    bool isCompensated() const { return compensated; }
+
+  private:
+    friend class ThreadPool;
+    BlockingScope(ThreadPool* pool, bool compensated) : pool(pool), compensated(compensated) {}
+
+    ThreadPool* pool;
+    bool compensated;
+  };
+
+  // 在工作线程上调用才会补偿 线程总数(含临时线程)不超过maxThreads
+  BlockingScope blockingScope();
+
   //清空任务队列
   void clearTasks();
 
@@ -118,14 +289,148 @@ public:
   // 获取性能报告
   std::string getMetricsReport() const;
 
+  // 最近window秒(1~60)的提交/完成/失败/超时速率和工作线程利用率
+  WindowedRates getWindowedRates(std::chrono::seconds window) const;
+
+  // 排队时间/执行时间/端到端延迟直方图(按优先级) 自上次resetLatencyHistograms以来
+  LatencySnapshot getLatencySnapshot() const;
+
+  // 自上次调用以来的延迟直方图 供周期性采集使用
+  LatencySnapshot takeLatencyInterval();
+
+  void resetLatencyHistograms();
+
+  // 按任务描述(类别)统计CPU时间、墙钟时间和上下文切换 用于找出阻塞型任务 默认关闭
+  // 描述中的数字归一化为'#' 最多maxCategories个类别 之后的新类别计入"其他"
+  void enableTaskAccounting(bool enable = true, size_t maxCategories = TaskAccounting::kDefaultMaxCategories);
+
+  // 各类别的累计资源使用 按墙钟时间从大到小排序
+  std::vector<CategoryUsage> getTaskCategoryUsage() const;
+
+  std::string getTaskAccountingReport() const;
+
+  void resetTaskAccounting();
+
+  // queue_mutex按加锁位置的竞争统计(THREADPOOL_PROFILE_LOCKS构建)
+  LockSiteReport getLockStats(LockSite site) const;
+  std::string getLockReport() const;
+  void resetLockStats();
+
+  // 机器可读的指标导出 不获取queue_mutex 抓取不会阻塞调度
+  std::string exportOpenMetrics() const;
+  std::string exportMetricsJson() const;
+
+  // 在127.0.0.1:port提供 /metrics 和 /metrics.json port为0时由系统分配
+  bool startMetricsServer(uint16_t port);
+
+  // 在Unix域套接字上提供同样的接口
+  bool startMetricsServerUnix(const std::string& socketPath);
+
+  // 指标服务实际监听的TCP端口 未启动或使用Unix套接字时为0
+  uint16_t getMetricsServerPort() const;
+
+  void stopMetricsServer();
+
+  // 启动卡住任务看门狗: 一个后台线程扫描各工作线程当前的任务 包括启用之后才创建的线程
+  // 启用期间提交的带超时任务直接在工作线程上执行 由看门狗负责超时 不再每个任务占用一个额外线程
+  // 超时在扫描时判断 精度是scanInterval: 任务最多比超时时间晚一个扫描间隔被判定超时
+  bool enableWatchdog(const WatchdogOptions& options = WatchdogOptions());
+
+  void disableWatchdog();
+
+  // 当前运行超过超时时间或全局阈值的任务
+  std::vector<StuckTaskInfo> getStuckTasks() const;
+
+  // 仍在运行的临时线程数(卡住任务的替补线程和阻塞区的补偿线程)
+  size_t getTemporaryWorkerCount();
+
   // 设置日志级别
   void setLogLevel(LogLevel level);
 
+  // 启用异步日志(后台线程写出 缓冲区满时丢弃并计数)
+  void enableAsyncLogging(const AsyncLogOptions& options = AsyncLogOptions());
+
+  // 日志文件按大小轮转
+  void setLogRotation(size_t maxFileSize, size_t maxBackupFiles);
+
+  // 异步日志因缓冲区满丢弃的消息数
+  size_t getDroppedLogCount() const;
+
+  // 启用任务生命周期追踪 每个工作线程一个环(eventsPerWorker个事件) mappedFile非空时映射到文件
+  bool enableTracing(size_t eventsPerWorker = 65536, const std::string& mappedFile = "");
+
+  void disableTracing();
+
+  // 导出追踪记录为Chrome trace JSON
+  bool dumpTrace(const std::string& jsonPath) const;
+
+  // 设置任务记录和promise状态的分配策略(默认HEAP)
+  void setAllocationPolicy(AllocationPolicy policy);
+
+  AllocationPolicy getAllocationPolicy() const;
+
+  // 非工作线程(提交线程、外部调用者)使用的工作线程ID
+  static constexpr size_t kExternalWorkerId = ThreadPoolMetrics::kExternalWorkerId;
+
+  // 临时替补线程的ID从这里开始编号 与常规工作线程的ID不重叠
+  static constexpr size_t kTemporaryWorkerIdBase = ThreadPoolMetrics::kTemporaryWorkerIdBase;
+  static constexpr size_t kMaxTemporaryWorkers = 64;
+
+  // 预留通道线程的ID
+  static constexpr size_t kReservedWorkerIdBase = ThreadPoolMetrics::kReservedWorkerIdBase;
+  static constexpr size_t kMaxReservedWorkers = 64;
+
 private:
+  using TaskQueue = std::priority_queue<std::shared_ptr<TaskInfo>,
+                                        std::vector<std::shared_ptr<TaskInfo>>,
+                                        TaskInfoPtrLess>;
+
+  // 对queue_mutex加锁 并按加锁位置记录竞争统计(编译期关闭时等同于unique_lock)
+  ProfiledLock lockQueue(LockSite site) {
+    return ProfiledLock(queue_mutex, metrics.lockProfile, site);
+  }
+
+  // 按分配策略创建任务记录
+  std::shared_ptr<TaskInfo> makeTaskInfo(std::function<void()> task, TaskPriority priority,
+                                         std::string taskId, std::string description,
+                                         std::chrono::milliseconds timeout);
+
+  // 按分配策略创建promise和PoolFuture共享状态
+  template<class R>
+  std::shared_ptr<std::promise<R>> makePromise();
+
+  template<class R>
+  std::shared_ptr<PoolFutureState<R>> makeFutureState();
+
   //线程工作函数 从任务队列中获取任务并执行任务
   void workerThread(size_t id);
+
+  // 创建ID为id的常规工作线程(持有queue_mutex) prewarmed为true时线程先触碰栈 就绪后通知prewarm
+  void spawnWorker(size_t id, size_t stackBytesToTouch = 0, bool prewarmed = false);
+
+  // 按需创建模式: 排队任务多于空闲线程时补充线程(持有queue_mutex)
+  void spawnOnDemand();
+
+  void updateThreadCount();
   // 工作线程功能
   TaskFetchResult getNextTask(size_t id, std::shared_ptr<TaskInfo>& taskPtr);
+  // 弹出优先级最高的未取消任务(持有queue_mutex) 没有或最高优先级低于minPriority时返回nullptr
+  std::shared_ptr<TaskInfo> popRunnableTask(size_t id, TaskPriority minPriority = TaskPriority::LOW);
+
+  // 预留通道 在queue_mutex内管理
+  static bool isReservedWorker(size_t id) {
+    return id >= kReservedWorkerIdBase && id < kReservedWorkerIdBase + kMaxReservedWorkers;
+  }
+  // 队首是预留通道可以执行的任务(持有queue_mutex)
+  bool hasReservedTask() const {
+    return !tasks.empty() && tasks.top()->priority >= reservedMinPriority;
+  }
+  void reservedWorkerThread(size_t index);
+
+  // 工作线程启动时按所在通道设置调度策略和nice值(在该线程上调用)
+  void applyWorkerScheduling(size_t id);
+  // 按任务优先级调整共享线程的nice值(SchedulingOptions::perTaskNice)
+  void adjustNiceForTask(size_t id, TaskPriority priority);
   void executeTask(size_t id, std::shared_ptr<TaskInfo> taskPtr);
   // void executeTaskWithTimeout(std::shared_ptr<TaskInfo> taskPtr, bool& isTimeout);
 
@@ -141,12 +446,87 @@ private:
       std::chrono::milliseconds timeout,
       F&& f, Args&&... args) -> std::function<void()>;
 
+  // 创建由看门狗负责超时的任务函数 onTimeout输出超时回调
+  template<class F, class... Args>
+  auto createTaskWithWatchdogTimeout(
+      std::shared_ptr<std::promise<typename std::invoke_result<F, Args...>::type>> promise,
+      std::chrono::milliseconds timeout,
+      std::function<void()>& onTimeout,
+      F&& f, Args&&... args) -> std::function<void()>;
+
   // 创建普通任务函数（无超时）
   template<class F, class... Args>
   auto createSimpleTask(
       std::shared_ptr<std::promise<typename std::invoke_result<F, Args...>::type>> promise,
       F&& f, Args&&... args) -> std::function<void()>;
 
+  // 把构造好的任务放入队列(检查ID唯一性、记录日志、更新指标并唤醒工作线程)
+  void pushTask(std::shared_ptr<TaskInfo> taskInfoPtr);
+
+  // 单飞提交 同ID的任务仍在排队或执行时不入队并返回它 否则入队并返回nullptr
+  std::shared_ptr<TaskInfo> pushOrJoinTask(std::shared_ptr<TaskInfo> taskInfoPtr);
+
+  // 入队后需要唤醒的线程
+  struct QueueWakeups {
+    size_t workers = 0;
+    size_t reserved = 0;
+    bool helpers = false;
+  };
+  // 以下两个持有queue_mutex
+  void registerTask(const std::shared_ptr<TaskInfo>& taskInfoPtr);
+  void queueTask(std::shared_ptr<TaskInfo> taskInfoPtr, QueueWakeups& wakeups);
+  void notifyQueued(const QueueWakeups& wakeups);
+
+  // 限流类别的任务 有令牌时直接入队 否则交给限流器
+  void pushRateLimited(const std::string& category, std::shared_ptr<TaskInfo> taskInfoPtr);
+  // 限流器放行的任务放入队列(在限流器的定时线程上调用)
+  void releaseRateLimited(std::vector<std::shared_ptr<TaskInfo>>&& released);
+
+  // 按名字查找共享处理函数 没有时返回空函数
+  SharedTaskHandler findSharedHandler(const std::string& name) const;
+  // 调用共享处理函数的任务(enqueueSpillable使用)
+  std::function<void()> makeHandlerTask(std::string handler, std::string payload);
+  // 内存队列降到溢出阈值一半以下且没有读回在进行时 认领一次读回 持有queue_mutex
+  bool claimSpillReload();
+  // 执行认领的读回 不持有任何锁调用: 只在spillMutex内读段文件(可能缺页读盘)
+  // 任务记录在锁外构造 最后持有queue_mutex拼接进队列
+  void reloadSpilled();
+  // 出队的线程不持有queue_mutex时调用 执行它在popRunnableTask中认领的读回
+  void reloadClaimedSpill();
+  size_t spillBacklogTotal() const;
+  static constexpr size_t kSpillReloadBatch = 256;
+
+  // 看门狗正在运行时 带超时的任务交给看门狗处理
+  bool watchdogEnforcesTimeouts() const {
+    TaskWatchdog* watchdog = watchdogPtr.load(std::memory_order_acquire);
+    return watchdog != nullptr && watchdog->isRunning();
+  }
+
+  // 工作线程在看门狗中的槽位 看门狗从未启用或ID超出范围时为nullptr
+  WorkerSlot* watchdogSlot(size_t id);
+
+  // 临时替补线程 在queue_mutex内管理
+  static bool isTemporaryWorker(size_t id) {
+    return id >= kTemporaryWorkerIdBase && id < kTemporaryWorkerIdBase + kMaxTemporaryWorkers;
+  }
+  bool spawnTemporaryWorker();
+  bool spawnTemporaryWorkerLocked();    // 持有queue_mutex
+  void retireTemporaryWorker();
+  void temporaryWorkerThread(size_t id);
+  void reapTemporaryWorkers(bool all);
+
+  // 阻塞区结束 compensated为true时让一个临时线程退休
+  void endBlocking(bool compensated);
+
+  // 帮助等待没有任务可执行时短暂等待 任务完成或新任务入队时被唤醒
+  // 任务完成的通知不在锁内发出 可能错过 因此最多等待kHelpPollInterval后重新检查
+  void waitForHelpWork();
+  // 调用线程上的任务嵌套层数已达kMaxHelpDepth
+  static bool helpDepthExhausted();
+  static constexpr std::chrono::milliseconds kHelpPollInterval{1};
+  // 帮助等待最多嵌套的任务层数 超过后退化为阻塞等待 防止栈无限增长
+  static constexpr size_t kMaxHelpDepth = 16;
+
   // 处理任务异常并更新状态（新增，用于内部调用）
   void recordTaskFailure(const std::string& errorMessage, bool isTimeout);  
 
@@ -157,20 +537,82 @@ private:
 
   std::unordered_set<size_t> threadsToStop; //需要停止的线程ID
   std::unordered_map<std::string, std::shared_ptr<TaskInfo>> taskIdMap;  //任务映射表
-  std::vector<std::thread> workers; //工作线程容器
-  std::priority_queue<TaskInfo> tasks;  //任务队列
+  std::vector<WorkerThread> workers; //工作线程容器
+  TaskQueue tasks;  //任务队列 保存任务记录本身 与taskIdMap共享同一份记录
 
   //同步机制
-  std::mutex queue_mutex;
+  //queue_mutex每次加锁都会写它所在的缓存行 与只读为主的stop/paused分开放置
+  alignas(kCacheLineSize) std::mutex queue_mutex;
   std::condition_variable condition;
   std::condition_variable waitCondition;
-
-  std::atomic<bool> stop{false};
+  uint64_t nextSequence = 0;  // 入队序号 受queue_mutex保护
+  // 以下受queue_mutex保护
+  size_t targetThreads = 0;     // 构造或resize指定的线程数 按需创建模式下可能大于workers.size()
+  size_t idleWorkers = 0;       // 在getNextTask中等待任务的线程数
+  size_t startingWorkers = 0;   // 已创建但尚未开始取任务的线程数
+  size_t prewarmPending = 0;    // prewarm等待进入等待循环的线程数
+  std::condition_variable prewarmCondition;
+  bool lazyStart = false;
+  size_t workerStackSize = 0;
+  SchedulingOptions scheduling;   // 构造后不再修改
+  std::atomic<size_t> workerCount{0};   // workers.size()的无锁副本
+
+  alignas(kCacheLineSize) std::atomic<bool> stop{false};
   std::atomic<bool> paused{false};
   size_t maxThreads;  // 最大线程数限制
+  std::atomic<AllocationPolicy> allocationPolicy{AllocationPolicy::HEAP};
 
   Logger logger;
   ThreadPoolMetrics metrics;
+  TaskTracer tracer;
+
+  // 按类别的令牌桶限流 指标导出读取它的状态 声明在metricsServer之前
+  RateLimiter rateLimiter;
+  size_t throttledTasks = 0;    // 在限流侧队列中(含定时线程正在放行)的任务数 受queue_mutex保护
+  // 租户公平排队 虚拟时间受queue_mutex保护 统计无锁导出
+  TenantScheduler tenantScheduler;
+
+  // 共享内存队列的处理函数和消费者
+  mutable std::mutex sharedHandlersMutex;
+  std::unordered_map<std::string, SharedTaskHandler> sharedHandlers;
+  std::mutex sharedQueueMutex;
+  std::shared_ptr<SharedQueueConsumer> sharedConsumer;
+
+  // 溢出到磁盘的任务 段文件受spillMutex保护 两把锁嵌套时先spillMutex后queue_mutex
+  std::mutex spillMutex;
+  SpillStore spillStore;
+  // 以下受queue_mutex保护
+  size_t spillThreshold = 0;                    // 内存队列上限 0表示未启用
+  size_t spillBacklog[kPriorityCount] = {};     // 决定写入段文件、还没有读回入队的任务数
+  bool spillReloading = false;                  // 同一时刻只有一个线程读回 保证各优先级内FIFO
+  size_t spillReloadBudget = 0;
+  uint64_t spillGeneration = 0;                 // clearTasks递增(同时持有两把锁) 丢弃清空前读出的任务
+
+  // 指标HTTP服务 按需创建 声明在metrics之后 先于metrics析构
+  mutable std::mutex metricsServerMutex;
+  std::unique_ptr<MetricsHttpServer> metricsServer;
+  // 看门狗第一次启用时创建 之后一直保留到析构(工作线程无锁访问它的槽位)
+  std::mutex watchdogMutex;
+  std::unique_ptr<TaskWatchdog> watchdog;
+  std::atomic<TaskWatchdog*> watchdogPtr{nullptr};
+
+  // 临时替补线程 受queue_mutex保护
+  struct TemporaryWorker {
+    size_t id;
+    WorkerThread thread;
+    bool finished = false;
+  };
+  std::list<TemporaryWorker> temporaryWorkers;
+  bool temporaryIdsInUse[kMaxTemporaryWorkers] = {};
+  size_t liveTemporaryWorkers = 0;
+  size_t temporaryRetireRequests = 0;   // 等待退出的替补线程数 空闲的替补线程认领后退出
+  // 预留通道 受queue_mutex保护 预留线程在单独的条件变量上等待 低优先级任务入队不会唤醒它们
+  std::vector<WorkerThread> reservedWorkers;
+  size_t reservedTarget = 0;    // 下标不小于它的预留线程退出
+  TaskPriority reservedMinPriority = TaskPriority::CRITICAL;
+  std::condition_variable reservedCondition;
+  size_t helpWaiters = 0;   // 在waitForHelpWork中等待的线程数 受queue_mutex保护 非零时入队也唤醒waitCondition
+
   // //计数器
   // std::atomic<size_t> activeThreads{0};
   // std::atomic<size_t> completedTasks{0};
@@ -209,5 +651,6 @@ private:
 // }
 
 #include "ThreadPool.inl"
+#include "PoolFuture.inl"
 
 #endif
\ No newline at end of file
@@ -108,6 +108,81 @@ auto ThreadPool::createTaskWithTimeoutHandling(
   };
 }
 
+// 创建由看门狗负责超时的任务函数 任务在工作线程上直接执行 不再为每个任务另起线程
+// 看门狗发现超时时通过onTimeout设置超时异常 任务结束和超时谁先到谁设置promise
+template<class F, class... Args>
+auto ThreadPool::createTaskWithWatchdogTimeout(
+  std::shared_ptr<std::promise<typename std::invoke_result<F, Args...>::type>> promise,
+  std::chrono::milliseconds timeout,
+  std::function<void()>& onTimeout,
+  F&& f, Args&&... args) -> std::function<void()> {
+
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto settled = std::make_shared<std::atomic<bool>>(false);
+
+  onTimeout = [this, promise, settled, timeout]() {
+    if(settled->exchange(true)) {
+      return;
+    }
+    std::string errorMessage = "Task timed out after " + std::to_string(timeout.count()) + "ms";
+    this->recordTaskFailure(errorMessage, true);
+    promise->set_exception(std::make_exception_ptr(std::runtime_error(errorMessage)));
+  };
+
+  return [this, promise, settled,
+    f = std::forward<F>(f),
+    args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+    try {
+      if constexpr(std::is_void_v<return_type>) {
+        std::apply(f, args);
+        if(!settled->exchange(true)) {
+          promise->set_value();
+        }
+      } else {
+        auto value = std::apply(f, args);
+        if(!settled->exchange(true)) {
+          promise->set_value(std::move(value));
+        }
+      }
+    }
+    catch(const std::exception& e) {
+      //已经按超时处理过 不再重复计数
+      if(settled->exchange(true)) {
+        return;
+      }
+      this->recordTaskFailure(e.what(), false);
+      promise->set_exception(std::current_exception());
+    }
+    catch(...) {
+      if(settled->exchange(true)) {
+        return;
+      }
+      this->recordTaskFailure("未知异常", false);
+      promise->set_exception(std::current_exception());
+    }
+  };
+}
+
+// 按分配策略创建promise POOLED策略下promise对象和它的共享状态都来自slab
+template<class R>
+std::shared_ptr<std::promise<R>> ThreadPool::makePromise() {
+  if(allocationPolicy.load(std::memory_order_relaxed) == AllocationPolicy::POOLED) {
+    PoolAllocator<std::promise<R>> alloc;
+    return std::allocate_shared<std::promise<R>>(alloc, std::allocator_arg, alloc);
+  }
+  return std::make_shared<std::promise<R>>();
+}
+
+// 按分配策略创建PoolFuture共享状态
+template<class R>
+std::shared_ptr<PoolFutureState<R>> ThreadPool::makeFutureState() {
+  if(allocationPolicy.load(std::memory_order_relaxed) == AllocationPolicy::POOLED) {
+    return std::allocate_shared<PoolFutureState<R>>(PoolAllocator<PoolFutureState<R>>());
+  }
+  return std::make_shared<PoolFutureState<R>>();
+}
+
 // 带优先级的任务提交
 template<class F, class... Args>
 auto ThreadPool::enqueueWithPriority(TaskPriority priority, std::chrono::milliseconds timeout, 
@@ -127,12 +202,16 @@ auto ThreadPool::enqueueWithInfo(std::string taskId, std::string description,
   using return_type = typename std::invoke_result<F, Args...>::type;
 
   //在锁之外创建promise
-  auto promise = std::make_shared<std::promise<return_type>>();
+  auto promise = makePromise<return_type>();
   std::future<return_type> result = promise->get_future();
   
   std::function<void()> taskFunction;
+  std::function<void()> timeoutHandler;
 
-  if(timeout.count() > 0) {
+  if(timeout.count() > 0 && watchdogEnforcesTimeouts()) {
+    taskFunction = createTaskWithWatchdogTimeout(promise, timeout, timeoutHandler,
+                                                std::forward<F>(f), std::forward<Args>(args)...);
+  } else if(timeout.count() > 0) {
     taskFunction = createTaskWithTimeoutHandling(promise, timeout, std::forward<F>(f),
                                                 std::forward<Args>(args)...);
   } else {
@@ -140,43 +219,130 @@ auto ThreadPool::enqueueWithInfo(std::string taskId, std::string description,
   }
   
 
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+  auto taskInfo = makeTaskInfo(
+    std::move(taskFunction),
+    priority,
+    std::move(taskId),
+    std::move(description),
+    timeout
+  );
+  taskInfo->onTimeout = std::move(timeoutHandler);
+  pushTask(std::move(taskInfo));
+  return result;
+}
 
-    if(stop) {
-      throw std::runtime_error("enqueue on stopped ThreadPool");
-    }
+// 单飞提交 合并时新建的任务记录直接丢弃 不会执行
+template<class F, class... Args>
+auto ThreadPool::enqueueShared(std::string taskId, std::string description, TaskPriority priority,
+  F&& f, Args&&... args)
+  -> std::shared_future<typename std::invoke_result<F, Args...>::type> {
 
-    //检查任务ID是否存在 任务是否唯一(可以通过map设置某些任务唯一)
-    if(!taskId.empty() && taskIdMap.find(taskId) != taskIdMap.end()) {
-      throw std::runtime_error("Task ID " + taskId + " already exists");
-    }
-    
-    //记录任务提交日志
-    logTaskSubmission(taskId, description, priority);
-
-    auto taskInfoPtr = std::make_shared<TaskInfo>(
-      std::move(taskFunction),
-      priority,
-      taskId,
-      description,
-      timeout
-    );
-    //把唯一任务的共享指针添加到map里面
-    if(!taskId.empty()) {
-      taskIdMap[taskId] = taskInfoPtr;
-    }
-    tasks.push(*taskInfoPtr);
+  using return_type = typename std::invoke_result<F, Args...>::type;
 
-    //更新性能指标
-    metrics.totalTasks++;
-    metrics.updateQueueSize(tasks.size());
+  if(taskId.empty()) {
+    throw std::invalid_argument("enqueueShared requires a task ID");
+  }
+
+  auto promise = makePromise<return_type>();
+  std::shared_future<return_type> result = promise->get_future().share();
+
+  auto taskInfo = makeTaskInfo(
+    createSimpleTask(promise, std::forward<F>(f), std::forward<Args>(args)...),
+    priority,
+    std::move(taskId),
+    std::move(description),
+    std::chrono::milliseconds(0)
+  );
+  taskInfo->sharedResult = result;
 
+  //sharedResult在入队前设置 之后不再修改 可以在锁外读取
+  std::shared_ptr<TaskInfo> existing = pushOrJoinTask(std::move(taskInfo));
+  if(!existing) {
+    return result;
   }
-  condition.notify_one();
+  if(const auto* joined = std::any_cast<std::shared_future<return_type>>(&existing->sharedResult)) {
+    metrics.coalescedTasks.fetch_add(1, std::memory_order_relaxed);
+    return *joined;
+  }
+  throw std::runtime_error("Task ID " + existing->taskId + " already exists");
+}
+
+// 提交属于某个租户的任务
+template<class F, class... Args>
+auto ThreadPool::enqueueForTenant(const std::string& tenant, TaskPriority priority, F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto promise = makePromise<return_type>();
+  std::future<return_type> result = promise->get_future();
+
+  auto taskInfo = makeTaskInfo(
+    createSimpleTask(promise, std::forward<F>(f), std::forward<Args>(args)...),
+    priority,
+    "",
+    "",
+    std::chrono::milliseconds(0)
+  );
+  taskInfo->tenant = tenantScheduler.get(tenant);
+  pushTask(std::move(taskInfo));
+  return result;
+}
+
+// 提交限流类别的任务
+template<class F, class... Args>
+auto ThreadPool::enqueueRateLimited(const std::string& category, TaskPriority priority, F&& f, Args&&... args)
+  -> std::future<typename std::invoke_result<F, Args...>::type> {
+
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto promise = makePromise<return_type>();
+  std::future<return_type> result = promise->get_future();
+
+  auto taskInfo = makeTaskInfo(
+    createSimpleTask(promise, std::forward<F>(f), std::forward<Args>(args)...),
+    priority,
+    "",
+    category,
+    std::chrono::milliseconds(0)
+  );
+  pushRateLimited(category, std::move(taskInfo));
   return result;
 }
 
+// 提交任务并返回支持then续延的PoolFuture
+template<class F, class... Args>
+auto ThreadPool::enqueueAsync(TaskPriority priority, F&& f, Args&&... args)
+  -> PoolFuture<typename std::invoke_result<F, Args...>::type> {
+
+  using return_type = typename std::invoke_result<F, Args...>::type;
+
+  auto state = makeFutureState<return_type>();
+
+  //任务没有执行就被丢弃时 promise析构让future以broken_promise失败
+  post(priority, [this, promise = PoolPromise<return_type>(state), f = std::forward<F>(f),
+    args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+    try {
+      if constexpr(std::is_void_v<return_type>) {
+        std::apply(f, args);
+        promise->setValue();
+      } else {
+        promise->setValue(std::apply(f, args));
+      }
+    }
+    catch(const std::exception& e) {
+      this->recordTaskFailure(e.what(), false);
+      promise->setException(std::current_exception());
+    }
+    catch(...) {
+      this->recordTaskFailure("未知异常", false);
+      promise->setException(std::current_exception());
+    }
+  });
+
+  return PoolFuture<return_type>(std::move(state), this);
+}
+
 // 批量提交任务（可选超时参数）
 template<class F>
 std::vector<std::future<void>> ThreadPool::enqueueMany(const std::vector<F>& tasks,
@@ -211,5 +377,25 @@ std::vector<std::future<void>> ThreadPool::enqueueManyWithIdPrefix(const std::st
   return futures;  // 返回future集合，允许调用者等待任务完成
 }
 
+// 目标未就绪就执行排队任务 队列暂时为空时等待任务完成或新任务入队
+template<class Future>
+void ThreadPool::helpWait(const Future& future) {
+  while(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    if(runPendingTask()) {
+      continue;
+    }
+    if(helpDepthExhausted() || stop) {
+      future.wait();
+      return;
+    }
+    waitForHelpWork();
+  }
+}
+
+template<class R>
+R ThreadPool::helpGet(std::future<R>& future) {
+  helpWait(future);
+  return future.get();
+}
 
 #endif
\ No newline at end of file
@@ -1,33 +1,228 @@
 #ifndef THREAD_POOL_METRICS_H
 #define THREAD_POOL_METRICS_H
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <mutex>
 #include <string>
 
-// 线程池性能指标
-struct ThreadPoolMetrics {
-  std::atomic<size_t> totalTasks{ 0 };           // 总任务数
+#include "LatencyHistogram.h"
+#include "TaskAccounting.h"
+#include "LockProfiler.h"
+
+constexpr size_t kCacheLineSize = 64;
+
+class RateLimiter;
+class TenantScheduler;
+
+// 滑动窗口统计的计数项
+enum RateCounter {
+  RATE_SUBMITTED,
+  RATE_COMPLETED,
+  RATE_FAILED,
+  RATE_TIMEOUT,
+  RATE_BUSY_NS,       // 工作线程执行任务的时间(纳秒)
+  RATE_RESERVED_BUSY_NS,  // 其中预留通道工作线程的部分
+  kRateCounterCount
+};
+
+// 每秒一个桶的环形窗口 保留最近64秒
+// 写入时若桶里是旧的秒数就先清零再累加 清零与并发写之间可能丢失极少量计数 对速率统计可以接受
+struct RateWindow {
+  static constexpr size_t kBucketCount = 64;
+  static constexpr int64_t kMaxWindowSeconds = 60;
+
+  struct Bucket {
+    std::atomic<int64_t> second{ -1 };
+    std::atomic<uint64_t> values[kRateCounterCount] = {};
+  };
+
+  Bucket buckets[kBucketCount];
+
+  void add(int64_t second, RateCounter counter, uint64_t value) {
+    Bucket& bucket = buckets[static_cast<uint64_t>(second) % kBucketCount];
+    int64_t stamp = bucket.second.load(std::memory_order_acquire);
+    if(stamp != second) {
+      if(stamp < second && bucket.second.compare_exchange_strong(stamp, second, std::memory_order_acq_rel)) {
+        for(auto& v : bucket.values) v.store(0, std::memory_order_relaxed);
+      } else if(stamp > second) {
+        return;   //调用者读到的时钟比桶里的还旧 这一秒已经被回收
+      }
+    }
+    bucket.values[counter].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // 把[beginNs, endNs)这段时间按它跨越的每一秒分摊 超出窗口的部分不再记录
+  void addSpan(RateCounter counter, int64_t beginNs, int64_t endNs) {
+    int64_t endSecond = endNs / 1000000000;
+    beginNs = std::max(beginNs, (endSecond - kMaxWindowSeconds) * 1000000000);
+    for(int64_t second = beginNs / 1000000000; second <= endSecond && beginNs < endNs; ++second) {
+      int64_t secondEnd = std::min(endNs, (second + 1) * 1000000000);
+      add(second, counter, static_cast<uint64_t>(secondEnd - beginNs));
+      beginNs = secondEnd;
+    }
+  }
+
+  // 读取某一秒的计数 桶已被其他秒占用时返回0
+  uint64_t get(int64_t second, RateCounter counter) const {
+    const Bucket& bucket = buckets[static_cast<uint64_t>(second) % kBucketCount];
+    if(bucket.second.load(std::memory_order_acquire) != second) return 0;
+    return bucket.values[counter].load(std::memory_order_relaxed);
+  }
+};
+
+// 粗粒度单调时钟(纳秒) 精度为几毫秒 但比steady_clock便宜得多 用于滑动窗口分桶
+int64_t coarseMonotonicNs();
+
+// 最近一段时间内的速率
+struct WindowedRates {
+  double submittedPerSec = 0.0;
+  double completedPerSec = 0.0;
+  double failedPerSec = 0.0;
+  double timeoutPerSec = 0.0;
+  double utilization = 0.0;     // 共享通道工作线程忙碌时间 / (窗口长度 * 线程数) 取值[0, 1]
+  double reservedUtilization = 0.0;   // 预留通道(只执行高优先级任务的工作线程)的利用率
+};
+
+// 单个分片的热计数器 独占一条缓存行
+// 每个工作线程只写自己的分片 读取时汇总 避免所有核心争抢同一条缓存行
+struct alignas(kCacheLineSize) MetricsShard {
+  std::atomic<size_t> totalTasks{ 0 };           // 提交任务数
   std::atomic<size_t> completedTasks{ 0 };       // 已完成任务数
   std::atomic<size_t> failedTasks{ 0 };          // 失败任务数
-  std::atomic<size_t> activeThreads{ 0 };        // 活跃线程数
-  std::atomic<size_t> peakThreads{ 0 };          // 峰值线程数
-  std::atomic<size_t> peakQueueSize{ 0 };        // 峰值队列大小
-  std::atomic<size_t> timeOutTasks{ 0 };
+  std::atomic<size_t> timeOutTasks{ 0 };         // 超时任务数
+  std::atomic<uint64_t> totalTaskTimeNs{ 0 };    // 任务执行时间（纳秒）
+  RateWindow window;                             // 最近64秒的每秒计数
+  // 正在执行的任务数和开始时间(coarseMonotonicNs)之和 [0]全部任务 [1]其中预留通道的任务
+  // 任务结束前的忙碌时间在getWindowedRates时按开始时间计入
+  std::atomic<uint32_t> running[2] = {};
+  std::atomic<int64_t> runningSinceNs[2] = {};
+};
+
+// 线程池性能指标
+struct ThreadPoolMetrics {
+  // 工作线程按ID和所属通道选择分片 非工作线程按线程ID哈希
+  static constexpr size_t kShardCount = 64;
+  static constexpr size_t kExternalWorkerId = static_cast<size_t>(-1);
+  // 预留通道线程和临时替补线程的ID起点 与常规工作线程的ID不重叠
+  static constexpr size_t kReservedWorkerIdBase = static_cast<size_t>(1) << 19;
+  static constexpr size_t kTemporaryWorkerIdBase = static_cast<size_t>(1) << 20;
+
+  MetricsShard shards[kShardCount];
+
+  // 全局量各占一条缓存行
+  // 活跃线程数有意不分片: threadStarted要用加一之后的全局值更新峰值 分片后每次开始任务都要读所有分片
+  // 把各工作线程刚写过的缓存行拉过来 比一次原子加更贵; waitForTasks等在queue_mutex内把它与队列一起判断
+  // 每个任务出队本来就要拿一次queue_mutex 这条缓存行在每个任务的开始和结束各多一次原子操作
+  alignas(kCacheLineSize) std::atomic<size_t> activeThreads{ 0 };   // 活跃线程数
+  alignas(kCacheLineSize) std::atomic<size_t> peakThreads{ 0 };     // 峰值线程数
+  alignas(kCacheLineSize) std::atomic<size_t> peakQueueSize{ 0 };   // 峰值队列大小
+  // 当前队列长度和工作线程数 在queue_mutex内更新 导出指标时无锁读取
+  alignas(kCacheLineSize) std::atomic<size_t> queueSize{ 0 };
+  std::atomic<size_t> threadCount{ 0 };
+  // 看门狗统计 只由看门狗线程写入
+  std::atomic<size_t> stuckTasks{ 0 };            // 累计发现的卡住任务数
+  std::atomic<size_t> currentStuckTasks{ 0 };     // 当前仍在运行的卡住任务数
+  std::atomic<size_t> replacementWorkers{ 0 };    // 累计启动的替补线程数
+  // 等待中的线程(helpWait/helpWaitForTasks)代为执行的任务数
+  std::atomic<size_t> helpedTasks{ 0 };
+  // enqueueShared因同ID任务已在排队或执行而合并的提交数
+  std::atomic<size_t> coalescedTasks{ 0 };
+  // 从共享内存队列取得的任务数
+  std::atomic<size_t> sharedQueueTasks{ 0 };
+  std::atomic<size_t> sharedQueueDropped{ 0 };    // 完成环一直满而丢弃的结果数
+  // 溢出到磁盘 在queue_mutex内更新
+  std::atomic<size_t> spilledTasks{ 0 };          // 当前在段文件中等待的任务数
+  std::atomic<uint64_t> spilledBytes{ 0 };        // 累计写入段文件的字节数
+  std::atomic<uint64_t> reloadedBytes{ 0 };       // 累计从段文件读回的字节数
+  // 阻塞区统计(blockingScope)
+  std::atomic<size_t> blockedThreads{ 0 };        // 当前处于阻塞区的任务数
+  std::atomic<size_t> compensatingWorkers{ 0 };   // 累计为阻塞区启动或保留的补偿线程数
+  // 预留通道 threadCount不包含预留线程
+  std::atomic<size_t> reservedThreads{ 0 };
+  std::atomic<size_t> reservedTasks{ 0 };         // 预留线程执行的任务数
+  std::atomic<size_t> schedulingErrors{ 0 };      // 设置调度策略或nice值失败的次数(通常是权限不足)
   std::chrono::steady_clock::time_point startTime;  // 线程池启动时间
-  std::atomic<uint64_t> totalTaskTimeNs{ 0 };    // 总任务执行时间（纳秒）
+
+  // 延迟直方图分片 第一次记录时分配(每个约110KB) 没有执行过任务的分片不占内存
+  std::atomic<LatencyShard*> latencyShards[kShardCount] = {};
+  mutable std::mutex latencyMutex;     // 保护下面两个基线
+  LatencySnapshot resetBaseline;       // resetLatency时的累计值
+  LatencySnapshot intervalBaseline;    // 上一次takeLatencyInterval时的累计值
+
+  // 按任务类别的CPU时间/墙钟时间统计 默认关闭
+  TaskAccounting accounting;
+
+  // 线程池的限流器 构造线程池时设置 导出各限流类别的侧队列深度和限流次数
+  const RateLimiter* rateLimiter = nullptr;
+  // 线程池的租户调度器 导出各租户的排队数和延迟
+  const TenantScheduler* tenants = nullptr;
+
+  // queue_mutex按加锁位置的等待/持有时间 只在THREADPOOL_PROFILE_LOCKS构建中有数据
+  LockProfile lockProfile;
 
   // 构造函数
   ThreadPoolMetrics();
+  ~ThreadPoolMetrics();
+
+  ThreadPoolMetrics(const ThreadPoolMetrics&) = delete;
+  ThreadPoolMetrics& operator=(const ThreadPoolMetrics&) = delete;
+
+  // 选择当前线程写入的分片
+  static size_t shardIndex(size_t workerId);
+  MetricsShard& shardFor(size_t workerId);
+
+  // 热路径计数 累计值和当前秒的窗口桶各做一次无竞争的原子加
+  void addSubmitted(size_t workerId) { add(workerId, &MetricsShard::totalTasks, RATE_SUBMITTED, 1); }
+  void addCompleted(size_t workerId) { add(workerId, &MetricsShard::completedTasks, RATE_COMPLETED, 1); }
+  void addFailed(size_t workerId) { add(workerId, &MetricsShard::failedTasks, RATE_FAILED, 1); }
+  void addTimeout(size_t workerId) { add(workerId, &MetricsShard::timeOutTasks, RATE_TIMEOUT, 1); }
+
+  // 任务开始执行 返回值交给addTaskTime 执行期间的忙碌时间在读取窗口速率时按秒计入
+  // reserved: 预留通道的任务 同时计入通道的忙碌时间
+  int64_t taskBegan(size_t workerId, bool reserved = false);
+
+  // 添加任务执行时间 窗口内按任务跨越的每一秒分摊忙碌时间(长任务不会全部落在结束的那一秒)
+  // beganNs为taskBegan的返回值 没有调用taskBegan时传kNotBegan
+  static constexpr int64_t kNotBegan = -1;
+  void addTaskTime(size_t workerId, uint64_t timeNs, int64_t beganNs = kNotBegan, bool reserved = false);
+
+  // 最近window秒(1~60)的速率和利用率 无锁读取
+  WindowedRates getWindowedRates(std::chrono::seconds window) const;
+
+  // 记录一个任务的排队时间和执行时间(端到端 = 两者之和) 由执行任务的工作线程调用
+  void recordLatency(size_t workerId, TaskPriority priority, uint64_t waitNs, uint64_t executionNs);
+
+  // 自上次resetLatency以来的延迟分布
+  LatencySnapshot getLatencySnapshot() const;
+
+  // 自上次takeLatencyInterval以来的延迟分布 用于周期性采集
+  LatencySnapshot takeLatencyInterval();
+
+  // 清零getLatencySnapshot的起点 不影响写者
+  void resetLatency();
+
+  // 启动以来的累计延迟分布(不受resetLatency影响) 供单调递增的导出格式使用
+  LatencySnapshot getLatencyTotals() const;
+
+  // 汇总各分片
+  size_t getTotalTasks() const;
+  size_t getCompletedTasks() const;
+  size_t getFailedTasks() const;
+  size_t getTimeoutTasks() const;
+  uint64_t getTotalTaskTimeNs() const;
 
   // 更新队列大小并记录峰值
   void updateQueueSize(size_t size);
 
-  // 更新活跃线程数并记录峰值
-  void updateActiveThreads(size_t count);
+  void setThreadCount(size_t count) { threadCount.store(count, std::memory_order_relaxed); }
 
-  // 添加任务执行时间
-  void addTaskTime(uint64_t timeNs);
+  // 活跃线程数加一并记录峰值
+  void threadStarted();
+
+  // 活跃线程数减一
+  void threadFinished();
 
   // 获取平均任务执行时间（毫秒）
   double getAverageTaskTime() const;
@@ -40,6 +235,14 @@ struct ThreadPoolMetrics {
 
   // 获取性能报告
   std::string getReport() const;
+
+private:
+  template<class T>
+  void add(size_t workerId, std::atomic<T> MetricsShard::*total, RateCounter counter, uint64_t value) {
+    MetricsShard& shard = shardFor(workerId);
+    (shard.*total).fetch_add(value, std::memory_order_relaxed);
+    shard.window.add(coarseMonotonicNs() / 1000000000, counter, value);
+  }
 };
 
-#endif // THREAD_POOL_METRICS_H
\ No newline at end of file
+#endif // THREAD_POOL_METRICS_H
@@ -0,0 +1,44 @@
+#ifndef THREAD_SCHEDULING_H
+#define THREAD_SCHEDULING_H
+
+#include <sched.h>
+
+#include "TaskInfo.h"
+
+// 一组工作线程的操作系统调度参数
+// SCHED_OTHER/SCHED_BATCH/SCHED_IDLE使用niceValue SCHED_FIFO/SCHED_RR使用realtimePriority(1~99)
+// 降低nice值或使用实时策略需要CAP_SYS_NICE(或足够的RLIMIT_NICE/RLIMIT_RTPRIO) 失败时线程保持原样
+struct SchedulingTier {
+  int policy = SCHED_OTHER;
+  int niceValue = 0;
+  int realtimePriority = 0;
+
+  bool isRealtime() const { return policy == SCHED_FIFO || policy == SCHED_RR; }
+  bool isDefault() const { return policy == SCHED_OTHER && niceValue == 0; }
+};
+
+// 工作线程按通道分成两个调度层级 在线程启动时设置
+struct SchedulingOptions {
+  SchedulingTier shared;      // 共享工作线程和临时线程
+  SchedulingTier reserved;    // 预留通道线程(只执行高优先级任务)
+
+  // 共享线程执行每个任务前按任务优先级调整自己的nice值(实时策略的线程不调整)
+  // 值相同时不做系统调用 调回更小的nice值需要CAP_SYS_NICE或足够的RLIMIT_NICE
+  // 线程池构造时检查 无法调回taskNice中的最小值时关闭(否则低优先级任务之后的高优先级任务会一直以高nice值运行)
+  bool perTaskNice = false;
+  int taskNice[kPriorityCount] = {10, 5, 0, 0};   // LOW, MEDIUM, HIGH, CRITICAL
+};
+
+// 把调用线程设置为tier指定的调度策略和nice值 失败返回false(errno保留)
+bool applySchedulingTier(const SchedulingTier& tier);
+
+// 调用线程的nice值
+int getCurrentThreadNice();
+bool setCurrentThreadNice(int niceValue);
+
+// 调用线程能否把nice值从更大的值调回niceValue(CAP_SYS_NICE 或 RLIMIT_NICE >= 20 - niceValue)
+bool canLowerNiceTo(int niceValue);
+
+const char* schedulingPolicyName(int policy);
+
+#endif
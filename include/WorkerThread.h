@@ -0,0 +1,39 @@
+#ifndef WORKER_THREAD_H
+#define WORKER_THREAD_H
+
+#include <cstddef>
+#include <functional>
+#include <pthread.h>
+
+// 可以指定栈大小的工作线程 接口与std::thread一致(join/joinable 析构时仍可join则终止程序)
+// std::thread无法设置栈大小 这里直接使用pthread
+class WorkerThread {
+public:
+  WorkerThread() = default;
+
+  // stackSize为0时使用系统默认栈大小 否则向上取整到页大小且不小于PTHREAD_STACK_MIN
+  // 创建失败抛出std::system_error
+  WorkerThread(std::function<void()> body, size_t stackSize);
+
+  WorkerThread(WorkerThread&& other) noexcept;
+  WorkerThread& operator=(WorkerThread&& other) noexcept;
+
+  WorkerThread(const WorkerThread&) = delete;
+  WorkerThread& operator=(const WorkerThread&) = delete;
+
+  ~WorkerThread();
+
+  bool joinable() const { return started; }
+  void join();
+
+  // 预先触碰当前线程栈上的bytes字节 让缺页发生在延迟敏感阶段之前
+  static void prefaultStack(size_t bytes);
+
+private:
+  static void* trampoline(void* arg);
+
+  pthread_t handle{};
+  bool started = false;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+
+size_t LatencyBuckets::indexOf(uint64_t valueNs) {
+  if(valueNs < kLinearLimit) return static_cast<size_t>(valueNs);
+  if(valueNs > kMaxTrackableNs) valueNs = kMaxTrackableNs;
+
+  //最高位决定区间 紧随其后的kSubBucketBits位决定子桶
+  unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(valueNs));
+  unsigned shift = msb - kSubBucketBits;
+  uint64_t sub = (valueNs >> shift) - kSubBucketCount;
+  return static_cast<size_t>(kLinearLimit + (shift - 1) * kSubBucketCount + sub);
+}
+
+uint64_t LatencyBuckets::lowerBound(size_t index) {
+  if(index < kLinearLimit) return index;
+  uint64_t offset = index - kLinearLimit;
+  unsigned shift = static_cast<unsigned>(offset / kSubBucketCount) + 1;
+  uint64_t sub = offset % kSubBucketCount + kSubBucketCount;
+  return sub << shift;
+}
+
+uint64_t LatencyBuckets::upperBound(size_t index) {
+  if(index < kLinearLimit) return index;
+  if(index + 1 >= kBucketCount) return kMaxTrackableNs;
+  return lowerBound(index + 1) - 1;
+}
+
+
+double HistogramSnapshot::mean() const {
+  if(totalCount == 0) return 0.0;
+  return static_cast<double>(totalSum) / static_cast<double>(totalCount);
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+  if(totalCount == 0) return 0;
+  if(p < 0.0) p = 0.0;
+  if(p > 100.0) p = 100.0;
+
+  //第rank个样本(从1开始)所在的桶
+  uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(totalCount)));
+  if(rank == 0) rank = 1;
+
+  uint64_t seen = 0;
+  for(size_t i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if(seen >= rank) return LatencyBuckets::upperBound(i);
+  }
+  return LatencyBuckets::kMaxTrackableNs;
+}
+
+uint64_t HistogramSnapshot::min() const {
+  for(size_t i = 0; i < counts.size(); ++i) {
+    if(counts[i] != 0) return LatencyBuckets::lowerBound(i);
+  }
+  return 0;
+}
+
+uint64_t HistogramSnapshot::max() const {
+  for(size_t i = counts.size(); i > 0; --i) {
+    if(counts[i - 1] != 0) return LatencyBuckets::upperBound(i - 1);
+  }
+  return 0;
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) {
+  for(size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+  totalCount += other.totalCount;
+  totalSum += other.totalSum;
+}
+
+// 用于计算区间增量 other必须是同一直方图更早的快照
+void HistogramSnapshot::subtract(const HistogramSnapshot& other) {
+  for(size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = counts[i] >= other.counts[i] ? counts[i] - other.counts[i] : 0;
+  }
+  totalCount = totalCount >= other.totalCount ? totalCount - other.totalCount : 0;
+  totalSum = totalSum >= other.totalSum ? totalSum - other.totalSum : 0;
+}
+
+
+void LatencyHistogram::addTo(HistogramSnapshot& snapshot) const {
+  //读取期间写者可能继续写入 各桶之间不是同一时刻的值 对监控来说足够
+  for(size_t i = 0; i < LatencyBuckets::kBucketCount; ++i) {
+    uint64_t c = counts[i].load(std::memory_order_relaxed);
+    snapshot.counts[i] += c;
+    snapshot.totalCount += c;
+  }
+  snapshot.totalSum += totalSum.load(std::memory_order_relaxed);
+}
+
+
+HistogramSnapshot LatencySnapshot::merged(LatencyKind kind) const {
+  HistogramSnapshot result;
+  for(const auto& histogram : histograms[static_cast<size_t>(kind)]) result.merge(histogram);
+  return result;
+}
+
+void LatencySnapshot::subtract(const LatencySnapshot& other) {
+  for(size_t k = 0; k < kLatencyKindCount; ++k) {
+    for(size_t p = 0; p < kPriorityCount; ++p) histograms[k][p].subtract(other.histograms[k][p]);
+  }
+}
@@ -0,0 +1,87 @@
+#include "LockProfiler.h"
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+void updateMax(std::atomic<uint64_t>& target, uint64_t value) {
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while(value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+const char* lockSiteName(LockSite site) {
+  switch(site) {
+    case LockSite::ENQUEUE:         return "enqueue";
+    case LockSite::GET_NEXT_TASK:   return "getNextTask";
+    case LockSite::CLEANUP_TASK:    return "cleanupTask";
+    case LockSite::GET_TASK_STATUS: return "getTaskStatus";
+    case LockSite::CANCEL_TASK:     return "cancelTask";
+    case LockSite::WAIT_FOR_TASKS:  return "waitForTasks";
+    case LockSite::HELP_WAIT:       return "helpWait";
+    case LockSite::OTHER:           return "other";
+    default:                        return "unknown";
+  }
+}
+
+void LockProfile::recordAcquire(LockSite site, bool wasContended, uint64_t waitNs) {
+  LockSiteStats& stats = sites[static_cast<size_t>(site)];
+  stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if(wasContended) {
+    stats.contended.fetch_add(1, std::memory_order_relaxed);
+    stats.waitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    updateMax(stats.maxWaitNs, waitNs);
+  }
+}
+
+void LockProfile::recordHold(LockSite site, uint64_t holdNs) {
+  LockSiteStats& stats = sites[static_cast<size_t>(site)];
+  stats.holdNs.fetch_add(holdNs, std::memory_order_relaxed);
+  updateMax(stats.maxHoldNs, holdNs);
+}
+
+LockSiteReport LockProfile::get(LockSite site) const {
+  const LockSiteStats& stats = sites[static_cast<size_t>(site)];
+  return LockSiteReport{
+    site,
+    stats.acquisitions.load(std::memory_order_relaxed),
+    stats.contended.load(std::memory_order_relaxed),
+    stats.waitNs.load(std::memory_order_relaxed),
+    stats.holdNs.load(std::memory_order_relaxed),
+    stats.maxWaitNs.load(std::memory_order_relaxed),
+    stats.maxHoldNs.load(std::memory_order_relaxed)
+  };
+}
+
+void LockProfile::reset() {
+  for(LockSiteStats& stats : sites) {
+    stats.acquisitions.store(0, std::memory_order_relaxed);
+    stats.contended.store(0, std::memory_order_relaxed);
+    stats.waitNs.store(0, std::memory_order_relaxed);
+    stats.holdNs.store(0, std::memory_order_relaxed);
+    stats.maxWaitNs.store(0, std::memory_order_relaxed);
+    stats.maxHoldNs.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::string LockProfile::getReport() const {
+  std::stringstream ss;
+  if(!kLockProfilingEnabled) {
+    ss << "锁统计未编译(使用 -DTHREADPOOL_PROFILE_LOCKS=ON 重新构建)" << std::endl;
+    return ss.str();
+  }
+  ss << "queue_mutex 锁统计:" << std::endl;
+  ss << std::fixed << std::setprecision(2);
+  for(size_t i = 0; i < kLockSiteCount; ++i) {
+    LockSiteReport r = get(static_cast<LockSite>(i));
+    if(r.acquisitions == 0) continue;
+    double contendedPct = 100.0 * static_cast<double>(r.contended) / static_cast<double>(r.acquisitions);
+    ss << "  " << std::left << std::setw(14) << lockSiteName(r.site) << std::right
+       << " 加锁 " << r.acquisitions << " 次, 竞争 " << r.contended << " 次 (" << contendedPct << "%)"
+       << ", 等待 " << r.waitNs / 1e6 << " 毫秒 (最长 " << r.maxWaitNs / 1e3 << " 微秒)"
+       << ", 持有 " << r.holdNs / 1e6 << " 毫秒 (最长 " << r.maxHoldNs / 1e3 << " 微秒)" << std::endl;
+  }
+  return ss.str();
+}
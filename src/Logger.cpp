@@ -1,75 +1,393 @@
 #include "Logger.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <chrono>
+#include <cstring>
+#include <ctime>
 
+namespace {
 
-Logger::Logger(LogLevel level, bool consoleOutput, const std::string& logFile) 
-  : level(level)
-  , consoleOutput(consoleOutput)
-  , logFile(logFile) {}
+std::atomic<uint64_t> nextLoggerId{1};
 
-// 写日志
-void Logger::log(LogLevel msgLevel, const std::string& message) {
-  if(level == LogLevel::NONE || msgLevel > level) return;
+// 每个线程在各个Logger上的环形缓冲区 线程退出时标记为retired 由后台线程写完后回收
+struct ThreadRingCache {
+  std::vector<std::pair<uint64_t, std::shared_ptr<void>>> entries;
+  std::vector<std::atomic<bool>*> retiredFlags;
 
-  std::lock_guard<std::mutex> lock(mutex);
-  auto now = std::chrono::system_clock::now();
-  auto now_time_t = std::chrono::system_clock::to_time_t(now);
+  ~ThreadRingCache() {
+    for(auto* flag : retiredFlags) {
+      flag->store(true, std::memory_order_release);
+    }
+  }
+};
 
-  //把time_t格式的时间转换成带格式的字符串
-  //把 time_t 转换成 本地时间（struct tm* 类型，里边有年、月、日、小时、分钟、秒）
-  std::stringstream timestamp;
-  timestamp << std::put_time(std::localtime(&now_time_t), "%Y-%m-%d, %H:%M:%S");
+thread_local ThreadRingCache threadRings;
 
-  std::string levelStr;
-  switch(msgLevel) {
-    case LogLevel::ERROR: levelStr = "错误"; break;
-    case LogLevel::INFO:  levelStr = "信息"; break;
-    case LogLevel::DEBUG: levelStr = "调试"; break;
-    default: levelStr = "位置";
+const char* levelToString(LogLevel level) {
+  switch(level) {
+    case LogLevel::ERROR: return "错误";
+    case LogLevel::WARN:  return "警告";
+    case LogLevel::INFO:  return "信息";
+    case LogLevel::DEBUG: return "调试";
+    default:              return "未知";
   }
+}
 
-  std::stringstream logMsg;
-  logMsg << "[" << timestamp.str() << "] [" << levelStr << "]" << message;
+size_t roundUpPowerOfTwo(size_t n) {
+  size_t p = 1;
+  while(p < n) p <<= 1;
+  return p;
+}
 
-  if(consoleOutput) {
-    if(msgLevel == LogLevel::ERROR) {
-      std::cerr << logMsg.str() << std::endl;
-    } else {
-      std::cout << logMsg.str() << std::endl;
+}  // namespace
+
+
+Logger::LogRing::LogRing(size_t capacity)
+  : records(roundUpPowerOfTwo(capacity == 0 ? 1 : capacity))
+  , mask(records.size() - 1) {}
+
+// 缓冲区满时丢弃消息 生产者永远不等待
+bool Logger::LogRing::push(LogLevel msgLevel, int64_t timestampNs, const std::string& message) {
+  size_t h = head.load(std::memory_order_relaxed);
+  if(h - tail.load(std::memory_order_acquire) >= records.size()) {
+    dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  LogRecord& record = records[h & mask];
+  size_t length = message.size();
+  if(length > LogRecord::kMaxText) {
+    length = LogRecord::kMaxText;
+    //不要把多字节字符截断在中间
+    while(length > 0 && (static_cast<unsigned char>(message[length]) & 0xC0) == 0x80) {
+      --length;
     }
   }
-  if(!logFile.empty()) {
-    try {
-      std::ofstream file(logFile, std::ios::app);
-      if(file.is_open()) {
-        file << logMsg.str() << std::endl;
-      }
-    } catch(...) {
-      if(consoleOutput) {
-        std::cerr << "无法写入日志文件" << logFile << std::endl;
-      }
+  record.timestampNs = timestampNs;
+  record.level = msgLevel;
+  record.length = static_cast<uint16_t>(length);
+  std::memcpy(record.text, message.data(), length);
+
+  head.store(h + 1, std::memory_order_release);
+  return true;
+}
+
+
+Logger::Logger(LogLevel level, bool consoleOutput, const std::string& logFile)
+  : level(level)
+  , consoleOutput(consoleOutput)
+  , logFile(logFile)
+  , loggerId(nextLoggerId.fetch_add(1)) {
+  std::lock_guard<std::mutex> lock(mutex);
+  openLogFile();
+}
+
+Logger::~Logger() {
+  disableAsync();
+  std::lock_guard<std::mutex> lock(mutex);
+  closeLogFile();
+}
+
+// 写日志
+void Logger::log(LogLevel msgLevel, const std::string& message) {
+  LogLevel current = level.load(std::memory_order_relaxed);
+  if(current == LogLevel::NONE || msgLevel > current) return;
+
+  int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+
+  if(asyncEnabled.load(std::memory_order_acquire)) {
+    LogRing* ring = localRing();
+    //先声明正在写入再复查开关 与disableAsync先关开关再等待写入结束配对
+    //两边都是seq_cst: 要么这里看到开关已关走同步路径 要么disableAsync等到这条记录写进缓冲区
+    ring->writing.store(true, std::memory_order_seq_cst);
+    if(asyncEnabled.load(std::memory_order_seq_cst)) {
+      ring->push(msgLevel, timestampNs, message);
+      ring->writing.store(false, std::memory_order_release);
+      return;
     }
+    ring->writing.store(false, std::memory_order_relaxed);
   }
 
+  std::lock_guard<std::mutex> lock(mutex);
+  writeLine(msgLevel, timestampNs, message.data(), message.size());
+  //同步模式逐行刷出 保证进程崩溃时日志不丢
+  if(consoleOutput) {
+    (msgLevel == LogLevel::ERROR ? std::cerr : std::cout).flush();
+  }
+  if(fileHandle != nullptr) {
+    std::fflush(fileHandle);
+  }
 }
 
 // 设置日志级别
 void Logger::setLevel(LogLevel newLevel) {
-  level = newLevel;
+  level.store(newLevel, std::memory_order_relaxed);
 }
 
 // 设置日志文件
 void Logger::setLogFile(const std::string& filename) {
   std::lock_guard<std::mutex> lock(mutex);
+  closeLogFile();
   logFile = filename;
+  openLogFile();
 }
 
 // 启用/禁用控制台输出
 void Logger::setConsoleOutput(bool enable) {
   std::lock_guard<std::mutex> lock(mutex);
   consoleOutput = enable;
-}
\ No newline at end of file
+}
+
+void Logger::setRotation(size_t maxSize, size_t maxBackups) {
+  std::lock_guard<std::mutex> lock(mutex);
+  maxFileSize = maxSize;
+  maxBackupFiles = maxBackups;
+}
+
+void Logger::enableAsync(const AsyncLogOptions& options) {
+  std::lock_guard<std::mutex> lock(backgroundMutex);
+  if(asyncEnabled.load()) return;
+
+  asyncOptions = options;
+  backgroundStop = false;
+  backgroundThread = std::thread([this]() { backgroundLoop(); });
+  asyncEnabled.store(true, std::memory_order_release);
+}
+
+void Logger::disableAsync() {
+  {
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    if(!asyncEnabled.load()) return;
+    asyncEnabled.store(false, std::memory_order_seq_cst);
+    backgroundStop = true;
+  }
+  //等待关闭开关之前已经开始写缓冲区的生产者 之后登记的缓冲区在ringsMutex之后复查开关 必然看到已关闭
+  std::vector<std::shared_ptr<LogRing>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    snapshot = rings;
+  }
+  for(auto& ring : snapshot) {
+    while(ring->writing.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+  }
+  backgroundCondition.notify_all();
+  if(backgroundThread.joinable()) {
+    backgroundThread.join();
+  }
+  //后台线程退出前已写完 这里再处理它最后一轮之后写入的记录
+  drainRings();
+  std::lock_guard<std::mutex> lock(mutex);
+  if(fileHandle != nullptr) {
+    std::fflush(fileHandle);
+  }
+}
+
+size_t Logger::getDroppedCount() const {
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  size_t total = retiredDropped.load(std::memory_order_relaxed);
+  for(const auto& ring : rings) {
+    total += ring->dropped.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+void Logger::flush() {
+  if(!asyncEnabled.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout.flush();
+    if(fileHandle != nullptr) {
+      std::fflush(fileHandle);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(backgroundMutex);
+  uint64_t target = ++flushRequests;
+  backgroundCondition.notify_all();
+  flushedCondition.wait(lock, [this, target]() {
+    return flushesDone >= target || !asyncEnabled.load();
+  });
+}
+
+// 找到当前线程在本Logger上的缓冲区 第一次写日志时创建并登记
+Logger::LogRing* Logger::localRing() {
+  for(auto& entry : threadRings.entries) {
+    if(entry.first == loggerId) {
+      return static_cast<LogRing*>(entry.second.get());
+    }
+  }
+
+  //顺便清理已经销毁的Logger留下的缓冲区(只剩本线程持有)
+  for(size_t i = 0; i < threadRings.entries.size();) {
+    if(threadRings.entries[i].second.use_count() == 1) {
+      threadRings.entries.erase(threadRings.entries.begin() + i);
+      threadRings.retiredFlags.erase(threadRings.retiredFlags.begin() + i);
+    } else {
+      ++i;
+    }
+  }
+
+  auto ring = std::make_shared<LogRing>(asyncOptions.ringCapacity);
+  {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.push_back(ring);
+  }
+  threadRings.entries.emplace_back(loggerId, ring);
+  threadRings.retiredFlags.push_back(&ring->retired);
+  return ring.get();
+}
+
+void Logger::backgroundLoop() {
+  while(true) {
+    uint64_t requested;
+    bool stopping;
+    {
+      std::lock_guard<std::mutex> lock(backgroundMutex);
+      requested = flushRequests;
+      stopping = backgroundStop;
+    }
+
+    if(drainRings() > 0) {
+      continue;
+    }
+
+    //缓冲区已空 把缓冲的输出刷出去
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(consoleOutput) {
+        std::cout.flush();
+      }
+      if(fileHandle != nullptr) {
+        std::fflush(fileHandle);
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(backgroundMutex);
+    flushesDone = requested;
+    flushedCondition.notify_all();
+    if(stopping) {
+      break;
+    }
+    backgroundCondition.wait_for(lock, asyncOptions.flushInterval, [this]() {
+      return backgroundStop || flushRequests != flushesDone;
+    });
+  }
+}
+
+// 把所有缓冲区中的记录写出 返回写出的条数
+size_t Logger::drainRings() {
+  std::vector<std::shared_ptr<LogRing>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    snapshot = rings;
+  }
+
+  size_t written = 0;
+  bool hasRetired = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto& ring : snapshot) {
+      size_t t = ring->tail.load(std::memory_order_relaxed);
+      size_t h = ring->head.load(std::memory_order_acquire);
+      for(; t != h; ++t) {
+        const LogRecord& record = ring->records[t & ring->mask];
+        writeLine(record.level, record.timestampNs, record.text, record.length);
+        ++written;
+      }
+      ring->tail.store(t, std::memory_order_release);
+      hasRetired = hasRetired || ring->retired.load(std::memory_order_acquire);
+    }
+  }
+
+  //线程已退出且已写完的缓冲区可以移除
+  if(hasRetired) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for(size_t i = 0; i < rings.size();) {
+      LogRing& ring = *rings[i];
+      if(ring.retired.load(std::memory_order_acquire) &&
+         ring.head.load(std::memory_order_acquire) == ring.tail.load(std::memory_order_relaxed)) {
+        retiredDropped.fetch_add(ring.dropped.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        rings.erase(rings.begin() + i);
+      } else {
+        ++i;
+      }
+    }
+  }
+  return written;
+}
+
+void Logger::writeLine(LogLevel msgLevel, int64_t timestampNs, const char* text, size_t length) {
+  //把time_t格式的时间转换成带格式的字符串 同一秒内复用缓存
+  int64_t second = timestampNs / 1000000000;
+  if(second != cachedSecond) {
+    std::time_t t = static_cast<std::time_t>(second);
+    std::tm tmBuf;
+    localtime_r(&t, &tmBuf);
+    std::strftime(cachedTimestamp, sizeof(cachedTimestamp), "%Y-%m-%d, %H:%M:%S", &tmBuf);
+    cachedSecond = second;
+  }
+
+  std::string line;
+  line.reserve(length + 48);
+  line += "[";
+  line += cachedTimestamp;
+  line += "] [";
+  line += levelToString(msgLevel);
+  line += "]";
+  line.append(text, length);
+  line += '\n';
+
+  if(consoleOutput) {
+    (msgLevel == LogLevel::ERROR ? std::cerr : std::cout).write(line.data(), line.size());
+  }
+  if(fileHandle != nullptr) {
+    rotateIfNeeded(line.size());
+    if(fileHandle != nullptr) {
+      std::fwrite(line.data(), 1, line.size(), fileHandle);
+      fileSize += line.size();
+    }
+  }
+}
+
+void Logger::openLogFile() {
+  if(logFile.empty()) return;
+
+  fileHandle = std::fopen(logFile.c_str(), "a");
+  if(fileHandle == nullptr) {
+    if(consoleOutput) {
+      std::cerr << "无法写入日志文件" << logFile << std::endl;
+    }
+    return;
+  }
+  //全缓冲 由同步模式逐行刷出或后台线程批量刷出
+  std::setvbuf(fileHandle, nullptr, _IOFBF, 64 * 1024);
+  std::fseek(fileHandle, 0, SEEK_END);
+  long pos = std::ftell(fileHandle);
+  fileSize = pos > 0 ? static_cast<size_t>(pos) : 0;
+}
+
+void Logger::closeLogFile() {
+  if(fileHandle != nullptr) {
+    std::fclose(fileHandle);
+    fileHandle = nullptr;
+  }
+  fileSize = 0;
+}
+
+// 写入前检查大小 超限则 file.(n-1) -> file.n, ..., file -> file.1
+void Logger::rotateIfNeeded(size_t incoming) {
+  if(maxFileSize == 0 || fileSize == 0 || fileSize + incoming <= maxFileSize) return;
+
+  closeLogFile();
+  if(maxBackupFiles == 0) {
+    std::remove(logFile.c_str());
+  } else {
+    for(size_t i = maxBackupFiles; i >= 1; --i) {
+      std::string from = i == 1 ? logFile : logFile + "." + std::to_string(i - 1);
+      std::string to = logFile + "." + std::to_string(i);
+      std::rename(from.c_str(), to.c_str());
+    }
+  }
+  openLogFile();
+}
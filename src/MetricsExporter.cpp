@@ -0,0 +1,656 @@
+#include "MetricsExporter.h"
+#include "RateLimiter.h"
+#include "TenantScheduler.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char* kKindNames[kLatencyKindCount] = {"wait", "execution", "end_to_end"};
+const char* kPriorityLabels[kPriorityCount] = {"low", "medium", "high", "critical"};
+
+// 导出的直方图桶边界(纳秒) HDR分桶在读取时折算到这些边界上
+const uint64_t kBucketBoundsNs[] = {
+  1000, 5000, 10000, 50000, 100000, 500000,
+  1000000, 5000000, 10000000, 50000000, 100000000, 500000000,
+  1000000000, 5000000000ull, 10000000000ull
+};
+
+// 导出的滑动窗口长度(秒)
+const int64_t kWindowSeconds[] = {1, 10, 60};
+constexpr size_t kWindowCount = sizeof(kWindowSeconds) / sizeof(kWindowSeconds[0]);
+
+// 纳秒计数按秒输出 整数运算写出精确的十进制 不经过double
+// 累计时间很大时double的默认6位有效数字会把计数器的增量抹掉(rate()读到0)
+struct Seconds {
+  uint64_t ns;
+};
+
+std::ostream& operator<<(std::ostream& out, Seconds value) {
+  out << value.ns / 1000000000;
+  uint64_t fraction = value.ns % 1000000000;
+  if(fraction != 0) {
+    char digits[10];
+    int width = 9;
+    while(fraction % 10 == 0) {
+      fraction /= 10;
+      --width;
+    }
+    std::snprintf(digits, sizeof(digits), "%0*llu", width, static_cast<unsigned long long>(fraction));
+    out << "." << digits;
+  }
+  return out;
+}
+
+Seconds toSeconds(uint64_t ns) {
+  return Seconds{ns};
+}
+
+// 其余浮点值(速率、利用率、权重等)按能够无损读回的位数输出
+void useRoundTripPrecision(std::ostream& out) {
+  out << std::setprecision(std::numeric_limits<double>::max_digits10);
+}
+
+void writeCounter(std::ostream& out, const char* name, const char* help, uint64_t value) {
+  out << "# TYPE " << name << " counter\n";
+  out << "# HELP " << name << " " << help << "\n";
+  out << name << "_total " << value << "\n";
+}
+
+template<class T>
+void writeGauge(std::ostream& out, const char* name, const char* help, T value) {
+  out << "# TYPE " << name << " gauge\n";
+  out << "# HELP " << name << " " << help << "\n";
+  out << name << " " << value << "\n";
+}
+
+// 一个HDR桶只要上界不超过导出边界就计入该边界 由于HDR桶很细 偏差不超过1/32
+// 一条直方图序列 label是不含le的标签(如priority="HIGH") 桶是累计计数
+void writeHistogramSeries(std::ostream& out, const std::string& name, const std::string& label,
+                          const HistogramSnapshot& histogram) {
+  const auto& counts = histogram.bucketCounts();
+  size_t bucket = 0;
+  uint64_t cumulative = 0;
+  for(uint64_t bound : kBucketBoundsNs) {
+    while(bucket < counts.size() && LatencyBuckets::upperBound(bucket) <= bound) {
+      cumulative += counts[bucket++];
+    }
+    out << name << "_bucket{" << label << ",le=\"" << toSeconds(bound) << "\"} " << cumulative << "\n";
+  }
+  out << name << "_bucket{" << label << ",le=\"+Inf\"} " << histogram.count() << "\n";
+  out << name << "_sum{" << label << "} " << toSeconds(histogram.sum()) << "\n";
+  out << name << "_count{" << label << "} " << histogram.count() << "\n";
+}
+
+void writeHistogram(std::ostream& out, const LatencySnapshot& totals, size_t kind) {
+  std::string name = std::string("threadpool_task_") + kKindNames[kind] + "_seconds";
+  out << "# TYPE " << name << " histogram\n";
+  out << "# HELP " << name << " Task " << kKindNames[kind] << " latency by priority.\n";
+
+  for(size_t p = 0; p < kPriorityCount; ++p) {
+    writeHistogramSeries(out, name, std::string("priority=\"") + kPriorityLabels[p] + "\"",
+                         totals.histograms[kind][p]);
+  }
+}
+
+// 1s/10s/60s滑动窗口速率 每个指标一个gauge族 用window标签区分窗口
+void writeWindowedRates(std::ostream& out, const ThreadPoolMetrics& metrics) {
+  WindowedRates rates[kWindowCount];
+  for(size_t w = 0; w < kWindowCount; ++w) {
+    rates[w] = metrics.getWindowedRates(std::chrono::seconds(kWindowSeconds[w]));
+  }
+
+  struct Field {
+    const char* name;
+    const char* help;
+    double WindowedRates::*value;
+  };
+  const Field fields[] = {
+    {"threadpool_submitted_rate", "Tasks submitted per second over the window.", &WindowedRates::submittedPerSec},
+    {"threadpool_completed_rate", "Tasks completed per second over the window.", &WindowedRates::completedPerSec},
+    {"threadpool_failed_rate", "Tasks failed per second over the window.", &WindowedRates::failedPerSec},
+    {"threadpool_timeout_rate", "Tasks timed out per second over the window.", &WindowedRates::timeoutPerSec},
+    {"threadpool_utilization", "Fraction of worker time spent executing tasks over the window.", &WindowedRates::utilization},
+    {"threadpool_reserved_utilization", "Utilization of the reserved high-priority lane over the window.",
+     &WindowedRates::reservedUtilization},
+  };
+  for(const Field& field : fields) {
+    out << "# TYPE " << field.name << " gauge\n";
+    out << "# HELP " << field.name << " " << field.help << "\n";
+    for(size_t w = 0; w < kWindowCount; ++w) {
+      out << field.name << "{window=\"" << kWindowSeconds[w] << "s\"} " << rates[w].*field.value << "\n";
+    }
+  }
+}
+
+// 标签值转义: 反斜杠、双引号和换行
+std::string escapeLabel(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for(char c : value) {
+    if(c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if(c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// JSON字符串转义: 反斜杠、双引号 以及所有小于0x20的控制字符(\uXXXX) 非ASCII的UTF-8字节原样输出
+std::string escapeJson(const std::string& value) {
+  static const char kHex[] = "0123456789abcdef";
+  std::string escaped;
+  escaped.reserve(value.size());
+  for(char c : value) {
+    auto byte = static_cast<unsigned char>(c);
+    if(c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if(byte < 0x20) {
+      escaped += "\\u00";
+      escaped += kHex[byte >> 4];
+      escaped += kHex[byte & 0xf];
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// 按任务类别的资源使用 只在启用了任务统计时输出
+void writeCategoryUsage(std::ostream& out, const std::vector<CategoryUsage>& usage) {
+  struct Field {
+    const char* name;
+    const char* help;
+    bool seconds;
+    uint64_t CategoryUsage::*value;
+  };
+  const Field fields[] = {
+    {"threadpool_category_tasks", "Tasks executed per category.", false, &CategoryUsage::tasks},
+    {"threadpool_category_wall_seconds", "Wall time spent executing tasks per category.", true, &CategoryUsage::wallNs},
+    {"threadpool_category_cpu_seconds", "Thread CPU time spent executing tasks per category.", true, &CategoryUsage::cpuNs},
+    {"threadpool_category_voluntary_switches", "Voluntary context switches during tasks per category.", false, &CategoryUsage::voluntarySwitches},
+    {"threadpool_category_involuntary_switches", "Involuntary context switches during tasks per category.", false, &CategoryUsage::involuntarySwitches},
+  };
+  for(const Field& field : fields) {
+    out << "# TYPE " << field.name << " counter\n";
+    out << "# HELP " << field.name << " " << field.help << "\n";
+    for(const CategoryUsage& category : usage) {
+      out << field.name << "_total{category=\"" << escapeLabel(category.category) << "\"} ";
+      if(field.seconds) {
+        out << toSeconds(category.*field.value);
+      } else {
+        out << category.*field.value;
+      }
+      out << "\n";
+    }
+  }
+}
+
+// 限流类别 侧队列深度是gauge 放行和限流次数是counter
+void writeRateLimits(std::ostream& out, const std::vector<RateLimitStats>& limits) {
+  out << "# TYPE threadpool_rate_limit_queued gauge\n";
+  out << "# HELP threadpool_rate_limit_queued Tasks waiting for a token per rate-limited category.\n";
+  for(const RateLimitStats& stats : limits) {
+    out << "threadpool_rate_limit_queued{category=\"" << escapeLabel(stats.category) << "\"} "
+        << stats.queued << "\n";
+  }
+  struct Field {
+    const char* name;
+    const char* help;
+    uint64_t RateLimitStats::*value;
+  };
+  const Field fields[] = {
+    {"threadpool_rate_limit_admitted", "Tasks released to the queue per rate-limited category.", &RateLimitStats::admitted},
+    {"threadpool_rate_limit_throttled", "Tasks that had to wait for a token per rate-limited category.", &RateLimitStats::throttled},
+  };
+  for(const Field& field : fields) {
+    out << "# TYPE " << field.name << " counter\n";
+    out << "# HELP " << field.name << " " << field.help << "\n";
+    for(const RateLimitStats& stats : limits) {
+      out << field.name << "_total{category=\"" << escapeLabel(stats.category) << "\"} "
+          << stats.*field.value << "\n";
+    }
+  }
+}
+
+// 各租户的排队数、提交/完成数和延迟直方图
+void writeTenants(std::ostream& out, const std::vector<TenantStats>& tenants) {
+  out << "# TYPE threadpool_tenant_queued gauge\n";
+  out << "# HELP threadpool_tenant_queued Tasks waiting in the queue per tenant.\n";
+  for(const TenantStats& stats : tenants) {
+    out << "threadpool_tenant_queued{tenant=\"" << escapeLabel(stats.tenant) << "\"} " << stats.queued << "\n";
+  }
+  out << "# TYPE threadpool_tenant_weight gauge\n";
+  out << "# HELP threadpool_tenant_weight Fair queuing weight per tenant.\n";
+  for(const TenantStats& stats : tenants) {
+    out << "threadpool_tenant_weight{tenant=\"" << escapeLabel(stats.tenant) << "\"} " << stats.weight << "\n";
+  }
+  struct Counter {
+    const char* name;
+    const char* help;
+    uint64_t TenantStats::*value;
+  };
+  const Counter counters[] = {
+    {"threadpool_tenant_submitted", "Tasks submitted per tenant.", &TenantStats::submitted},
+    {"threadpool_tenant_completed", "Tasks executed per tenant.", &TenantStats::completed},
+  };
+  for(const Counter& counter : counters) {
+    out << "# TYPE " << counter.name << " counter\n";
+    out << "# HELP " << counter.name << " " << counter.help << "\n";
+    for(const TenantStats& stats : tenants) {
+      out << counter.name << "_total{tenant=\"" << escapeLabel(stats.tenant) << "\"} "
+          << stats.*counter.value << "\n";
+    }
+  }
+  struct Histogram {
+    const char* name;
+    const char* help;
+    HistogramSnapshot TenantStats::*value;
+  };
+  const Histogram histograms[] = {
+    {"threadpool_tenant_wait_seconds", "Task wait latency per tenant.", &TenantStats::wait},
+    {"threadpool_tenant_end_to_end_seconds", "Task end-to-end latency per tenant.", &TenantStats::endToEnd},
+  };
+  for(const Histogram& histogram : histograms) {
+    out << "# TYPE " << histogram.name << " histogram\n";
+    out << "# HELP " << histogram.name << " " << histogram.help << "\n";
+    for(const TenantStats& stats : tenants) {
+      writeHistogramSeries(out, histogram.name, "tenant=\"" + escapeLabel(stats.tenant) + "\"",
+                           stats.*histogram.value);
+    }
+  }
+}
+
+// queue_mutex按加锁位置的统计 只在锁统计编译进来时输出
+void writeLockStats(std::ostream& out, const LockProfile& profile) {
+  struct Field {
+    const char* name;
+    const char* help;
+    bool seconds;
+    uint64_t LockSiteReport::*value;
+  };
+  const Field fields[] = {
+    {"threadpool_lock_acquisitions", "queue_mutex acquisitions per call site.", false, &LockSiteReport::acquisitions},
+    {"threadpool_lock_contended", "queue_mutex acquisitions that had to wait.", false, &LockSiteReport::contended},
+    {"threadpool_lock_wait_seconds", "Time spent waiting for queue_mutex.", true, &LockSiteReport::waitNs},
+    {"threadpool_lock_hold_seconds", "Time queue_mutex was held.", true, &LockSiteReport::holdNs},
+  };
+  for(const Field& field : fields) {
+    out << "# TYPE " << field.name << " counter\n";
+    out << "# HELP " << field.name << " " << field.help << "\n";
+    for(size_t i = 0; i < kLockSiteCount; ++i) {
+      LockSiteReport report = profile.get(static_cast<LockSite>(i));
+      out << field.name << "_total{site=\"" << lockSiteName(report.site) << "\"} ";
+      if(field.seconds) {
+        out << toSeconds(report.*field.value);
+      } else {
+        out << report.*field.value;
+      }
+      out << "\n";
+    }
+  }
+}
+
+void writeFully(int fd, const std::string& data) {
+  size_t sent = 0;
+  while(sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if(n < 0 && errno == EINTR) continue;
+    if(n <= 0) return;
+    sent += static_cast<size_t>(n);
+  }
+}
+
+}  // namespace
+
+
+std::string formatOpenMetrics(const ThreadPoolMetrics& metrics) {
+  std::ostringstream out;
+  useRoundTripPrecision(out);
+  writeCounter(out, "threadpool_tasks_submitted", "Tasks submitted to the pool.", metrics.getTotalTasks());
+  writeCounter(out, "threadpool_tasks_completed", "Tasks that finished successfully.", metrics.getCompletedTasks());
+  writeCounter(out, "threadpool_tasks_failed", "Tasks that threw an exception.", metrics.getFailedTasks());
+  writeCounter(out, "threadpool_tasks_timeout", "Tasks that exceeded their timeout.", metrics.getTimeoutTasks());
+  writeCounter(out, "threadpool_tasks_helped", "Tasks run by threads waiting in a helping wait.",
+               metrics.helpedTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_tasks_coalesced", "Submissions that joined an in-flight task with the same ID.",
+               metrics.coalescedTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_shared_queue_tasks", "Tasks pulled from a cross-process shared memory queue.",
+               metrics.sharedQueueTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_shared_queue_dropped", "Shared queue results dropped because the completion ring stayed full.",
+               metrics.sharedQueueDropped.load(std::memory_order_relaxed));
+
+  out << "# TYPE threadpool_task_time_seconds counter\n";
+  out << "# HELP threadpool_task_time_seconds Accumulated task execution time.\n";
+  out << "threadpool_task_time_seconds_total " << toSeconds(metrics.getTotalTaskTimeNs()) << "\n";
+
+  writeGauge(out, "threadpool_threads", "Worker threads.",
+             metrics.threadCount.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_active_threads", "Workers currently executing a task.",
+             metrics.activeThreads.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_peak_active_threads", "Peak number of busy workers.",
+             metrics.peakThreads.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_queue_size", "Tasks waiting in the queue.",
+             metrics.queueSize.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_spilled_tasks", "Tasks waiting in on-disk spill segments.",
+             metrics.spilledTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_spilled_bytes", "Bytes of serialized tasks written to spill segments.",
+               metrics.spilledBytes.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_reloaded_bytes", "Bytes of serialized tasks read back from spill segments.",
+               metrics.reloadedBytes.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_peak_queue_size", "Peak queue length.",
+             metrics.peakQueueSize.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_tasks_stuck", "Tasks the watchdog found running past their limit.",
+               metrics.stuckTasks.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_stuck_tasks", "Stuck tasks still running.",
+             metrics.currentStuckTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_replacement_workers", "Replacement workers started for stuck tasks.",
+               metrics.replacementWorkers.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_blocked_threads", "Tasks currently inside a blocking scope.",
+             metrics.blockedThreads.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_compensating_workers", "Workers started or kept to cover blocking scopes.",
+               metrics.compensatingWorkers.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_reserved_threads", "Workers reserved for high-priority tasks.",
+             metrics.reservedThreads.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_reserved_tasks", "Tasks executed by reserved workers.",
+               metrics.reservedTasks.load(std::memory_order_relaxed));
+  writeCounter(out, "threadpool_scheduling_errors", "Failed attempts to set a worker's scheduling policy or nice value.",
+               metrics.schedulingErrors.load(std::memory_order_relaxed));
+  writeGauge(out, "threadpool_uptime_seconds", "Seconds since the pool was created.", metrics.getUptime());
+
+  writeWindowedRates(out, metrics);
+  if(metrics.accounting.isEnabled()) {
+    writeCategoryUsage(out, metrics.accounting.snapshot());
+  }
+  if(metrics.rateLimiter) {
+    std::vector<RateLimitStats> limits = metrics.rateLimiter->snapshot();
+    if(!limits.empty()) {
+      writeRateLimits(out, limits);
+    }
+  }
+  if(metrics.tenants) {
+    std::vector<TenantStats> tenants = metrics.tenants->snapshot();
+    if(!tenants.empty()) {
+      writeTenants(out, tenants);
+    }
+  }
+  if(kLockProfilingEnabled) {
+    writeLockStats(out, metrics.lockProfile);
+  }
+
+  LatencySnapshot totals = metrics.getLatencyTotals();
+  for(size_t kind = 0; kind < kLatencyKindCount; ++kind) {
+    writeHistogram(out, totals, kind);
+  }
+  out << "# EOF\n";
+  return out.str();
+}
+
+std::string formatMetricsJson(const ThreadPoolMetrics& metrics) {
+  std::ostringstream out;
+  useRoundTripPrecision(out);
+  out << "{\"uptime_seconds\":" << metrics.getUptime()
+      << ",\"tasks\":{\"submitted\":" << metrics.getTotalTasks()
+      << ",\"completed\":" << metrics.getCompletedTasks()
+      << ",\"failed\":" << metrics.getFailedTasks()
+      << ",\"timeout\":" << metrics.getTimeoutTasks()
+      << ",\"helped\":" << metrics.helpedTasks.load(std::memory_order_relaxed)
+      << ",\"coalesced\":" << metrics.coalescedTasks.load(std::memory_order_relaxed)
+      << ",\"shared_queue\":" << metrics.sharedQueueTasks.load(std::memory_order_relaxed)
+      << ",\"shared_queue_dropped\":" << metrics.sharedQueueDropped.load(std::memory_order_relaxed)
+      << ",\"total_time_ns\":" << metrics.getTotalTaskTimeNs() << "}"
+      << ",\"threads\":{\"count\":" << metrics.threadCount.load(std::memory_order_relaxed)
+      << ",\"active\":" << metrics.activeThreads.load(std::memory_order_relaxed)
+      << ",\"peak_active\":" << metrics.peakThreads.load(std::memory_order_relaxed)
+      << ",\"blocked\":" << metrics.blockedThreads.load(std::memory_order_relaxed)
+      << ",\"compensating_workers\":" << metrics.compensatingWorkers.load(std::memory_order_relaxed)
+      << ",\"reserved\":" << metrics.reservedThreads.load(std::memory_order_relaxed)
+      << ",\"reserved_tasks\":" << metrics.reservedTasks.load(std::memory_order_relaxed)
+      << ",\"scheduling_errors\":" << metrics.schedulingErrors.load(std::memory_order_relaxed) << "}"
+      << ",\"queue\":{\"size\":" << metrics.queueSize.load(std::memory_order_relaxed)
+      << ",\"peak\":" << metrics.peakQueueSize.load(std::memory_order_relaxed)
+      << ",\"spilled\":" << metrics.spilledTasks.load(std::memory_order_relaxed)
+      << ",\"spilled_bytes\":" << metrics.spilledBytes.load(std::memory_order_relaxed)
+      << ",\"reloaded_bytes\":" << metrics.reloadedBytes.load(std::memory_order_relaxed) << "}"
+      << ",\"watchdog\":{\"stuck_total\":" << metrics.stuckTasks.load(std::memory_order_relaxed)
+      << ",\"stuck\":" << metrics.currentStuckTasks.load(std::memory_order_relaxed)
+      << ",\"replacement_workers\":" << metrics.replacementWorkers.load(std::memory_order_relaxed) << "}"
+      << ",\"rates\":{";
+  for(size_t w = 0; w < kWindowCount; ++w) {
+    WindowedRates rates = metrics.getWindowedRates(std::chrono::seconds(kWindowSeconds[w]));
+    if(w != 0) out << ",";
+    out << "\"" << kWindowSeconds[w] << "s\":{\"submitted\":" << rates.submittedPerSec
+        << ",\"completed\":" << rates.completedPerSec
+        << ",\"failed\":" << rates.failedPerSec
+        << ",\"timeout\":" << rates.timeoutPerSec
+        << ",\"utilization\":" << rates.utilization
+        << ",\"reserved_utilization\":" << rates.reservedUtilization << "}";
+  }
+  out << "}"
+      << ",\"latency_ns\":{";
+
+  LatencySnapshot totals = metrics.getLatencyTotals();
+  for(size_t kind = 0; kind < kLatencyKindCount; ++kind) {
+    if(kind != 0) out << ",";
+    out << "\"" << kKindNames[kind] << "\":{";
+    for(size_t p = 0; p < kPriorityCount; ++p) {
+      const HistogramSnapshot& h = totals.histograms[kind][p];
+      if(p != 0) out << ",";
+      out << "\"" << kPriorityLabels[p] << "\":{\"count\":" << h.count()
+          << ",\"mean\":" << h.mean()
+          << ",\"p50\":" << h.percentile(50)
+          << ",\"p90\":" << h.percentile(90)
+          << ",\"p99\":" << h.percentile(99)
+          << ",\"p999\":" << h.percentile(99.9)
+          << ",\"max\":" << h.max() << "}";
+    }
+    out << "}";
+  }
+  out << "}";
+
+  out << ",\"categories\":[";
+  std::vector<CategoryUsage> usage = metrics.accounting.snapshot();
+  for(size_t i = 0; i < usage.size(); ++i) {
+    if(i != 0) out << ",";
+    out << "{\"category\":\"" << escapeJson(usage[i].category) << "\""
+        << ",\"tasks\":" << usage[i].tasks
+        << ",\"wall_ns\":" << usage[i].wallNs
+        << ",\"cpu_ns\":" << usage[i].cpuNs
+        << ",\"cpu_ratio\":" << usage[i].cpuRatio()
+        << ",\"voluntary_switches\":" << usage[i].voluntarySwitches
+        << ",\"involuntary_switches\":" << usage[i].involuntarySwitches << "}";
+  }
+  out << "]";
+
+  out << ",\"rate_limits\":[";
+  if(metrics.rateLimiter) {
+    std::vector<RateLimitStats> limits = metrics.rateLimiter->snapshot();
+    for(size_t i = 0; i < limits.size(); ++i) {
+      if(i != 0) out << ",";
+      out << "{\"category\":\"" << escapeJson(limits[i].category) << "\""
+          << ",\"tasks_per_second\":" << limits[i].tasksPerSecond
+          << ",\"burst\":" << limits[i].burst
+          << ",\"tokens\":" << limits[i].tokens
+          << ",\"queued\":" << limits[i].queued
+          << ",\"peak_queued\":" << limits[i].peakQueued
+          << ",\"admitted\":" << limits[i].admitted
+          << ",\"throttled\":" << limits[i].throttled << "}";
+    }
+  }
+  out << "]";
+
+  out << ",\"tenants\":[";
+  if(metrics.tenants) {
+    std::vector<TenantStats> tenants = metrics.tenants->snapshot();
+    for(size_t i = 0; i < tenants.size(); ++i) {
+      const TenantStats& t = tenants[i];
+      if(i != 0) out << ",";
+      out << "{\"tenant\":\"" << escapeJson(t.tenant) << "\""
+          << ",\"weight\":" << t.weight
+          << ",\"queued\":" << t.queued
+          << ",\"submitted\":" << t.submitted
+          << ",\"completed\":" << t.completed
+          << ",\"wait_ns\":{\"mean\":" << t.wait.mean()
+          << ",\"p50\":" << t.wait.percentile(50)
+          << ",\"p99\":" << t.wait.percentile(99)
+          << ",\"max\":" << t.wait.max() << "}"
+          << ",\"end_to_end_ns\":{\"mean\":" << t.endToEnd.mean()
+          << ",\"p50\":" << t.endToEnd.percentile(50)
+          << ",\"p99\":" << t.endToEnd.percentile(99)
+          << ",\"max\":" << t.endToEnd.max() << "}}";
+    }
+  }
+  out << "]}\n";
+  return out.str();
+}
+
+
+MetricsHttpServer::MetricsHttpServer(const ThreadPoolMetrics& metrics) : metrics(metrics) {}
+
+MetricsHttpServer::~MetricsHttpServer() {
+  stop();
+}
+
+bool MetricsHttpServer::listenTcp(uint16_t port) {
+  stop();
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if(fd < 0) return false;
+  int reuse = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);   //只对本机开放
+  addr.sin_port = htons(port);
+  if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  socklen_t len = sizeof(addr);
+  ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+  boundPort = ntohs(addr.sin_port);
+  return startLoop(fd);
+}
+
+bool MetricsHttpServer::listenUnix(const std::string& path) {
+  stop();
+  sockaddr_un addr{};
+  if(path.size() >= sizeof(addr.sun_path)) return false;
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0) return false;
+
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  ::unlink(path.c_str());
+  if(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  unixPath = path;
+  return startLoop(fd);
+}
+
+bool MetricsHttpServer::startLoop(int fd) {
+  if(::listen(fd, 16) != 0) {
+    ::close(fd);
+    if(!unixPath.empty()) ::unlink(unixPath.c_str());
+    unixPath.clear();
+    boundPort = 0;
+    return false;
+  }
+  listenFd = fd;
+  running.store(true, std::memory_order_release);
+  serverThread = std::thread([this]() { serveLoop(); });
+  return true;
+}
+
+void MetricsHttpServer::stop() {
+  running.store(false, std::memory_order_release);
+  if(serverThread.joinable()) {
+    serverThread.join();
+  }
+  if(listenFd >= 0) {
+    ::close(listenFd);
+    listenFd = -1;
+  }
+  if(!unixPath.empty()) {
+    ::unlink(unixPath.c_str());
+    unixPath.clear();
+  }
+  boundPort = 0;
+}
+
+void MetricsHttpServer::serveLoop() {
+  //用带超时的poll等待连接 这样stop最多等待一个轮询周期
+  while(running.load(std::memory_order_acquire)) {
+    pollfd pfd{listenFd, POLLIN, 0};
+    int ready = ::poll(&pfd, 1, 100);
+    if(ready <= 0) continue;
+
+    int client = ::accept(listenFd, nullptr, nullptr);
+    if(client < 0) continue;
+    handleConnection(client);
+    ::close(client);
+  }
+}
+
+void MetricsHttpServer::handleConnection(int fd) {
+  //抓取方不应该拖住服务线程 读请求最多等待1秒
+  timeval timeout{1, 0};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buffer[1024];
+  while(request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+    ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+    if(n < 0 && errno == EINTR) continue;
+    if(n <= 0) break;
+    request.append(buffer, static_cast<size_t>(n));
+  }
+
+  //请求行: METHOD SP PATH SP VERSION
+  std::string method, path;
+  std::istringstream line(request.substr(0, request.find("\r\n")));
+  line >> method >> path;
+  size_t query = path.find('?');
+  if(query != std::string::npos) path.resize(query);
+
+  std::string status = "200 OK";
+  std::string contentType;
+  std::string body;
+  if(method != "GET") {
+    status = "405 Method Not Allowed";
+    contentType = "text/plain";
+    body = "method not allowed\n";
+  } else if(path == "/metrics" || path == "/") {
+    contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    body = formatOpenMetrics(metrics);
+  } else if(path == "/metrics.json") {
+    contentType = "application/json";
+    body = formatMetricsJson(metrics);
+  } else {
+    status = "404 Not Found";
+    contentType = "text/plain";
+    body = "not found\n";
+  }
+
+  std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+                         "\r\nContent-Length: " + std::to_string(body.size()) +
+                         "\r\nConnection: close\r\n\r\n" + body;
+  writeFully(fd, response);
+}
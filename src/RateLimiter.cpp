@@ -0,0 +1,185 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+RateLimiter::RateLimiter(ReleaseHandler handler) : onRelease(std::move(handler)) {}
+
+RateLimiter::~RateLimiter() {
+  stop();
+}
+
+void RateLimiter::setLimit(const std::string& category, double tasksPerSecond, double burst) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::time_point now = Clock::now();
+    auto inserted = categories.emplace(category, Category());
+    Category& c = inserted.first->second;
+    if(inserted.second) {
+      //新类别从满桶开始 允许立即放行burst个任务
+      c.stats.category = category;
+      c.stats.tokens = std::max(burst, 1.0);
+      c.refilledAt = now;
+    } else {
+      refill(c, now);
+    }
+    RateLimitStats& stats = c.stats;
+    stats.tasksPerSecond = std::max(tasksPerSecond, 0.0);
+    stats.burst = std::max(burst, 1.0);      //少于一个令牌的桶永远放行不了任务
+    stats.tokens = std::min(stats.tokens, stats.burst);
+
+    if(!timer.joinable() && !stopRequested) {
+      timer = std::thread([this]() { timerLoop(); });
+    }
+  }
+  //速率变化后重新计算下一次放行的时间
+  timerCondition.notify_one();
+}
+
+bool RateLimiter::removeLimit(const std::string& category, std::vector<std::shared_ptr<TaskInfo>>& released) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = categories.find(category);
+  if(it == categories.end()) {
+    return false;
+  }
+  for(std::shared_ptr<TaskInfo>& task : it->second.pending) {
+    released.push_back(std::move(task));
+  }
+  categories.erase(it);
+  return true;
+}
+
+bool RateLimiter::hasLimit(const std::string& category) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return categories.count(category) != 0;
+}
+
+bool RateLimiter::admit(const std::string& category, std::shared_ptr<TaskInfo>& task) {
+  bool wakeTimer = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = categories.find(category);
+    if(it == categories.end()) {
+      throw std::invalid_argument("Unknown rate limit category: " + category);
+    }
+    Category& c = it->second;
+    refill(c, Clock::now());
+    //侧队列非空时即使有令牌也排在后面 保持类别内的提交顺序
+    if(c.pending.empty() && c.stats.tokens >= 1.0) {
+      c.stats.tokens -= 1.0;
+      ++c.stats.admitted;
+      return true;
+    }
+    c.pending.push_back(std::move(task));
+    ++c.stats.throttled;
+    c.stats.queued = c.pending.size();
+    c.stats.peakQueued = std::max(c.stats.peakQueued, c.stats.queued);
+    wakeTimer = c.pending.size() == 1;
+  }
+  //定时线程可能因为没有等待的任务而无限期休眠
+  if(wakeTimer) {
+    timerCondition.notify_one();
+  }
+  return false;
+}
+
+std::vector<std::shared_ptr<TaskInfo>> RateLimiter::clear() {
+  std::vector<std::shared_ptr<TaskInfo>> dropped;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto& entry : categories) {
+      for(std::shared_ptr<TaskInfo>& task : entry.second.pending) {
+        dropped.push_back(std::move(task));
+      }
+      entry.second.pending.clear();
+      entry.second.stats.queued = 0;
+    }
+  }
+  //任务记录(以及其中的promise)在锁外析构
+  return dropped;
+}
+
+void RateLimiter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopRequested = true;
+  }
+  timerCondition.notify_all();
+  if(timer.joinable()) {
+    timer.join();
+  }
+}
+
+std::vector<RateLimitStats> RateLimiter::snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  Clock::time_point now = Clock::now();
+  std::vector<RateLimitStats> result;
+  result.reserve(categories.size());
+  for(const auto& entry : categories) {
+    //报告当前的令牌数 但不修改桶的状态
+    Category copy = {entry.second.stats, entry.second.refilledAt, {}};
+    refill(copy, now);
+    result.push_back(copy.stats);
+  }
+  return result;
+}
+
+std::string RateLimiter::getReport() const {
+  std::ostringstream out;
+  for(const RateLimitStats& stats : snapshot()) {
+    out << "  限流 " << stats.category << ": " << stats.tasksPerSecond << " 任务/秒 突发 " << stats.burst
+        << ", 放行 " << stats.admitted << ", 被限流 " << stats.throttled
+        << ", 等待 " << stats.queued << " (峰值 " << stats.peakQueued << ")\n";
+  }
+  return out.str();
+}
+
+void RateLimiter::refill(Category& category, Clock::time_point now) {
+  RateLimitStats& stats = category.stats;
+  if(now > category.refilledAt) {
+    double elapsed = std::chrono::duration<double>(now - category.refilledAt).count();
+    stats.tokens = std::min(stats.burst, stats.tokens + elapsed * stats.tasksPerSecond);
+  }
+  category.refilledAt = now;
+}
+
+// 每轮放行所有已有令牌的等待任务 然后睡到最早的下一个令牌
+void RateLimiter::timerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while(!stopRequested) {
+    Clock::time_point now = Clock::now();
+    Clock::time_point wakeAt = Clock::time_point::max();
+    std::vector<std::shared_ptr<TaskInfo>> ready;
+
+    for(auto& entry : categories) {
+      Category& c = entry.second;
+      if(c.pending.empty()) {
+        continue;
+      }
+      refill(c, now);
+      while(!c.pending.empty() && c.stats.tokens >= 1.0) {
+        c.stats.tokens -= 1.0;
+        ++c.stats.admitted;
+        ready.push_back(std::move(c.pending.front()));
+        c.pending.pop_front();
+      }
+      c.stats.queued = c.pending.size();
+      if(!c.pending.empty() && c.stats.tasksPerSecond > 0.0) {
+        std::chrono::duration<double> untilToken((1.0 - c.stats.tokens) / c.stats.tasksPerSecond);
+        wakeAt = std::min(wakeAt, now + std::chrono::ceil<Clock::duration>(untilToken));
+      }
+    }
+
+    if(!ready.empty()) {
+      lock.unlock();
+      onRelease(std::move(ready));
+      lock.lock();
+      continue;
+    }
+    if(wakeAt == Clock::time_point::max()) {
+      timerCondition.wait(lock);
+    } else {
+      timerCondition.wait_until(lock, wakeAt);
+    }
+  }
+}
@@ -0,0 +1,544 @@
+#include "SharedTaskQueue.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kSharedMagic[8] = {'T', 'P', 'S', 'H', 'M', 'Q', '0', '1'};
+constexpr uint32_t kSharedVersion = 1;
+
+// 等待和重试的间隔
+constexpr std::chrono::milliseconds kPollTimeout{20};
+constexpr std::chrono::microseconds kRetryInterval{50};
+
+enum SharedRing : size_t {
+  REQUEST_RING = 0,
+  COMPLETION_RING = 1
+};
+
+// 环头: 入队位置和出队位置各占一条缓存行
+struct alignas(64) SharedRingHeader {
+  alignas(64) std::atomic<uint64_t> enqueuePos{0};
+  alignas(64) std::atomic<uint64_t> dequeuePos{0};
+  alignas(64) std::atomic<uint32_t> signal{0};    // futex字 每发布一条消息加一
+  std::atomic<uint32_t> waiters{0};
+};
+
+// 存储布局: [段头][请求环槽位 slots*slotBytes][完成环槽位 slots*slotBytes]
+struct SharedSegmentHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t slots;
+  uint64_t slotBytes;
+  alignas(64) std::atomic<uint64_t> nextRequestId{0};
+  SharedRingHeader rings[2];
+};
+
+// 槽位头 之后紧跟处理函数名和数据
+// sequence等于位置时可写 等于位置+1时可读 读完后设为位置+slots供下一圈写入
+struct SharedSlotHeader {
+  std::atomic<uint64_t> sequence{0};
+  uint64_t requestId = 0;
+  uint32_t tag = 0;         // 请求: 优先级 完成: 1成功 0失败
+  uint32_t nameBytes = 0;
+  uint32_t dataBytes = 0;
+  uint32_t reserved = 0;
+};
+
+static_assert(sizeof(SharedSlotHeader) == 32, "slot header must be 32 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory atomics must be lock-free");
+
+SharedSegmentHeader* headerOf(void* base) {
+  return static_cast<SharedSegmentHeader*>(base);
+}
+
+// 映射时校验过的段尺寸 之后不再读段头中的尺寸字段 其他进程改写它们不会导致越界访问
+struct SharedLayout {
+  void* base;
+  uint64_t slots;
+  uint64_t slotBytes;
+
+  SharedRingHeader& ring(SharedRing which) const { return headerOf(base)->rings[which]; }
+  uint64_t maxMessageBytes() const { return slotBytes - sizeof(SharedSlotHeader); }
+};
+
+SharedSlotHeader* slotAt(const SharedLayout& layout, SharedRing ring, uint64_t index) {
+  char* slots = static_cast<char*>(layout.base) + sizeof(SharedSegmentHeader);
+  return reinterpret_cast<SharedSlotHeader*>(slots + (ring * layout.slots + index) * layout.slotBytes);
+}
+
+size_t segmentBytes(uint64_t slots, uint64_t slotBytes) {
+  return sizeof(SharedSegmentHeader) + 2 * slots * slotBytes;
+}
+
+uint64_t roundUpPowerOfTwo(uint64_t n) {
+  uint64_t p = 1;
+  while(p < n) p <<= 1;
+  return p;
+}
+
+// 共享futex(不带FUTEX_PRIVATE_FLAG) 不同进程映射同一页时可以互相唤醒
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::milliseconds timeout) {
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+  ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word) {
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool pushMessage(const SharedLayout& layout, SharedRing ring, uint64_t requestId, uint32_t tag,
+                 const std::string& name, const std::string& data) {
+  if(name.size() + data.size() > layout.maxMessageBytes()) {
+    throw std::invalid_argument("Shared task message exceeds slot size");
+  }
+  SharedRingHeader& r = layout.ring(ring);
+  uint64_t mask = layout.slots - 1;
+
+  uint64_t pos = r.enqueuePos.load(std::memory_order_relaxed);
+  SharedSlotHeader* slot;
+  while(true) {
+    slot = slotAt(layout, ring, pos & mask);
+    uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+    if(diff == 0) {
+      if(r.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if(diff < 0) {
+      return false;   //环满
+    } else {
+      pos = r.enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->requestId = requestId;
+  slot->tag = tag;
+  slot->nameBytes = static_cast<uint32_t>(name.size());
+  slot->dataBytes = static_cast<uint32_t>(data.size());
+  char* payload = reinterpret_cast<char*>(slot + 1);
+  std::memcpy(payload, name.data(), name.size());
+  std::memcpy(payload + name.size(), data.data(), data.size());
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  r.signal.fetch_add(1, std::memory_order_seq_cst);
+  if(r.waiters.load(std::memory_order_seq_cst) > 0) {
+    futexWakeAll(&r.signal);
+  }
+  return true;
+}
+
+// 槽位头中的长度超出槽位时valid为false 槽位照常释放 内容丢弃
+bool popMessage(const SharedLayout& layout, SharedRing ring, uint64_t& requestId, uint32_t& tag,
+                std::string& name, std::string& data, bool& valid) {
+  SharedRingHeader& r = layout.ring(ring);
+  uint64_t mask = layout.slots - 1;
+
+  uint64_t pos = r.dequeuePos.load(std::memory_order_relaxed);
+  SharedSlotHeader* slot;
+  while(true) {
+    slot = slotAt(layout, ring, pos & mask);
+    uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+    int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1);
+    if(diff == 0) {
+      if(r.dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if(diff < 0) {
+      return false;   //环空
+    } else {
+      pos = r.dequeuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  requestId = slot->requestId;
+  tag = slot->tag;
+  //长度只读一次 校验和拷贝使用同一份值
+  uint64_t nameBytes = slot->nameBytes;
+  uint64_t dataBytes = slot->dataBytes;
+  valid = nameBytes + dataBytes <= layout.maxMessageBytes();
+  if(valid) {
+    const char* payload = reinterpret_cast<const char*>(slot + 1);
+    name.assign(payload, nameBytes);
+    data.assign(payload + nameBytes, dataBytes);
+  } else {
+    name.clear();
+    data.clear();
+  }
+  slot->sequence.store(pos + layout.slots, std::memory_order_release);
+  return true;
+}
+
+// 出队位置上的槽位已经发布
+bool ringReadable(const SharedLayout& layout, SharedRing ring) {
+  uint64_t pos = layout.ring(ring).dequeuePos.load(std::memory_order_acquire);
+  SharedSlotHeader* slot = slotAt(layout, ring, pos & (layout.slots - 1));
+  return slot->sequence.load(std::memory_order_acquire) == pos + 1;
+}
+
+// 先读signal再检查环 发布者在检查之后加一时futex立即返回 不会丢失唤醒
+void waitReadable(const SharedLayout& layout, SharedRing ring, std::chrono::milliseconds timeout) {
+  SharedRingHeader& r = layout.ring(ring);
+  uint32_t seen = r.signal.load(std::memory_order_seq_cst);
+  if(ringReadable(layout, ring)) {
+    return;
+  }
+  r.waiters.fetch_add(1, std::memory_order_seq_cst);
+  if(!ringReadable(layout, ring)) {
+    futexWait(&r.signal, seen, timeout);
+  }
+  r.waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+}  // namespace
+
+
+std::unique_ptr<SharedTaskQueue> SharedTaskQueue::create(const std::string& name,
+                                                         const SharedQueueOptions& options) {
+  uint64_t slots = roundUpPowerOfTwo(std::max<size_t>(options.slots, 2));
+  uint64_t slotBytes = std::max<uint64_t>((options.slotBytes + 63) / 64 * 64, 128);
+  size_t bytes = segmentBytes(slots, slotBytes);
+
+  int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+  if(fd < 0) {
+    return nullptr;
+  }
+  //先截断为0再扩展 已存在的段内容全部清零
+  if(::ftruncate(fd, 0) != 0 || ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+    int saved = errno;
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    errno = saved;
+    return nullptr;
+  }
+  void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(base == MAP_FAILED) {
+    ::shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  SharedSegmentHeader* header = new (base) SharedSegmentHeader();
+  header->version = kSharedVersion;
+  header->slots = slots;
+  header->slotBytes = slotBytes;
+  for(size_t ring = 0; ring < 2; ++ring) {
+    for(uint64_t i = 0; i < slots; ++i) {
+      SharedSlotHeader* slot = new (slotAt(SharedLayout{base, slots, slotBytes}, static_cast<SharedRing>(ring), i))
+          SharedSlotHeader();
+      slot->sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  //最后写入magic 打开者看到magic时其余字段已经初始化
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, kSharedMagic, sizeof(kSharedMagic));
+
+  return std::unique_ptr<SharedTaskQueue>(new SharedTaskQueue(name, base, bytes, slots, slotBytes, true));
+}
+
+std::unique_ptr<SharedTaskQueue> SharedTaskQueue::open(const std::string& name) {
+  int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+  if(fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedSegmentHeader)) {
+    ::close(fd);
+    errno = EINVAL;
+    return nullptr;
+  }
+  size_t bytes = static_cast<size_t>(st.st_size);
+  void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(base == MAP_FAILED) {
+    return nullptr;
+  }
+
+  //尺寸只读一次 之后使用校验过的副本 先分别限制大小再相乘 避免溢出
+  SharedSegmentHeader* header = headerOf(base);
+  uint64_t slots = header->slots;
+  uint64_t slotBytes = header->slotBytes;
+  bool valid = std::memcmp(header->magic, kSharedMagic, sizeof(kSharedMagic)) == 0 &&
+               header->version == kSharedVersion &&
+               slots >= 2 && (slots & (slots - 1)) == 0 && slots <= bytes &&
+               slotBytes > sizeof(SharedSlotHeader) && slotBytes <= bytes &&
+               segmentBytes(slots, slotBytes) <= bytes;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if(!valid) {
+    ::munmap(base, bytes);
+    errno = EINVAL;
+    return nullptr;
+  }
+  return std::unique_ptr<SharedTaskQueue>(new SharedTaskQueue(name, base, bytes, slots, slotBytes, false));
+}
+
+bool SharedTaskQueue::unlink(const std::string& name) {
+  return ::shm_unlink(name.c_str()) == 0;
+}
+
+SharedTaskQueue::SharedTaskQueue(std::string name, void* base, size_t bytes, uint64_t slots,
+                                 uint64_t slotBytes, bool owner)
+  : segmentName(std::move(name)), base(base), mappedBytes(bytes), slots(slots), slotBytes(slotBytes)
+  , owner(owner) {}
+
+SharedTaskQueue::~SharedTaskQueue() {
+  ::munmap(base, mappedBytes);
+  if(owner) {
+    ::shm_unlink(segmentName.c_str());
+  }
+}
+
+size_t SharedTaskQueue::slotCount() const {
+  return slots;
+}
+
+size_t SharedTaskQueue::maxMessageBytes() const {
+  return SharedLayout{base, slots, slotBytes}.maxMessageBytes();
+}
+
+uint64_t SharedTaskQueue::nextRequestId() {
+  return headerOf(base)->nextRequestId.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool SharedTaskQueue::pushRequest(uint64_t requestId, TaskPriority priority, const std::string& handler,
+                                  const std::string& payload) {
+  return pushMessage(SharedLayout{base, slots, slotBytes}, REQUEST_RING, requestId, static_cast<uint32_t>(priority), handler, payload);
+}
+
+bool SharedTaskQueue::popRequest(SharedTaskRequest& request) {
+  uint32_t tag = 0;
+  if(!popMessage(SharedLayout{base, slots, slotBytes}, REQUEST_RING, request.requestId, tag, request.handler,
+                 request.payload, request.valid)) {
+    return false;
+  }
+  request.priority = static_cast<TaskPriority>(std::min(tag, static_cast<uint32_t>(TaskPriority::CRITICAL)));
+  return true;
+}
+
+bool SharedTaskQueue::pushCompletion(uint64_t requestId, bool ok, const std::string& result) {
+  return pushMessage(SharedLayout{base, slots, slotBytes}, COMPLETION_RING, requestId, ok ? 1 : 0, std::string(), result);
+}
+
+bool SharedTaskQueue::popCompletion(SharedTaskCompletion& completion) {
+  uint32_t tag = 0;
+  std::string name;
+  if(!popMessage(SharedLayout{base, slots, slotBytes}, COMPLETION_RING, completion.requestId, tag, name,
+                 completion.result, completion.valid)) {
+    return false;
+  }
+  completion.ok = tag != 0 && completion.valid;
+  if(!completion.valid) {
+    completion.result = "Corrupt shared task completion";
+  }
+  return true;
+}
+
+void SharedTaskQueue::waitForRequest(std::chrono::milliseconds timeout) {
+  waitReadable(SharedLayout{base, slots, slotBytes}, REQUEST_RING, timeout);
+}
+
+void SharedTaskQueue::waitForCompletion(std::chrono::milliseconds timeout) {
+  waitReadable(SharedLayout{base, slots, slotBytes}, COMPLETION_RING, timeout);
+}
+
+
+SharedTaskClient::SharedTaskClient(std::unique_ptr<SharedTaskQueue> queue)
+  : sharedQueue(std::move(queue)) {
+  completionThread = std::thread([this]() { completionLoop(); });
+}
+
+SharedTaskClient::~SharedTaskClient() {
+  stopping.store(true, std::memory_order_release);
+  if(completionThread.joinable()) {
+    completionThread.join();
+  }
+}
+
+std::future<std::string> SharedTaskClient::submit(const std::string& handler, const std::string& payload,
+                                                  TaskPriority priority) {
+  if(handler.size() + payload.size() > sharedQueue->maxMessageBytes()) {
+    throw std::invalid_argument("Shared task message exceeds slot size");
+  }
+  //先登记promise再发布请求 结果可能在pushRequest返回之前就到达
+  uint64_t requestId = sharedQueue->nextRequestId();
+  std::future<std::string> result;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    result = pending[requestId].get_future();
+  }
+  while(!sharedQueue->pushRequest(requestId, priority, handler, payload)) {
+    std::this_thread::sleep_for(kRetryInterval);
+  }
+  return result;
+}
+
+size_t SharedTaskClient::pendingCount() const {
+  std::lock_guard<std::mutex> lock(pendingMutex);
+  return pending.size();
+}
+
+void SharedTaskClient::completionLoop() {
+  SharedTaskCompletion completion;
+  while(!stopping.load(std::memory_order_acquire)) {
+    if(!sharedQueue->popCompletion(completion)) {
+      sharedQueue->waitForCompletion(kPollTimeout);
+      continue;
+    }
+    std::promise<std::string> promise;
+    {
+      std::lock_guard<std::mutex> lock(pendingMutex);
+      auto it = pending.find(completion.requestId);
+      if(it == pending.end()) {
+        continue;   //不是本客户端提交的请求
+      }
+      promise = std::move(it->second);
+      pending.erase(it);
+    }
+    if(completion.ok) {
+      promise.set_value(std::move(completion.result));
+    } else {
+      promise.set_exception(std::make_exception_ptr(std::runtime_error(completion.result)));
+    }
+  }
+}
+
+
+// 提交到线程池的一个请求 任务记录没有执行就被销毁时(线程池析构、clearTasks、提交失败)回报失败
+// 否则前端的future会永远等待
+struct SharedQueueConsumer::PostedRequest {
+  PostedRequest(std::shared_ptr<SharedQueueConsumer> owner, SharedTaskRequest request)
+    : consumer(std::move(owner)), request(std::move(request)) {}
+
+  ~PostedRequest() {
+    if(!executed) {
+      consumer->finish(request.requestId, false, "Shared task dropped before execution");
+    }
+  }
+
+  std::shared_ptr<SharedQueueConsumer> consumer;
+  SharedTaskRequest request;
+  bool executed = false;
+};
+
+SharedQueueConsumer::SharedQueueConsumer(std::unique_ptr<SharedTaskQueue> queue, size_t maxInFlight,
+                                         HandlerLookup lookup, Submit submit,
+                                         std::chrono::milliseconds completionTimeout, Dropped dropped)
+  : sharedQueue(std::move(queue))
+  , maxInFlight(std::max<size_t>(maxInFlight, 1))
+  , completionTimeout(completionTimeout)
+  , lookup(std::move(lookup))
+  , submit(std::move(submit))
+  , dropped(std::move(dropped)) {}
+
+SharedQueueConsumer::~SharedQueueConsumer() {
+  stop();
+}
+
+void SharedQueueConsumer::start() {
+  puller = std::thread([this]() { pullLoop(); });
+}
+
+void SharedQueueConsumer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(slotMutex);
+    stopping.store(true, std::memory_order_release);
+  }
+  slotFreed.notify_all();
+  if(puller.joinable()) {
+    puller.join();
+  }
+}
+
+void SharedQueueConsumer::pullLoop() {
+  while(true) {
+    {
+      std::unique_lock<std::mutex> lock(slotMutex);
+      slotFreed.wait(lock, [this]() {
+        return stopping.load(std::memory_order_relaxed) ||
+               running.load(std::memory_order_relaxed) < maxInFlight;
+      });
+      if(stopping.load(std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    SharedTaskRequest request;
+    if(!sharedQueue->popRequest(request)) {
+      sharedQueue->waitForRequest(kPollTimeout);
+      continue;
+    }
+    if(!request.valid) {
+      complete(request.requestId, false, "Corrupt shared task request");
+      continue;
+    }
+    running.fetch_add(1, std::memory_order_relaxed);
+    TaskPriority priority = request.priority;
+    auto posted = std::make_shared<PostedRequest>(shared_from_this(), std::move(request));
+    try {
+      submit(priority, [posted]() {
+        posted->executed = true;
+        posted->consumer->execute(posted->request);
+      });
+    } catch(const std::exception&) {
+      //线程池已停止 任务记录随之销毁 由PostedRequest回报失败
+    }
+  }
+}
+
+void SharedQueueConsumer::execute(const SharedTaskRequest& request) {
+  Handler handler = lookup(request.handler);
+  if(!handler) {
+    finish(request.requestId, false, "Unknown shared task handler: " + request.handler);
+    return;
+  }
+  try {
+    std::string result = handler(request.payload);
+    finish(request.requestId, true, result);
+  } catch(const std::exception& e) {
+    finish(request.requestId, false, e.what());
+  } catch(...) {
+    finish(request.requestId, false, "未知异常");
+  }
+}
+
+void SharedQueueConsumer::finish(uint64_t requestId, bool ok, const std::string& result) {
+  complete(requestId, ok, result);
+  {
+    std::lock_guard<std::mutex> lock(slotMutex);
+    running.fetch_sub(1, std::memory_order_relaxed);
+  }
+  slotFreed.notify_one();
+}
+
+// 完成环满时等待前端取走结果 最多等待completionTimeout 前端已经退出时不会让工作线程永远卡住
+void SharedQueueConsumer::complete(uint64_t requestId, bool ok, const std::string& result) {
+  if(result.size() > sharedQueue->maxMessageBytes()) {
+    complete(requestId, false, "Shared task result exceeds slot size");
+    return;
+  }
+  auto deadline = std::chrono::steady_clock::now() + completionTimeout;
+  while(!sharedQueue->pushCompletion(requestId, ok, result)) {
+    if(std::chrono::steady_clock::now() >= deadline) {
+      droppedCompletions.fetch_add(1, std::memory_order_relaxed);
+      if(dropped) {
+        dropped();
+      }
+      return;
+    }
+    std::this_thread::sleep_for(kRetryInterval);
+  }
+}
@@ -0,0 +1,183 @@
+#include "SpillStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 记录格式: [处理函数名字节数 u32][参数字节数 u32][提交时间 i64][处理函数名][参数] 按8字节对齐
+struct SpillSegment {
+  ~SpillSegment() {
+    ::munmap(base, capacity);
+    ::close(fd);
+  }
+
+  int fd = -1;
+  char* base = nullptr;
+  size_t capacity = 0;
+  size_t writeOffset = 0;
+  size_t readOffset = 0;
+};
+
+namespace {
+
+struct SpillRecordHeader {
+  uint32_t handlerBytes;
+  uint32_t payloadBytes;
+  int64_t submitNs;     // steady_clock时间戳 读回后排队时间仍从提交时算起
+};
+
+size_t recordBytes(size_t handlerBytes, size_t payloadBytes) {
+  return (sizeof(SpillRecordHeader) + handlerBytes + payloadBytes + 7) & ~static_cast<size_t>(7);
+}
+
+size_t pageSize() {
+  static const size_t bytes = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  return bytes;
+}
+
+// 写满的段: 发起异步回写并放弃映射中的页 页留在页缓存里 内存紧张时可以被回收
+void seal(SpillSegment& segment, bool reading) {
+  ::msync(segment.base, segment.capacity, MS_ASYNC);
+  //正在读取的段很快还会被访问 保留它的页
+  if(!reading) {
+    ::madvise(segment.base, segment.capacity, MADV_DONTNEED);
+  }
+}
+
+}  // namespace
+
+SpillStore::SpillStore() = default;
+
+SpillStore::~SpillStore() = default;
+
+bool SpillStore::enable(const SpillOptions& options) {
+  if(::access(options.directory.c_str(), W_OK | X_OK) != 0) {
+    return false;
+  }
+  config = options;
+  config.maxQueuedTasks = std::max<size_t>(config.maxQueuedTasks, 1);
+  size_t page = pageSize();
+  config.segmentBytes = std::max((config.segmentBytes + page - 1) / page * page, page);
+  enabled = true;
+  return true;
+}
+
+std::unique_ptr<SpillSegment> SpillStore::createSegment(size_t minBytes) {
+  size_t page = pageSize();
+  size_t capacity = std::max(config.segmentBytes, (minBytes + page - 1) / page * page);
+
+  std::string path = config.directory + "/threadpool-spill-XXXXXX";
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+  int fd = ::mkstemp(name.data());
+  if(fd < 0) {
+    return nullptr;
+  }
+  //文件只通过描述符和映射访问 立即删除文件名
+  ::unlink(name.data());
+  //预先分配磁盘块 磁盘满时在这里失败 而不是写映射时收到SIGBUS
+  int error = ::posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+  if(error != 0) {
+    ::close(fd);
+    errno = error;
+    return nullptr;
+  }
+  void* base = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(base == MAP_FAILED) {
+    int saved = errno;
+    ::close(fd);
+    errno = saved;
+    return nullptr;
+  }
+
+  auto segment = std::unique_ptr<SpillSegment>(new SpillSegment());
+  segment->fd = fd;
+  segment->base = static_cast<char*>(base);
+  segment->capacity = capacity;
+  return segment;
+}
+
+size_t SpillStore::append(TaskPriority priority, const std::string& handler, const std::string& payload,
+                          std::chrono::steady_clock::time_point submitTime) {
+  if(handler.size() > std::numeric_limits<uint32_t>::max() ||
+     payload.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Spilled task payload too large");
+  }
+  size_t p = static_cast<size_t>(priority);
+  size_t bytes = recordBytes(handler.size(), payload.size());
+  std::deque<std::unique_ptr<SpillSegment>>& queue = segments[p];
+
+  if(queue.empty() || queue.back()->capacity - queue.back()->writeOffset < bytes) {
+    std::unique_ptr<SpillSegment> segment = createSegment(bytes);
+    if(!segment) {
+      return 0;
+    }
+    if(!queue.empty()) {
+      seal(*queue.back(), queue.size() == 1);
+    }
+    queue.push_back(std::move(segment));
+  }
+
+  SpillSegment& segment = *queue.back();
+  char* out = segment.base + segment.writeOffset;
+  SpillRecordHeader header{static_cast<uint32_t>(handler.size()), static_cast<uint32_t>(payload.size()),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(submitTime.time_since_epoch()).count()};
+  std::memcpy(out, &header, sizeof(header));
+  std::memcpy(out + sizeof(header), handler.data(), handler.size());
+  std::memcpy(out + sizeof(header) + handler.size(), payload.data(), payload.size());
+  segment.writeOffset += bytes;
+  ++counts[p];
+  return bytes;
+}
+
+size_t SpillStore::pop(TaskPriority priority, SpilledTask& task) {
+  size_t p = static_cast<size_t>(priority);
+  if(counts[p] == 0) {
+    return 0;
+  }
+  std::deque<std::unique_ptr<SpillSegment>>& queue = segments[p];
+  //计数不为0时第一个段里一定还有未读的记录(读完的段会立即移除)
+  SpillSegment& segment = *queue.front();
+  const char* in = segment.base + segment.readOffset;
+  SpillRecordHeader header;
+  std::memcpy(&header, in, sizeof(header));
+  task.handler.assign(in + sizeof(header), header.handlerBytes);
+  task.payload.assign(in + sizeof(header) + header.handlerBytes, header.payloadBytes);
+  task.submitTime = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(header.submitNs));
+  size_t bytes = recordBytes(header.handlerBytes, header.payloadBytes);
+  segment.readOffset += bytes;
+  --counts[p];
+
+  if(segment.readOffset == segment.writeOffset) {
+    if(queue.size() > 1) {
+      queue.pop_front();
+    } else {
+      //最后一个段读空后从头复用 不必重新创建文件
+      segment.readOffset = 0;
+      segment.writeOffset = 0;
+    }
+  }
+  return bytes;
+}
+
+size_t SpillStore::size() const {
+  size_t total = 0;
+  for(size_t count : counts) {
+    total += count;
+  }
+  return total;
+}
+
+size_t SpillStore::clear() {
+  size_t total = size();
+  for(size_t p = 0; p < kPriorityCount; ++p) {
+    segments[p].clear();
+    counts[p] = 0;
+  }
+  return total;
+}
@@ -0,0 +1,151 @@
+#include "Strand.h"
+#include <thread>
+
+std::shared_ptr<Strand> Strand::create(ThreadPool& pool, TaskPriority priority) {
+  return std::shared_ptr<Strand>(new Strand(pool, priority));
+}
+
+Strand::Strand(ThreadPool& pool, TaskPriority priority)
+  : pool(pool)
+  , priority(priority)
+  , head(&stub)
+  , tail(&stub) {}
+
+// 析构时还没执行的任务直接丢弃
+Strand::~Strand() {
+  while(Node* node = pop()) {
+    delete node;
+  }
+}
+
+void Strand::post(std::function<void()> task) {
+  Node* node = new Node;
+  node->task = std::move(task);
+  push(node);
+
+  //0 -> 1 的那个生产者负责调度 其余生产者只入队
+  if(pendingCount.fetch_add(1, std::memory_order_acq_rel) == 0) {
+    try {
+      schedule();
+    } catch(...) {
+      //计数停在非0会让之后的post都不再调度 任务永远不执行
+      discardPending();
+      throw;
+    }
+  }
+}
+
+// 调度失败时没有drain在运行 调用线程持有调度权 可以充当消费者
+// 丢弃所有已计数的任务(enqueue的future得到broken_promise) 计数归零后调度权释放 之后的post重新尝试调度
+void Strand::discardPending() {
+  do {
+    Node* node = pop();
+    while(node == nullptr) {
+      std::this_thread::yield();
+      node = pop();
+    }
+    delete node;
+  } while(pendingCount.fetch_sub(1, std::memory_order_acq_rel) != 1);
+}
+
+// Vyukov无锁MPSC队列: 生产者只做一次exchange和一次store
+void Strand::push(Node* node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Node* prev = head.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+// 只在drain线程调用 返回nullptr表示队列为空或者有生产者正处在exchange与链接之间
+Strand::Node* Strand::pop() {
+  Node* t = tail;
+  Node* next = t->next.load(std::memory_order_acquire);
+
+  if(t == &stub) {
+    if(next == nullptr) {
+      return nullptr;
+    }
+    tail = next;
+    t = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if(next != nullptr) {
+    tail = next;
+    return t;
+  }
+
+  if(t != head.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+
+  //t是最后一个节点 把stub放回队尾才能把t取出
+  push(&stub);
+  next = t->next.load(std::memory_order_acquire);
+  if(next != nullptr) {
+    tail = next;
+    return t;
+  }
+  return nullptr;
+}
+
+// drain任务被丢弃而没有执行(clearTasks、cancelTask竞争、线程池销毁)时 计数会永远停在非0
+// 最后一个副本析构时持有调度权的仍是这次调度 和post失败一样丢弃已计数的任务并释放调度权
+struct Strand::DrainGuard {
+  std::shared_ptr<Strand> self;
+  bool armed = true;
+
+  explicit DrainGuard(std::shared_ptr<Strand> self) : self(std::move(self)) {}
+
+  ~DrainGuard() {
+    if(armed) {
+      self->discardPending();
+    }
+  }
+};
+
+void Strand::schedule() {
+  auto guard = std::make_shared<DrainGuard>(shared_from_this());
+  try {
+    pool.post(priority, [guard]() {
+      guard->armed = false;
+      guard->self->run();
+    });
+  } catch(...) {
+    //投递失败由调用方处理 这里不能重复丢弃
+    guard->armed = false;
+    throw;
+  }
+}
+
+void Strand::run() {
+  for(size_t executed = 1; ; ++executed) {
+    //pendingCount > 0 保证队列里至少有一个节点 拿不到只可能是生产者还没链接完 短暂自旋即可
+    Node* node = pop();
+    while(node == nullptr) {
+      std::this_thread::yield();
+      node = pop();
+    }
+
+    try {
+      node->task();
+    } catch(...) {
+      //post的任务自行处理异常 需要结果请使用enqueue
+    }
+    delete node;
+
+    //最后一个任务执行完 下一个生产者会重新调度
+    if(pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      return;
+    }
+
+    if(executed >= kBatchSize) {
+      try {
+        schedule();
+        return;
+      } catch(...) {
+        //线程池正在停止 无法重新排队 留在当前工作线程上继续执行
+        executed = 0;
+      }
+    }
+  }
+}
@@ -0,0 +1,128 @@
+#include "TaskAccounting.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <time.h>
+#include <sys/resource.h>
+
+ThreadUsageSample ThreadUsageSample::now() {
+  ThreadUsageSample sample;
+  timespec ts;
+  if(::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    sample.cpuNs = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+  }
+#ifdef RUSAGE_THREAD
+  rusage usage;
+  if(::getrusage(RUSAGE_THREAD, &usage) == 0) {
+    sample.voluntarySwitches = usage.ru_nvcsw;
+    sample.involuntarySwitches = usage.ru_nivcsw;
+  }
+#endif
+  return sample;
+}
+
+// 连续的数字替换为一个'#' 没有数字时原样返回
+std::string TaskAccounting::normalizeCategory(const std::string& description) {
+  auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+  if(std::none_of(description.begin(), description.end(), isDigit)) {
+    return description;
+  }
+  std::string normalized;
+  normalized.reserve(description.size());
+  for(size_t i = 0; i < description.size(); ++i) {
+    if(!isDigit(description[i])) {
+      normalized += description[i];
+    } else if(i == 0 || !isDigit(description[i - 1])) {
+      normalized += '#';
+    }
+  }
+  return normalized;
+}
+
+void TaskAccounting::setMaxCategories(size_t limit) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  maxCategories = limit;
+}
+
+const std::string& TaskAccounting::admit(const std::string& category) {
+  static const std::string overflow = kOverflowCategory;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  if(knownCategories.count(category) != 0) {
+    return category;
+  }
+  if(knownCategories.size() >= maxCategories) {
+    return overflow;
+  }
+  knownCategories.insert(category);
+  return category;
+}
+
+void TaskAccounting::record(size_t workerId, const std::string& description, uint64_t wallNs,
+                            const ThreadUsageSample& begin, const ThreadUsageSample& end) {
+  std::string category = normalizeCategory(description);
+  Shard& shard = shards[workerId % kShardCount];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.categories.find(category);
+  if(it == shard.categories.end()) {
+    const std::string& admitted = admit(category);
+    it = shard.categories.find(admitted);
+    if(it == shard.categories.end()) {
+      it = shard.categories.emplace(admitted, CategoryUsage()).first;
+      it->second.category = admitted;
+    }
+  }
+  CategoryUsage& usage = it->second;
+  usage.tasks += 1;
+  usage.wallNs += wallNs;
+  usage.cpuNs += end.cpuNs >= begin.cpuNs ? end.cpuNs - begin.cpuNs : 0;
+  usage.voluntarySwitches += static_cast<uint64_t>(std::max(0L, end.voluntarySwitches - begin.voluntarySwitches));
+  usage.involuntarySwitches += static_cast<uint64_t>(std::max(0L, end.involuntarySwitches - begin.involuntarySwitches));
+}
+
+std::vector<CategoryUsage> TaskAccounting::snapshot() const {
+  std::unordered_map<std::string, CategoryUsage> merged;
+  for(const Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for(const auto& entry : shard.categories) {
+      CategoryUsage& total = merged[entry.first];
+      total.category = entry.first;
+      total.tasks += entry.second.tasks;
+      total.wallNs += entry.second.wallNs;
+      total.cpuNs += entry.second.cpuNs;
+      total.voluntarySwitches += entry.second.voluntarySwitches;
+      total.involuntarySwitches += entry.second.involuntarySwitches;
+    }
+  }
+
+  std::vector<CategoryUsage> result;
+  result.reserve(merged.size());
+  for(auto& entry : merged) result.push_back(std::move(entry.second));
+  std::sort(result.begin(), result.end(), [](const CategoryUsage& a, const CategoryUsage& b) {
+    return a.wallNs > b.wallNs;
+  });
+  return result;
+}
+
+void TaskAccounting::reset() {
+  for(Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.categories.clear();
+  }
+  std::lock_guard<std::mutex> lock(registryMutex);
+  knownCategories.clear();
+}
+
+std::string TaskAccounting::getReport() const {
+  std::stringstream ss;
+  ss << "任务资源使用(按类别):" << std::endl;
+  for(const CategoryUsage& usage : snapshot()) {
+    double wallMs = static_cast<double>(usage.wallNs) / 1e6;
+    double cpuMs = static_cast<double>(usage.cpuNs) / 1e6;
+    ss << "  " << usage.category << ": " << usage.tasks << " 个任务, 墙钟 " << std::fixed
+       << std::setprecision(2) << wallMs << " 毫秒, CPU " << cpuMs << " 毫秒 ("
+       << usage.cpuRatio() * 100.0 << "%), 主动切换 " << usage.voluntarySwitches
+       << ", 被动切换 " << usage.involuntarySwitches << std::endl;
+    ss.unsetf(std::ios::floatfield);
+  }
+  return ss.str();
+}
@@ -0,0 +1,187 @@
+#include "TaskAllocator.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 大小分级: 16, 32, 64, ..., 1024
+constexpr size_t kClassCount = 7;
+
+size_t sizeClassOf(size_t size) {
+  size_t cls = 0;
+  size_t blockSize = SlabAllocator::kMinBlockSize;
+  while(blockSize < size) {
+    blockSize <<= 1;
+    ++cls;
+  }
+  return cls;
+}
+
+size_t blockSizeOf(size_t cls) {
+  return SlabAllocator::kMinBlockSize << cls;
+}
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct ThreadCache;
+
+// slab头部 放在每个slab的起始位置
+struct SlabHeader {
+  ThreadCache* owner;
+  size_t sizeClass;
+};
+
+struct ThreadCache {
+  FreeBlock* localFree[kClassCount] = {};
+  std::atomic<FreeBlock*> remoteFree[kClassCount] = {};
+};
+
+std::atomic<size_t> totalSlabs{0};
+std::atomic<size_t> totalRemoteFrees{0};
+
+// 线程退出时缓存不会销毁(其他线程可能还持有它分配的块) 放入这里等待新线程接管
+std::mutex abandonedMutex;
+std::vector<ThreadCache*> abandonedCaches;
+
+ThreadCache* acquireCache() {
+  {
+    std::lock_guard<std::mutex> lock(abandonedMutex);
+    if(!abandonedCaches.empty()) {
+      ThreadCache* cache = abandonedCaches.back();
+      abandonedCaches.pop_back();
+      return cache;
+    }
+  }
+  return new ThreadCache;
+}
+
+// 本线程的缓存 平凡类型的thread_local没有析构顺序问题 线程退出过程中仍可读取
+thread_local ThreadCache* currentCache = nullptr;
+thread_local bool cacheAbandoned = false;
+
+// 线程退出时交出缓存 之后(其他thread_local的析构函数里)释放的块走跨线程路径 分配借用交出的缓存
+struct CacheHolder {
+  bool registered = false;
+  ~CacheHolder() {
+    cacheAbandoned = true;
+    if(currentCache != nullptr) {
+      std::lock_guard<std::mutex> lock(abandonedMutex);
+      abandonedCaches.push_back(currentCache);
+      currentCache = nullptr;
+    }
+  }
+};
+
+thread_local CacheHolder cacheHolder;
+
+// 线程已交出缓存时返回nullptr
+ThreadCache* localCache() {
+  if(currentCache == nullptr && !cacheAbandoned) {
+    currentCache = acquireCache();
+    cacheHolder.registered = true;   //构造holder 线程退出时才会交出缓存
+  }
+  return currentCache;
+}
+
+SlabHeader* slabOf(void* p) {
+  auto addr = reinterpret_cast<uintptr_t>(p);
+  return reinterpret_cast<SlabHeader*>(addr & ~(static_cast<uintptr_t>(SlabAllocator::kSlabSize) - 1));
+}
+
+// 新建slab并把所有块串进本地空闲链表
+void refillFromNewSlab(ThreadCache* cache, size_t cls) {
+  void* mem = ::operator new(SlabAllocator::kSlabSize, std::align_val_t(SlabAllocator::kSlabSize));
+  auto* header = static_cast<SlabHeader*>(mem);
+  header->owner = cache;
+  header->sizeClass = cls;
+  totalSlabs.fetch_add(1, std::memory_order_relaxed);
+
+  size_t blockSize = blockSizeOf(cls);
+  //第一个块从头部之后按块大小对齐开始
+  size_t offset = (sizeof(SlabHeader) + blockSize - 1) / blockSize * blockSize;
+  char* base = static_cast<char*>(mem);
+  FreeBlock* list = cache->localFree[cls];
+  for(size_t off = SlabAllocator::kSlabSize - blockSize; off >= offset; off -= blockSize) {
+    auto* block = reinterpret_cast<FreeBlock*>(base + off);
+    block->next = list;
+    list = block;
+  }
+  cache->localFree[cls] = list;
+}
+
+}  // namespace
+
+namespace {
+
+void* allocateFrom(ThreadCache* cache, size_t cls) {
+  FreeBlock* block = cache->localFree[cls];
+  if(block == nullptr) {
+    //本地用尽 先一次性取回其他线程归还的块
+    block = cache->remoteFree[cls].exchange(nullptr, std::memory_order_acquire);
+    if(block == nullptr) {
+      refillFromNewSlab(cache, cls);
+      block = cache->localFree[cls];
+    }
+  }
+  cache->localFree[cls] = block->next;
+  return block;
+}
+
+}  // namespace
+
+void* SlabAllocator::allocate(size_t size) {
+  if(size > kMaxBlockSize) {
+    return ::operator new(size);
+  }
+  size_t cls = sizeClassOf(size);
+  ThreadCache* cache = localCache();
+  if(cache != nullptr) {
+    return allocateFrom(cache, cls);
+  }
+
+  //线程退出阶段: 持锁从交出的缓存中分配 锁内没有其他线程能接管它
+  std::lock_guard<std::mutex> lock(abandonedMutex);
+  if(abandonedCaches.empty()) {
+    abandonedCaches.push_back(new ThreadCache);
+  }
+  return allocateFrom(abandonedCaches.back(), cls);
+}
+
+void SlabAllocator::deallocate(void* p, size_t size) noexcept {
+  if(p == nullptr) return;
+  if(size > kMaxBlockSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  SlabHeader* header = slabOf(p);
+  size_t cls = header->sizeClass;
+  auto* block = static_cast<FreeBlock*>(p);
+  ThreadCache* owner = header->owner;
+
+  if(owner == currentCache) {
+    block->next = owner->localFree[cls];
+    owner->localFree[cls] = block;
+    return;
+  }
+
+  //跨线程释放: 压入所属缓存的无锁栈(只有所属线程整体取走 不存在ABA)
+  FreeBlock* top = owner->remoteFree[cls].load(std::memory_order_relaxed);
+  do {
+    block->next = top;
+  } while(!owner->remoteFree[cls].compare_exchange_weak(top, block,
+            std::memory_order_release, std::memory_order_relaxed));
+  totalRemoteFrees.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t SlabAllocator::slabCount() {
+  return totalSlabs.load(std::memory_order_relaxed);
+}
+
+size_t SlabAllocator::remoteFreeCount() {
+  return totalRemoteFrees.load(std::memory_order_relaxed);
+}
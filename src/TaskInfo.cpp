@@ -20,6 +20,10 @@ bool TaskInfo::operator<(const TaskInfo& other) const {
   if(priority != other.priority) {
     return priority < other.priority;
   }
+  //同一优先级内按租户公平排队的虚拟结束时间 没有租户时tag随提交顺序递增
+  if(fairTag != other.fairTag) {
+    return fairTag > other.fairTag;
+  }
 
   return submitTime > other.submitTime; //FIFO
 }
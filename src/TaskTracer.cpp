@@ -0,0 +1,273 @@
+#include "TaskTracer.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kTraceMagic[8] = {'T', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr uint32_t kTraceVersion = 1;
+
+// 存储布局: [文件头 64字节][环0头 64字节][环0事件]...[环N头][环N事件]
+// 最后一个环是外部环(非工作线程)
+struct TraceFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t ringCount;
+  uint64_t capacity;
+  uint64_t reserved[5];
+};
+
+struct alignas(64) TraceRingHeader {
+  std::atomic<uint64_t> head;
+};
+
+static_assert(sizeof(TraceFileHeader) == 64, "trace header must be 64 bytes");
+static_assert(sizeof(TraceRingHeader) == 64, "ring header must be one cache line");
+static_assert(sizeof(TraceEvent) == 32, "trace event must be 32 bytes");
+
+size_t ringStride(uint64_t capacity) {
+  return sizeof(TraceRingHeader) + capacity * sizeof(TraceEvent);
+}
+
+TraceRingHeader* ringAt(void* base, uint64_t capacity, size_t index) {
+  return reinterpret_cast<TraceRingHeader*>(
+    static_cast<char*>(base) + sizeof(TraceFileHeader) + index * ringStride(capacity));
+}
+
+const TraceRingHeader* ringAt(const void* base, uint64_t capacity, size_t index) {
+  return ringAt(const_cast<void*>(base), capacity, index);
+}
+
+const TraceEvent* eventsOf(const TraceRingHeader* ring) {
+  return reinterpret_cast<const TraceEvent*>(ring + 1);
+}
+
+const char* eventName(TraceEventType type) {
+  switch(type) {
+    case TraceEventType::SUBMIT:  return "submit";
+    case TraceEventType::DEQUEUE: return "dequeue";
+    case TraceEventType::START:   return "task";
+    case TraceEventType::END:     return "task";
+    case TraceEventType::CANCEL:  return "cancel";
+    case TraceEventType::TIMEOUT: return "timeout";
+    default:                      return "unknown";
+  }
+}
+
+bool validHeader(const void* base, size_t bytes) {
+  if(bytes < sizeof(TraceFileHeader)) return false;
+  auto* header = static_cast<const TraceFileHeader*>(base);
+  if(std::memcmp(header->magic, kTraceMagic, sizeof(kTraceMagic)) != 0) return false;
+  if(header->version != kTraceVersion || header->ringCount == 0) return false;
+  return sizeof(TraceFileHeader) + header->ringCount * ringStride(header->capacity) <= bytes;
+}
+
+// 把存储中的所有环导出为Chrome trace JSON 时间戳相对最早事件 单位微秒
+void writeChromeTraceFrom(const void* base, std::ostream& out) {
+  auto* header = static_cast<const TraceFileHeader*>(base);
+  uint64_t capacity = header->capacity;
+  uint32_t ringCount = header->ringCount;
+
+  uint64_t minTs = UINT64_MAX;
+  for(uint32_t r = 0; r < ringCount; ++r) {
+    const TraceRingHeader* ring = ringAt(base, capacity, r);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t count = head < capacity ? head : capacity;
+    for(uint64_t i = head - count; i < head; ++i) {
+      const TraceEvent& e = eventsOf(ring)[i & (capacity - 1)];
+      if(e.timestampNs != 0 && e.timestampNs < minTs) minTs = e.timestampNs;
+    }
+  }
+  if(minTs == UINT64_MAX) minTs = 0;
+
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  for(uint32_t r = 0; r < ringCount; ++r) {
+    if(!first) out << ",\n";
+    first = false;
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << r
+        << ",\"args\":{\"name\":\"";
+    if(r + 1 == ringCount) {
+      out << "external";
+    } else {
+      out << "worker " << r;
+    }
+    out << "\"}}";
+  }
+
+  for(uint32_t r = 0; r < ringCount; ++r) {
+    const TraceRingHeader* ring = ringAt(base, capacity, r);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t count = head < capacity ? head : capacity;
+    for(uint64_t i = head - count; i < head; ++i) {
+      const TraceEvent& e = eventsOf(ring)[i & (capacity - 1)];
+      if(e.timestampNs == 0) continue;
+
+      const char* phase = "i";
+      if(e.type == TraceEventType::START) phase = "B";
+      if(e.type == TraceEventType::END) phase = "E";
+
+      out << ",\n{\"name\":\"" << eventName(e.type) << "\",\"ph\":\"" << phase << "\"";
+      if(phase[0] == 'i') out << ",\"s\":\"t\"";
+      out << ",\"ts\":" << static_cast<double>(e.timestampNs - minTs) / 1000.0
+          << ",\"pid\":1,\"tid\":" << r
+          << ",\"args\":{\"task\":" << e.taskHandle
+          << ",\"priority\":" << static_cast<int>(e.priority)
+          << ",\"worker\":" << static_cast<int64_t>(e.workerId == UINT32_MAX ? -1 : e.workerId)
+          << "}}";
+    }
+  }
+  out << "\n]}\n";
+}
+
+uint64_t roundUpPowerOfTwo(uint64_t n) {
+  uint64_t p = 1;
+  while(p < n) p <<= 1;
+  return p;
+}
+
+}  // namespace
+
+
+TaskTracer::~TaskTracer() {
+  enabled.store(false);
+  void* current = storage.load(std::memory_order_relaxed);
+  if(current != nullptr) {
+    release(Storage{current, storageBytes, mapped});
+  }
+  for(const Storage& block : retired) {
+    release(block);
+  }
+}
+
+bool TaskTracer::enable(size_t workerRings, size_t eventsPerRing, const std::string& mappedFile) {
+  enabled.store(false);
+
+  uint64_t capacity = roundUpPowerOfTwo(eventsPerRing == 0 ? 1 : eventsPerRing);
+  uint32_t ringCount = static_cast<uint32_t>(workerRings + 1);
+  size_t bytes = sizeof(TraceFileHeader) + ringCount * ringStride(capacity);
+
+  void* block = nullptr;
+  bool blockMapped = false;
+  if(mappedFile.empty()) {
+    block = ::operator new(bytes, std::align_val_t(64));
+    std::memset(block, 0, bytes);
+  } else {
+    //旧映射可能指向同名文件 截断它会让仍在写旧存储的线程收到SIGBUS 所以换成新文件
+    ::unlink(mappedFile.c_str());
+    int fd = ::open(mappedFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    if(::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      ::close(fd);
+      return false;
+    }
+    void* mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mem == MAP_FAILED) return false;
+    block = mem;   //ftruncate出来的文件内容全为0
+    blockMapped = true;
+  }
+
+  auto* header = static_cast<TraceFileHeader*>(block);
+  std::memcpy(header->magic, kTraceMagic, sizeof(kTraceMagic));
+  header->version = kTraceVersion;
+  header->ringCount = ringCount;
+  header->capacity = capacity;
+  for(uint32_t r = 0; r < ringCount; ++r) {
+    new (ringAt(block, capacity, r)) TraceRingHeader{};
+  }
+
+  //禁用后仍可能有线程在record()里使用旧存储 不能释放
+  void* previous = storage.load(std::memory_order_relaxed);
+  if(previous != nullptr) {
+    retired.push_back(Storage{previous, storageBytes, mapped});
+  }
+  storageBytes = bytes;
+  mapped = blockMapped;
+  storage.store(block, std::memory_order_release);
+  enabled.store(true);
+  return true;
+}
+
+void TaskTracer::disable() {
+  enabled.store(false);
+  void* current = storage.load(std::memory_order_acquire);
+  if(mapped && current != nullptr) {
+    ::msync(current, storageBytes, MS_ASYNC);
+  }
+}
+
+void TaskTracer::release(const Storage& block) {
+  if(block.mapped) {
+    ::munmap(block.base, block.bytes);
+  } else {
+    ::operator delete(block.base, std::align_val_t(64));
+  }
+}
+
+void TaskTracer::record(TraceEventType type, size_t workerId, uint64_t taskHandle,
+                        TaskPriority priority) noexcept {
+  //enabled为true时storage一定已发布 读到的旧存储在析构前一直有效
+  void* base = storage.load(std::memory_order_acquire);
+  auto* header = static_cast<TraceFileHeader*>(base);
+  uint32_t externalRing = header->ringCount - 1;
+  size_t ringIndex = workerId < externalRing ? workerId : externalRing;
+  TraceRingHeader* ring = ringAt(base, header->capacity, ringIndex);
+
+  //工作线程环上基本没有竞争 外部环可能有多个提交线程 统一用fetch_add占位
+  uint64_t slot = ring->head.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent& e = const_cast<TraceEvent*>(eventsOf(ring))[slot & (header->capacity - 1)];
+  e.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+  e.taskHandle = taskHandle;
+  e.workerId = workerId < UINT32_MAX ? static_cast<uint32_t>(workerId) : UINT32_MAX;
+  e.type = type;
+  e.priority = static_cast<uint8_t>(priority);
+}
+
+void TaskTracer::writeChromeTrace(std::ostream& out) const {
+  const void* base = storage.load(std::memory_order_acquire);
+  if(base == nullptr) {
+    out << "{\"traceEvents\":[]}\n";
+    return;
+  }
+  writeChromeTraceFrom(base, out);
+}
+
+bool TaskTracer::writeChromeTrace(const std::string& path) const {
+  std::ofstream out(path);
+  if(!out.is_open()) return false;
+  writeChromeTrace(out);
+  return out.good();
+}
+
+bool TaskTracer::convertMappedFile(const std::string& binPath, const std::string& jsonPath) {
+  int fd = ::open(binPath.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+  size_t bytes = static_cast<size_t>(st.st_size);
+  void* mem = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if(mem == MAP_FAILED) return false;
+
+  bool ok = false;
+  if(validHeader(mem, bytes)) {
+    std::ofstream out(jsonPath);
+    if(out.is_open()) {
+      writeChromeTraceFrom(mem, out);
+      ok = out.good();
+    }
+  }
+  ::munmap(mem, bytes);
+  return ok;
+}
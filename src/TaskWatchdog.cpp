@@ -0,0 +1,182 @@
+#include "TaskWatchdog.h"
+#include <algorithm>
+
+TaskWatchdog::TaskWatchdog(std::vector<size_t> ids) {
+  for(size_t id : ids) {
+    slotFor(id);
+  }
+}
+
+WorkerSlot& TaskWatchdog::slotFor(size_t workerId) {
+  std::lock_guard<std::mutex> lock(slotsMutex);
+  auto it = slotIndex.find(workerId);
+  if(it != slotIndex.end()) {
+    return *slots[it->second];
+  }
+  slotIndex.emplace(workerId, slots.size());
+  slots.push_back(std::make_unique<WorkerSlot>());
+  workerIds.push_back(workerId);
+  registeredSlots.store(slots.size(), std::memory_order_release);
+  return *slots.back();
+}
+
+TaskWatchdog::~TaskWatchdog() {
+  stop();
+}
+
+int64_t TaskWatchdog::nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TaskWatchdog::start(const WatchdogOptions& opts, StuckHandler stuckHandler,
+                         RecoveredHandler recoveredHandler) {
+  stop();
+  options = opts;
+  if(options.scanInterval.count() <= 0) {
+    options.scanInterval = std::chrono::milliseconds(1);
+  }
+  onStuck = std::move(stuckHandler);
+  onRecovered = std::move(recoveredHandler);
+  {
+    std::lock_guard<std::mutex> lock(loopMutex);
+    stopRequested = false;
+  }
+  running.store(true, std::memory_order_release);
+  thread = std::thread([this]() { loop(); });
+}
+
+void TaskWatchdog::stop() {
+  {
+    std::lock_guard<std::mutex> lock(loopMutex);
+    stopRequested = true;
+  }
+  loopCondition.notify_all();
+  if(thread.joinable()) {
+    thread.join();
+  }
+  running.store(false, std::memory_order_release);
+
+  for(Tracked& t : tracked) {
+    release(t);
+  }
+  onStuck = nullptr;
+  onRecovered = nullptr;
+}
+
+// 被跟踪的任务结束(或停止跟踪) 从卡住列表中移除并通知
+void TaskWatchdog::release(Tracked& t) {
+  if(t.reported) {
+    {
+      std::lock_guard<std::mutex> lock(stuckMutex);
+      stuck.erase(std::remove_if(stuck.begin(), stuck.end(), [&t](const StuckTaskInfo& entry) {
+        return entry.sequence == t.sequence;
+      }), stuck.end());
+    }
+    if(onRecovered) onRecovered(t.info);
+  }
+  t = Tracked();
+}
+
+std::vector<StuckTaskInfo> TaskWatchdog::stuckTasks() const {
+  std::lock_guard<std::mutex> lock(stuckMutex);
+  return stuck;
+}
+
+void TaskWatchdog::loop() {
+  std::unique_lock<std::mutex> lock(loopMutex);
+  while(!stopRequested) {
+    loopCondition.wait_for(lock, options.scanInterval, [this]() { return stopRequested; });
+    if(stopRequested) break;
+    lock.unlock();
+    scan();
+    lock.lock();
+  }
+}
+
+void TaskWatchdog::scan() {
+  //有新登记的槽位时才加锁复制 槽位本身在登记后地址不变
+  if(scanSlots.size() != registeredSlots.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(slotsMutex);
+    for(size_t i = scanSlots.size(); i < slots.size(); ++i) {
+      scanSlots.push_back(slots[i].get());
+      scanWorkerIds.push_back(workerIds[i]);
+    }
+    tracked.resize(scanSlots.size());
+  }
+
+  const int64_t now = nowNs();
+  const int64_t thresholdNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    options.stuckThreshold).count();
+
+  for(size_t i = 0; i < scanSlots.size(); ++i) {
+    WorkerSlot& s = *scanSlots[i];
+    Tracked& t = tracked[i];
+
+    uint64_t sequence = 0;
+    int64_t startNs = 0;
+    int64_t timeoutNs = 0;
+    std::function<void()> timeoutHandler;
+    StuckTaskInfo info;
+
+    // 与WorkerSlot::end握手: 置位后读到的任务指针在清除之前保证存活
+    s.inspecting.store(true, std::memory_order_seq_cst);
+    TaskInfo* task = s.task.load(std::memory_order_seq_cst);
+    if(task != nullptr) {
+      sequence = task->sequence;
+      startNs = s.startNs.load(std::memory_order_relaxed);
+      timeoutNs = std::chrono::duration_cast<std::chrono::nanoseconds>(task->timeout).count();
+      if(sequence == t.sequence) {
+        // 同一个任务 只复制本轮需要的字段
+        if(!t.timeoutFired && timeoutNs > 0 && now - startNs >= timeoutNs) {
+          timeoutHandler = task->onTimeout;
+        }
+      } else {
+        if(timeoutNs > 0 && now - startNs >= timeoutNs) {
+          timeoutHandler = task->onTimeout;
+        }
+        info.taskId = task->taskId;
+        info.description = task->description;
+        info.priority = task->priority;
+        info.timeout = task->timeout;
+      }
+    }
+    s.inspecting.store(false, std::memory_order_release);
+
+    // 上一个被跟踪的任务已经结束
+    if(t.sequence != 0 && t.sequence != sequence) {
+      release(t);
+    }
+    if(task == nullptr) continue;
+
+    if(t.sequence != sequence) {
+      t.sequence = sequence;
+      t.info = std::move(info);
+      t.info.workerId = scanWorkerIds[i];
+      t.info.sequence = sequence;
+    }
+
+    const int64_t elapsed = now - startNs;
+    if(timeoutHandler) {
+      t.timeoutFired = true;
+      timeoutHandler();
+    } else if(timeoutNs > 0 && elapsed >= timeoutNs) {
+      t.timeoutFired = true;   // 没有超时回调(看门狗启动前提交的任务) 只报告
+    }
+
+    t.info.runningFor = std::chrono::milliseconds(std::max<int64_t>(elapsed, 0) / 1000000);
+    bool overLimit = (timeoutNs > 0 && elapsed >= timeoutNs) ||
+                     (thresholdNs > 0 && elapsed >= thresholdNs);
+    if(overLimit && !t.reported) {
+      t.reported = true;
+      t.info.replaced = onStuck ? onStuck(t.info) : false;
+      std::lock_guard<std::mutex> lock(stuckMutex);
+      stuck.push_back(t.info);
+    } else if(t.reported) {
+      std::lock_guard<std::mutex> lock(stuckMutex);
+      for(StuckTaskInfo& entry : stuck) {
+        if(entry.sequence == sequence) entry.runningFor = t.info.runningFor;
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+#include "TenantScheduler.h"
+#include <algorithm>
+#include <sstream>
+
+TenantScheduler::TenantScheduler() : defaultTenant("") {}
+
+std::shared_ptr<TenantState> TenantScheduler::get(const std::string& tenant) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = tenants.find(tenant);
+  if(it != tenants.end()) {
+    return it->second;
+  }
+  size_t count = tenants.size() - tenants.count(kOverflowTenant);
+  const std::string& name = count < maxTenants ? tenant : kOverflowTenant;
+  std::shared_ptr<TenantState>& state = tenants[name];
+  if(!state) {
+    state = std::make_shared<TenantState>(name);
+  }
+  return state;
+}
+
+std::shared_ptr<TenantState> TenantScheduler::revalidate(std::shared_ptr<TenantState> state) {
+  if(!state->removed) {
+    return state;
+  }
+  return get(state->name);
+}
+
+bool TenantScheduler::isOverflow(const TenantState& state, const std::string& tenant) const {
+  return state.name != tenant;
+}
+
+void TenantScheduler::setMaxTenants(size_t limit) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  maxTenants = limit;
+}
+
+bool TenantScheduler::remove(const std::string& tenant) {
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto it = tenants.find(tenant);
+  if(it == tenants.end() || it->second->queued.load(std::memory_order_relaxed) > 0) {
+    return false;
+  }
+  it->second->removed = true;
+  tenants.erase(it);
+  return true;
+}
+
+void TenantScheduler::setWeight(const std::shared_ptr<TenantState>& tenant, double weight) {
+  tenant->weight.store(weight, std::memory_order_relaxed);
+}
+
+double TenantScheduler::enqueue(TenantState* tenant, TaskPriority priority) {
+  TenantState& state = tenant ? *tenant : defaultTenant;
+  size_t p = static_cast<size_t>(priority);
+  double start = std::max(virtualTime[p], state.lastTag[p]);
+  state.lastTag[p] = start + 1.0 / state.weight.load(std::memory_order_relaxed);
+  state.queued.fetch_add(1, std::memory_order_relaxed);
+  return state.lastTag[p];
+}
+
+void TenantScheduler::dequeue(TenantState* tenant, TaskPriority priority, double tag) {
+  TenantState& state = tenant ? *tenant : defaultTenant;
+  size_t p = static_cast<size_t>(priority);
+  virtualTime[p] = std::max(virtualTime[p], tag);
+  state.queued.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void TenantScheduler::clear() {
+  std::fill(std::begin(virtualTime), std::end(virtualTime), 0.0);
+  auto reset = [](TenantState& state) {
+    std::fill(std::begin(state.lastTag), std::end(state.lastTag), 0.0);
+    state.queued.store(0, std::memory_order_relaxed);
+  };
+  reset(defaultTenant);
+  std::lock_guard<std::mutex> lock(registryMutex);
+  for(auto& entry : tenants) {
+    reset(*entry.second);
+  }
+}
+
+std::vector<TenantStats> TenantScheduler::snapshot() const {
+  std::vector<std::shared_ptr<TenantState>> states;
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(const auto& entry : tenants) {
+      states.push_back(entry.second);
+    }
+  }
+  //拷贝直方图在锁外进行
+  std::vector<TenantStats> result(states.size());
+  for(size_t i = 0; i < states.size(); ++i) {
+    const TenantState& state = *states[i];
+    TenantStats& stats = result[i];
+    stats.tenant = state.name;
+    stats.weight = state.weight.load(std::memory_order_relaxed);
+    stats.queued = state.queued.load(std::memory_order_relaxed);
+    stats.submitted = state.submitted.load(std::memory_order_relaxed);
+    stats.completed = state.completed.load(std::memory_order_relaxed);
+    state.wait.addTo(stats.wait);
+    state.endToEnd.addTo(stats.endToEnd);
+  }
+  return result;
+}
+
+std::string TenantScheduler::getReport() const {
+  std::ostringstream out;
+  for(const TenantStats& stats : snapshot()) {
+    out << "  租户 " << stats.tenant << " (权重 " << stats.weight << "): 完成 " << stats.completed
+        << "/" << stats.submitted << ", 排队 " << stats.queued
+        << ", 排队时间p99 " << stats.wait.percentile(99) / 1000.0 << " 微秒\n";
+  }
+  return out.str();
+}
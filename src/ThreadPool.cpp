@@ -1,47 +1,147 @@
 #include "ThreadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 
+namespace {
+
+// 当前线程在线程池中的身份 非工作线程为kExternalWorkerId
+thread_local size_t currentWorkerId = ThreadPool::kExternalWorkerId;
+// 当前线程正在执行的任务句柄 超时处理等在任务内部调用的路径用它关联追踪事件
+thread_local uint64_t currentTaskHandle = 0;
+thread_local TaskPriority currentTaskPriority = TaskPriority::MEDIUM;
+// 当前线程所属的线程池 与currentWorkerId一起确定在某个线程池中的身份
+thread_local const ThreadPool* currentPool = nullptr;
+
+// 当前线程上正在执行的任务 帮助等待时任务可以嵌套执行 用链表记录每一层
+struct RunningTaskFrame {
+    const ThreadPool* pool;
+    const RunningTaskFrame* outer;
+    uint64_t savedHandle;
+    TaskPriority savedPriority;
+};
+thread_local const RunningTaskFrame* runningTasks = nullptr;
+thread_local size_t runningDepth = 0;
+
+// 在本线程上认领了溢出读回的线程池 下一次executeTask开始时在锁外执行
+thread_local const ThreadPool* spillReloadOwner = nullptr;
+
+// 工作线程在看门狗上的槽位 看门狗随线程池销毁 工作线程不会比它活得更久
+thread_local const TaskWatchdog* cachedWatchdog = nullptr;
+thread_local size_t cachedWatchdogWorker = 0;
+thread_local WorkerSlot* cachedWatchdogSlot = nullptr;
+
+// 预热创建的线程第一次进入等待时通知prewarm
+thread_local bool prewarmAnnouncePending = false;
+
+// 当前线程的nice值缓存 按任务调整时相同的值不做系统调用
+thread_local int currentNice = 0;
+thread_local bool niceAdjustFailed = false;
+
+}  // namespace
+
 // 构造函数
 ThreadPool::ThreadPool(size_t threads, LogLevel logLevel, bool consoleLog, const std::string& logFile)
+    : ThreadPool(threads, WorkerStartOptions(), logLevel, consoleLog, logFile) {
+}
+
+ThreadPool::ThreadPool(size_t threads, const WorkerStartOptions& startOptions, LogLevel logLevel,
+                       bool consoleLog, const std::string& logFile)
     : maxThreads(std::max(threads * 2, static_cast<size_t>(std::thread::hardware_concurrency())))
-    , logger(logLevel, consoleLog, logFile) {
+    , logger(logLevel, consoleLog, logFile)
+    , rateLimiter([this](std::vector<std::shared_ptr<TaskInfo>>&& released) {
+          releaseRateLimited(std::move(released));
+      }) {
+    metrics.rateLimiter = &rateLimiter;
+    metrics.tenants = &tenantScheduler;
 
     // 确保初始线程数不超过最大线程数
     threads = std::min(threads, maxThreads);
-    logger.log(LogLevel::INFO, "线程池创建，工作线程数: " + std::to_string(threads) +
-        ", 最大线程数: " + std::to_string(maxThreads));
+    TP_LOG(logger, LogLevel::INFO, "线程池创建，工作线程数: " + std::to_string(threads) +
+        ", 最大线程数: " + std::to_string(maxThreads) + (startOptions.lazyStart ? " (按需创建)" : ""));
+
+    auto lock = lockQueue(LockSite::OTHER);
+    targetThreads = threads;
+    lazyStart = startOptions.lazyStart;
+    workerStackSize = startOptions.stackSize;
+    scheduling = startOptions.scheduling;
+    if(scheduling.perTaskNice && !scheduling.shared.isRealtime()) {
+        //nice值调高后调不回来 之后的高优先级任务都会以低优先级任务的nice值运行 不如不调整
+        const int* taskNice = scheduling.taskNice;
+        int lowest = *std::min_element(taskNice, taskNice + kPriorityCount);
+        int highest = *std::max_element(taskNice, taskNice + kPriorityCount);
+        if(lowest != highest && !canLowerNiceTo(lowest)) {
+            scheduling.perTaskNice = false;
+            TP_LOG(logger, LogLevel::WARN, "没有CAP_SYS_NICE且RLIMIT_NICE不允许把nice值调回 " +
+                std::to_string(lowest) + " 已关闭按任务调整nice值");
+        }
+    }
+    if(!lazyStart) {
+        workers.reserve(threads);
+        for(size_t i = 0; i < threads; ++i) {
+            spawnWorker(i);
+        }
+    }
+    updateThreadCount();
+    lock.unlock();
 
-    for(size_t i = 0; i < threads; ++i) {
-        workers.emplace_back(
-            [this, i]() { this->workerThread(i);});
+    if(startOptions.reservedWorkers > 0) {
+        setReservedWorkers(startOptions.reservedWorkers, startOptions.reservedMinPriority);
     }
 }
 
 ThreadPool::~ThreadPool() {
 
+    //先停止看门狗 关闭过程中不再启动替补线程
+    {
+        std::lock_guard<std::mutex> lock(watchdogMutex);
+        if(watchdog) {
+            watchdog->stop();
+        }
+    }
+    //限流器的定时线程会获取queue_mutex 在停止线程池之前结束 侧队列中的任务随之丢弃
+    rateLimiter.stop();
+    //不再从共享内存队列拉取 已取得但没有执行的共享任务在下面丢弃队列时回报失败
+    detachSharedQueue();
+
     {   //stop是atomic变量 为什么这里还要加锁？
         //此时mutex不是保护stop 而是为了保护condition.wait逻辑完成性
         //在condition.wait中 条件检查和进入等待之间不是原子操作
         //若不加锁 则可能出现有thread错过notify_all通知从而永远等待
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        auto lock = lockQueue(LockSite::OTHER);
         stop = true;
     }
-    logger.log(LogLevel::INFO, "线程池正在关闭...");
+    TP_LOG(logger, LogLevel::INFO, "线程池正在关闭...");
 
     condition.notify_all();
+    reservedCondition.notify_all();
 
-    for(std::thread& worker : workers){
+    for(WorkerThread& worker : workers){
         if(worker.joinable()) {
             worker.join();
         }
     }
+    for(WorkerThread& worker : reservedWorkers) {
+        if(worker.joinable()) {
+            worker.join();
+        }
+    }
+    reapTemporaryWorkers(true);
 
-    logger.log(LogLevel::INFO, "线程池关闭");
+    //没有执行的任务在这里销毁 而不是等到成员析构 任务记录析构时的回调(如共享任务回报失败)仍能使用线程池的成员
+    {
+        TaskQueue remaining;
+        std::swap(tasks, remaining);
+        taskIdMap.clear();
+    }
+
+    TP_LOG(logger, LogLevel::INFO, "线程池关闭");
 }
 
 // 设置最大线程数
 void ThreadPool::setMaxThreads(size_t max) {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::OTHER);
 
     // 不允许设置小于当前线程数的最大线程数
     if (max < workers.size()) {
@@ -49,7 +149,7 @@ void ThreadPool::setMaxThreads(size_t max) {
     }
 
     maxThreads = max;
-    logger.log(LogLevel::INFO, "设置最大线程数: " + std::to_string(maxThreads));
+    TP_LOG(logger, LogLevel::INFO, "设置最大线程数: " + std::to_string(maxThreads));
 }
 
 // 获取最大线程数
@@ -60,7 +160,9 @@ size_t ThreadPool::getMaxThreads() const {
 //需要检查自己是否能退出
 //现在每一个worker有一个唯一id 便于管理
 void ThreadPool::workerThread(size_t id) {
-    logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "启动");
+    currentWorkerId = id;
+    currentPool = this;
+    TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "启动");
 
     //无限循环运行
     while(true) {
@@ -71,105 +173,230 @@ void ThreadPool::workerThread(size_t id) {
         
         switch (result) {
             case TaskFetchResult::SHOULD_EXIT: return;
-            case TaskFetchResult::NO_TASK: continue;    //继续运行
+            case TaskFetchResult::NO_TASK: break;    //继续运行
             case TaskFetchResult::HAS_TASK:
                 if(taskPtr && taskPtr->task) {
                     executeTask(id, taskPtr);
                 }
                 break;
         }
+        reloadClaimedSpill();
     }
 }
 
-TaskFetchResult ThreadPool::getNextTask(size_t id, std::shared_ptr<TaskInfo>& taskPtr) {
-    std::unique_lock<std::mutex> lock(this->queue_mutex);
+// 创建常规工作线程 线程先完成启动准备再开始取任务
+void ThreadPool::spawnWorker(size_t id, size_t stackBytesToTouch, bool prewarmed) {
+    workers.emplace_back([this, id, stackBytesToTouch, prewarmed]() {
+        applyWorkerScheduling(id);
+        if(prewarmed) {
+            WorkerThread::prefaultStack(stackBytesToTouch);
+            prewarmAnnouncePending = true;
+        }
+        {
+            auto lock = lockQueue(LockSite::OTHER);
+            --startingWorkers;
+        }
+        this->workerThread(id);
+    }, workerStackSize);
+    ++startingWorkers;
+}
+
+// 排队任务多于空闲(或正在启动)的线程时补充线程 直到达到目标线程数
+void ThreadPool::spawnOnDemand() {
+    size_t before = workers.size();
+    while(workers.size() < targetThreads && tasks.size() > idleWorkers + startingWorkers) {
+        try {
+            spawnWorker(workers.size());
+        } catch(const std::system_error& e) {
+            TP_LOG(logger, LogLevel::ERROR, std::string("创建工作线程失败: ") + e.what());
+            break;
+        }
+    }
+    if(workers.size() != before) {
+        updateThreadCount();
+        TP_LOG(logger, LogLevel::DEBUG, "按需创建工作线程: " + std::to_string(before) +
+            " -> " + std::to_string(workers.size()));
+    }
+}
+
+// 创建剩余的工作线程并等待它们触碰完栈
+void ThreadPool::prewarm(size_t stackBytesToTouch) {
+    auto lock = lockQueue(LockSite::OTHER);
+    if(stop) {
+        return;
+    }
+    size_t before = workers.size();
+    while(workers.size() < targetThreads) {
+        spawnWorker(workers.size(), stackBytesToTouch, true);
+        ++prewarmPending;
+    }
+    updateThreadCount();
+    lock.wait(prewarmCondition, [this]() { return prewarmPending == 0 || stop; });
+    TP_LOG(logger, LogLevel::INFO, "预热工作线程: " + std::to_string(before) + " -> " +
+        std::to_string(workers.size()));
+}
 
-    condition.wait(lock, [this, id]() {
+TaskFetchResult ThreadPool::getNextTask(size_t id, std::shared_ptr<TaskInfo>& taskPtr) {
+    auto lock = lockQueue(LockSite::GET_NEXT_TASK);
+
+    ++idleWorkers;
+    //预热的线程在这里才算就绪: 已经计入空闲线程 接下来在条件变量上等待(等待会释放锁)
+    if(prewarmAnnouncePending) {
+        prewarmAnnouncePending = false;
+        if(--prewarmPending == 0) {
+            prewarmCondition.notify_all();
+        }
+    }
+    lock.wait(condition, [this, id]() {
         return this->stop ||    //线程池停止
             (!this->paused && !this->tasks.empty()) ||    //线程有任务要执行
-            (this->threadsToStop.find(id) != threadsToStop.end());  //线程池要清理该线程
+            (this->threadsToStop.find(id) != threadsToStop.end()) ||  //线程池要清理该线程
+            (isTemporaryWorker(id) && this->temporaryRetireRequests > 0);   //替补线程可以退休
     });
+    --idleWorkers;
 
     //停止 > 中止 > 有任务
     if(this->stop) {
-        logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(id) + " 停止(线程池关闭)");
+        TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(id) + " 停止(线程池关闭)");
         return TaskFetchResult::SHOULD_EXIT;
     }
 
     if(this->threadsToStop.find(id) != this->threadsToStop.end()) {
         this->threadsToStop.erase(id);
-        logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(id) + " 停止（线程池调整大小）");
+        TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(id) + " 停止（线程池调整大小）");
+        return TaskFetchResult::SHOULD_EXIT;
+    }
+
+    if(isTemporaryWorker(id) && this->temporaryRetireRequests > 0) {
+        --this->temporaryRetireRequests;
+        TP_LOG(logger, LogLevel::DEBUG, "替补线程 " + std::to_string(id - kTemporaryWorkerIdBase) + " 退休");
         return TaskFetchResult::SHOULD_EXIT;
     }
 
-    bool hasTask = false;
+    if(this->paused) {
+        return TaskFetchResult::NO_TASK;
+    }
+    taskPtr = popRunnableTask(id);
+    return taskPtr ? TaskFetchResult::HAS_TASK : TaskFetchResult::NO_TASK;
+}
 
-    //优先级队列不支持move操作
-    //CANCLED只能处理记录taskId的任务 
+std::shared_ptr<TaskInfo> ThreadPool::popRunnableTask(size_t id, TaskPriority minPriority) {
+    //队列中保存的是任务记录本身(共享指针) 取消操作直接修改记录状态
     //因为需要跳过CANCLED任务 所以这里要不断循环直到成功获取任务(不然只执行一次就睡太浪费了)
-    while(!this->tasks.empty() && !this->paused) {
-        TaskInfo task = this->tasks.top();
+    while(!this->tasks.empty() && this->tasks.top()->priority >= minPriority) {
+        std::shared_ptr<TaskInfo> taskPtr = this->tasks.top();
         this->tasks.pop();
+        metrics.updateQueueSize(this->tasks.size());
+        tenantScheduler.dequeue(taskPtr->tenant.get(), taskPtr->priority, taskPtr->fairTag);
+        //段文件的读取不在queue_mutex内进行 只认领 出队的线程在executeTask开始时(没有任务可执行时在释放锁后)读回
+        //跳过的已取消任务同样计入 否则队列可能在没有人认领的情况下被取空
+        if(spillThreshold > 0 && claimSpillReload()) {
+            spillReloadOwner = this;
+        }
 
-        if(!task.taskId.empty()) {
-            auto it = taskIdMap.find(task.taskId);
-            if(it != taskIdMap.end()) {
-                taskPtr = it->second;
-                if(taskPtr->status == TaskStatus::CANCELED) {
-                    logger.log(LogLevel::DEBUG, "跳过已经取消的任务 " + task.taskId);
-                    continue;   //继续尝试获取下一个任务
-                }
-            } 
-        } else {
-            taskPtr = std::make_shared<TaskInfo>(task);
+        if(taskPtr->status == TaskStatus::CANCELED) {
+            TP_LOG(logger, LogLevel::DEBUG, "跳过已经取消的任务 " + taskPtr->taskId);
+            continue;   //继续尝试获取下一个任务
         }
-        hasTask = true;
-        //记录日志
-        std::string taskDesc = taskPtr->taskId.empty() ? "匿名任务" : "任务" + taskPtr->taskId;
-        if(!taskPtr->description.empty()) {
-            taskDesc += " (" + taskPtr->description + ")";
+        TP_TRACE(tracer, TraceEventType::DEQUEUE, id, taskPtr->sequence, taskPtr->priority);
+        //记录日志 级别未开启时不拼接任何字符串
+        if(TP_LOG_ENABLED(logger, LogLevel::DEBUG)) {
+            std::string taskDesc = taskPtr->taskId.empty() ? "匿名任务" : "任务" + taskPtr->taskId;
+            if(!taskPtr->description.empty()) {
+                taskDesc += " (" + taskPtr->description + ")";
+            }
+            TP_LOG(logger, LogLevel::DEBUG, "工作线程" + std::to_string(id) + "开始执行 " + taskDesc);
         }
-        logger.log(LogLevel::DEBUG, "工作线程" + std::to_string(id) + "开始执行 " + taskDesc);      
-
-        break;
+        return taskPtr;
     }
-
-    return hasTask ? TaskFetchResult::HAS_TASK : TaskFetchResult::NO_TASK;
+    return nullptr;
 }
 
 void ThreadPool::executeTask(size_t id, std::shared_ptr<TaskInfo> taskPtr) {
-    ++metrics.activeThreads;  // 增加活跃线程计数
+    metrics.threadStarted();  // 增加活跃线程计数并记录峰值
+    //先计入活跃线程再读回 waitForTasks不会在读回期间认为任务已经全部完成
+    reloadClaimedSpill();
     taskPtr->status = TaskStatus::RUNNING;
-    metrics.updateActiveThreads(metrics.activeThreads);
+
+    //可选的CPU时间统计 关闭时不做任何系统调用
+    bool accounting = metrics.accounting.isEnabled();
+    ThreadUsageSample usageBegin;
+    if(accounting) {
+        usageBegin = ThreadUsageSample::now();
+    }
 
     auto startTime = std::chrono::steady_clock::now();
+    bool reservedLane = isReservedWorker(id);
+    int64_t busySince = metrics.taskBegan(id, reservedLane);
+    //帮助等待时任务嵌套在另一个任务内执行 保存外层任务的句柄 结束后恢复
+    RunningTaskFrame frame{this, runningTasks, currentTaskHandle, currentTaskPriority};
+    runningTasks = &frame;
+    ++runningDepth;
+    //看门狗启用过时登记当前任务 只有几次无竞争的原子写
+    //嵌套执行的任务不登记 看门狗看到的是仍在运行的外层任务
+    WorkerSlot* slot = frame.outer == nullptr ? watchdogSlot(id) : nullptr;
+    if(slot) {
+        slot->begin(taskPtr.get(), std::chrono::duration_cast<std::chrono::nanoseconds>(
+            startTime.time_since_epoch()).count());
+    }
     //增加超时机制 主线程监督子线程执行
+    currentTaskHandle = taskPtr->sequence;
+    currentTaskPriority = taskPtr->priority;
+    if(scheduling.perTaskNice && frame.outer == nullptr) {
+        adjustNiceForTask(id, taskPtr->priority);
+    }
+    TP_TRACE(tracer, TraceEventType::START, id, taskPtr->sequence, taskPtr->priority);
 
     try {
         taskPtr->task();
 
         //到这里说明已经完成了
         taskPtr->status = TaskStatus::COMPLETED;
-        metrics.completedTasks++;
+        metrics.addCompleted(id);
 
     } catch(const std::exception& e) {
         taskPtr->status = TaskStatus::FAILED;
         taskPtr->errorMessage = e.what();
-        logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "处理任务完成: "
+        TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "处理任务完成: "
                     + taskStatusToString(taskPtr->status));
     } catch(...) {
         taskPtr->status = TaskStatus::FAILED;
         taskPtr->errorMessage = "未知异常";
-        logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "处理任务完成: "
+        TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(id) + "处理任务完成: "
                     + taskStatusToString(taskPtr->status));
 
     }
 
+    TP_TRACE(tracer, TraceEventType::END, id, taskPtr->sequence, taskPtr->priority);
+    currentTaskHandle = frame.savedHandle;
+    currentTaskPriority = frame.savedPriority;
+    runningTasks = frame.outer;
+    --runningDepth;
+    if(slot) {
+        slot->end();
+    }
+
     auto endTime = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
-    metrics.addTaskTime(duration.count());
+    metrics.addTaskTime(id, duration.count(), busySince, reservedLane);
+    if(accounting) {
+        static const std::string anonymousCategory = "匿名任务";
+        const std::string& category = taskPtr->description.empty() ? anonymousCategory : taskPtr->description;
+        metrics.accounting.record(id, category, static_cast<uint64_t>(duration.count()),
+                                  usageBegin, ThreadUsageSample::now());
+    }
+    //排队时间: 提交(创建任务记录) -> 开始执行
+    auto waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(startTime - taskPtr->submitTime);
+    metrics.recordLatency(id, taskPtr->priority, static_cast<uint64_t>(waitTime.count()),
+                          static_cast<uint64_t>(duration.count()));
+    if(taskPtr->tenant) {
+        TenantState& tenant = *taskPtr->tenant;
+        tenant.wait.record(static_cast<uint64_t>(waitTime.count()));
+        tenant.endToEnd.record(static_cast<uint64_t>((waitTime + duration).count()));
+        tenant.completed.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    --metrics.activeThreads;   // 减少活跃线程计数
+    metrics.threadFinished();   // 减少活跃线程计数
     waitCondition.notify_all();
     cleanupTask(taskPtr);
     logTaskCompletion(id, taskPtr, duration);
@@ -196,60 +423,79 @@ void ThreadPool::executeTask(size_t id, std::shared_ptr<TaskInfo> taskPtr) {
 
 void ThreadPool::recordTaskFailure(const std::string& errorMessage, bool isTimeout) {
     if (isTimeout) {
-        metrics.timeOutTasks++;
-        logger.log(LogLevel::ERROR, "任务超时: " + errorMessage);
+        metrics.addTimeout(currentWorkerId);
+        TP_TRACE(tracer, TraceEventType::TIMEOUT, currentWorkerId, currentTaskHandle, currentTaskPriority);
+        TP_LOG(logger, LogLevel::ERROR, "任务超时: " + errorMessage);
     } else {
-        metrics.failedTasks++;
-        logger.log(LogLevel::ERROR, "任务异常: " + errorMessage);
+        metrics.addFailed(currentWorkerId);
+        TP_LOG(logger, LogLevel::ERROR, "任务异常: " + errorMessage);
     }
 }
 
 size_t ThreadPool::getThreadCount() const {
-    return workers.size();
+    return workerCount.load(std::memory_order_relaxed);
+}
+
+// 工作线程数变化后更新计数(持有queue_mutex) 指标中的线程数包含替补线程
+void ThreadPool::updateThreadCount() {
+    workerCount.store(workers.size(), std::memory_order_relaxed);
+    metrics.setThreadCount(workers.size() + liveTemporaryWorkers);
 }
 
 size_t ThreadPool::getTaskCount() {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::OTHER);
     return tasks.size();
 }
 
+size_t ThreadPool::getIdleThreadCount() {
+    auto lock = lockQueue(LockSite::OTHER);
+    return idleWorkers;
+}
+
 size_t ThreadPool::getCompletedTaskCount() const {
-    return metrics.completedTasks;
+    return metrics.getCompletedTasks();
 }
 
 size_t ThreadPool::getActiveThreadCount() const {
-    return metrics.activeThreads;
+    return metrics.activeThreads.load();
 }
 
 size_t ThreadPool::getWaitingThreadCount() const {
     size_t total = getThreadCount();
     size_t active = getActiveThreadCount();
-    return total - active;
+    //帮助等待时一个线程上可能嵌套执行多个任务 活跃数可能超过线程数
+    return total > active ? total - active : 0;
 }
 
 
 //动态调整线程池的大小 使用unordered_set管理需要停止的线程ID
 void ThreadPool::resize(size_t threads) {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::OTHER);
 
     if(stop){
         throw std::runtime_error("resize on stopped ThreadPool");
     }
     
     threads = std::min(threads, maxThreads);
+    //先更新目标线程数 缩小期间按需创建不会再分配被回收的ID
+    targetThreads = threads;
 
     //分线程增大与线程池减小两种情况
     size_t oldSize = workers.size();
 
-    logger.log(LogLevel::INFO, "调整线程池大小: " + std::to_string(oldSize) +
+    TP_LOG(logger, LogLevel::INFO, "调整线程池大小: " + std::to_string(oldSize) +
         " -> " + std::to_string(threads) +
         " (最大: " + std::to_string(maxThreads) + ")");
 
-    if(threads > oldSize){
+    if(threads > oldSize && lazyStart) {
+        //按需创建模式只提高上限 已排队的任务需要的线程立即补上
+        spawnOnDemand();
+    } else if(threads > oldSize){
         workers.reserve(threads);
         for(size_t i = oldSize; i < threads; ++i) {
-            workers.emplace_back([this, i]() {  this->workerThread(i);  });
+            spawnWorker(i);
         }
+        updateThreadCount();
         std::cout << "增加了 " << (threads - oldSize)<< "个工作线程" << std::endl;
 
     } else if(threads < oldSize){
@@ -272,55 +518,253 @@ void ThreadPool::resize(size_t threads) {
         //重新获取并调整大小
         lock.lock();
         workers.resize(threads);
+        updateThreadCount();
         std::cout << "减少了 " << oldSize - threads << " 个工作线程" << std::endl;
     }
 
 }
 
+// 调整预留通道 增加时创建新线程 减少时通知多余的线程退出并等待它们结束
+void ThreadPool::setReservedWorkers(size_t count, TaskPriority minPriority) {
+    auto lock = lockQueue(LockSite::OTHER);
+    if(stop) {
+        throw std::runtime_error("setReservedWorkers on stopped ThreadPool");
+    }
+    count = std::min(count, kMaxReservedWorkers);
+    reservedMinPriority = minPriority;
+    reservedTarget = count;
+    size_t oldSize = reservedWorkers.size();
+
+    TP_LOG(logger, LogLevel::INFO, "预留通道: " + std::to_string(oldSize) + " -> " + std::to_string(count) +
+        " 个线程, 最低优先级 " + std::to_string(static_cast<int>(minPriority)));
+
+    if(count > oldSize) {
+        reservedWorkers.reserve(count);
+        for(size_t i = oldSize; i < count; ++i) {
+            reservedWorkers.emplace_back([this, i]() { this->reservedWorkerThread(i); }, workerStackSize);
+        }
+    } else if(count < oldSize) {
+        lock.unlock();
+        reservedCondition.notify_all();
+        for(size_t i = count; i < oldSize; ++i) {
+            if(reservedWorkers[i].joinable()) {
+                reservedWorkers[i].join();
+            }
+        }
+        lock.lock();
+        reservedWorkers.resize(count);
+    }
+    metrics.reservedThreads.store(reservedWorkers.size(), std::memory_order_relaxed);
+    lock.unlock();
+    //最低优先级可能降低了 已排队的任务可能变得可以执行
+    reservedCondition.notify_all();
+}
+
+size_t ThreadPool::getReservedWorkerCount() const {
+    return metrics.reservedThreads.load(std::memory_order_relaxed);
+}
+
+// 设置失败只记录一次警告和计数 线程继续以默认调度参数运行
+void ThreadPool::applyWorkerScheduling(size_t id) {
+    const SchedulingTier& tier = isReservedWorker(id) ? scheduling.reserved : scheduling.shared;
+    currentNice = getCurrentThreadNice();
+    niceAdjustFailed = false;
+    if(tier.isDefault()) {
+        return;
+    }
+    if(!applySchedulingTier(tier)) {
+        int error = errno;
+        if(metrics.schedulingErrors.fetch_add(1, std::memory_order_relaxed) == 0) {
+            TP_LOG(logger, LogLevel::WARN, std::string("设置工作线程调度参数失败(") +
+                schedulingPolicyName(tier.policy) + ", nice " + std::to_string(tier.niceValue) + "): " +
+                std::strerror(error));
+        }
+    }
+    currentNice = getCurrentThreadNice();
+}
+
+// 只调整本线程池的共享线程 外部线程帮助执行任务时不改变它们的nice值
+void ThreadPool::adjustNiceForTask(size_t id, TaskPriority priority) {
+    if(currentPool != this || isReservedWorker(id) || niceAdjustFailed || scheduling.shared.isRealtime()) {
+        return;
+    }
+    int wanted = scheduling.taskNice[static_cast<size_t>(priority)];
+    if(wanted == currentNice) {
+        return;
+    }
+    if(setCurrentThreadNice(wanted)) {
+        currentNice = wanted;
+    } else {
+        niceAdjustFailed = true;
+        metrics.schedulingErrors.fetch_add(1, std::memory_order_relaxed);
+        TP_LOG(logger, LogLevel::WARN, "工作线程 " + std::to_string(id) + " 无法把nice值调整为 " +
+            std::to_string(wanted) + ": " + std::strerror(errno) + " 之后不再按任务调整");
+    }
+}
+
+// 预留线程: 只在队首任务达到预留优先级时被唤醒并取任务
+void ThreadPool::reservedWorkerThread(size_t index) {
+    size_t id = kReservedWorkerIdBase + index;
+    currentWorkerId = id;
+    currentPool = this;
+    applyWorkerScheduling(id);
+    TP_LOG(logger, LogLevel::DEBUG, "预留线程 " + std::to_string(index) + " 启动");
+
+    while(true) {
+        std::shared_ptr<TaskInfo> taskPtr;
+        {
+            auto lock = lockQueue(LockSite::GET_NEXT_TASK);
+            lock.wait(reservedCondition, [this, index]() {
+                return stop || index >= reservedTarget || (!paused && hasReservedTask());
+            });
+            if(stop || index >= reservedTarget) {
+                TP_LOG(logger, LogLevel::DEBUG, "预留线程 " + std::to_string(index) + " 停止");
+                return;
+            }
+            taskPtr = popRunnableTask(id, reservedMinPriority);
+        }
+        if(taskPtr && taskPtr->task) {
+            executeTask(id, taskPtr);
+        }
+        reloadClaimedSpill();
+    }
+}
+
 //条件变量会影响线程condition等待 无需主动调整
 void ThreadPool::pause() {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::OTHER);
     paused = true;
     std::cout << "线程池已停止" << std::endl;
 }
 
 void ThreadPool::resume() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        auto lock = lockQueue(LockSite::OTHER);
         paused = false;
         std::cout << "线程池已恢复" << std::endl;
     }
     //唤醒所有线程 通知他们线程池要恢复了
     condition.notify_all();
+    reservedCondition.notify_all();
 }
 
 //使用条件变量condition_wait
 void ThreadPool::waitForTasks() {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::WAIT_FOR_TASKS);
     std::cout << "等待所有任务完成...." << std::endl;
-    waitCondition.wait(lock, [this]() {
+    lock.wait(waitCondition, [this]() {
         //任务队列空 并且所有正在完成的任务都完成
-        return (tasks.empty() && metrics.activeThreads == 0) || stop;
+        //限流侧队列中的任务也要等它们放行并完成
+        //段文件中的任务同样要读回并完成
+        return (tasks.empty() && metrics.activeThreads == 0 && throttledTasks == 0 &&
+                spillBacklogTotal() == 0) || stop;
     });
     std::cout << "所有任务已完成" << std::endl;
 }
 
+// 在调用线程上执行一个排队任务 工作线程使用自己的ID 其他线程(包括别的线程池的工作线程)按外部线程记录
+bool ThreadPool::runPendingTask() {
+    if(helpDepthExhausted() || stop || paused) {
+        return false;
+    }
+    size_t id = currentPool == this ? currentWorkerId : kExternalWorkerId;
+    std::shared_ptr<TaskInfo> taskPtr;
+    {
+        auto lock = lockQueue(LockSite::HELP_WAIT);
+        if(stop || paused) {
+            return false;
+        }
+        //预留线程帮助等待时同样只执行高优先级任务
+        taskPtr = popRunnableTask(id, isReservedWorker(id) ? reservedMinPriority : TaskPriority::LOW);
+    }
+    if(!taskPtr) {
+        reloadClaimedSpill();
+        return false;
+    }
+    metrics.helpedTasks.fetch_add(1, std::memory_order_relaxed);
+    if(taskPtr->task) {
+        executeTask(id, taskPtr);
+    }
+    reloadClaimedSpill();
+    return true;
+}
+
+bool ThreadPool::helpDepthExhausted() {
+    return runningDepth >= kMaxHelpDepth;
+}
+
+void ThreadPool::waitForHelpWork() {
+    auto lock = lockQueue(LockSite::HELP_WAIT);
+    if(stop || (!paused && !tasks.empty())) {
+        return;
+    }
+    ++helpWaiters;
+    lock.waitFor(waitCondition, kHelpPollInterval);
+    --helpWaiters;
+}
+
+//与waitForTasks相同的完成条件 但等待期间执行排队任务
+//在任务内部调用时 调用线程自身正在执行的任务不计入活跃任务 否则永远等不到
+void ThreadPool::helpWaitForTasks() {
+    size_t ownTasks = 0;
+    for(const RunningTaskFrame* frame = runningTasks; frame != nullptr; frame = frame->outer) {
+        if(frame->pool == this) {
+            ++ownTasks;
+        }
+    }
+    while(true) {
+        if(runPendingTask()) {
+            continue;
+        }
+        auto lock = lockQueue(LockSite::HELP_WAIT);
+        if(stop || (tasks.empty() && throttledTasks == 0 && spillBacklogTotal() == 0 &&
+                    metrics.activeThreads.load() <= ownTasks)) {
+            return;
+        }
+        if(!paused && !tasks.empty() && !helpDepthExhausted()) {
+            continue;
+        }
+        ++helpWaiters;
+        lock.waitFor(waitCondition, kHelpPollInterval);
+        --helpWaiters;
+    }
+}
+
 //一个非常巧妙清空STL容器的方法
 //用一个空的容器做置换 快速move并且可以返还内存 还能把析构放在锁之外完成 提升速度
 void ThreadPool::clearTasks() {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    std::unique_lock<std::mutex> spillLock(spillMutex);
+    auto lock = lockQueue(LockSite::OTHER);
     size_t taskCount = tasks.size();
 
     //清空任务队列和ID映射表
-    std::priority_queue<TaskInfo> emptyQueue;
+    TaskQueue emptyQueue;
     std::swap(tasks, emptyQueue);
     taskIdMap.clear();
-
-    logger.log(LogLevel::INFO, "清空任务队列: " + std::to_string(taskCount) + " 个任务被移除");
+    metrics.updateQueueSize(0);
+    tenantScheduler.clear();
+    //限流侧队列中尚未放行的任务一并丢弃 和emptyQueue一样在解锁后析构
+    std::vector<std::shared_ptr<TaskInfo>> throttled = rateLimiter.clear();
+    size_t throttledCount = throttled.size();
+    throttledTasks -= throttledCount;
+    taskCount += throttledCount;
+    //段文件中的任务同样丢弃 正在读回的一批拼接时发现代数变化后丢弃
+    taskCount += spillStore.clear();
+    std::fill(std::begin(spillBacklog), std::end(spillBacklog), 0);
+    ++spillGeneration;
+    metrics.spilledTasks.store(0, std::memory_order_relaxed);
+
+    TP_LOG(logger, LogLevel::INFO, "清空任务队列: " + std::to_string(taskCount) + " 个任务被移除");
+    lock.unlock();
+    spillLock.unlock();
+    //waitForTasks可能只在等被丢弃的限流任务
+    if(throttledCount > 0) {
+        waitCondition.notify_all();
+    }
 }
 
 size_t ThreadPool::getFailedTaskCount() const {
-    return metrics.failedTasks;
+    return metrics.getFailedTasks();
 }
 
 // 获取性能报告
@@ -328,49 +772,826 @@ std::string ThreadPool::getMetricsReport() const {
     return metrics.getReport();
 }
 
+WindowedRates ThreadPool::getWindowedRates(std::chrono::seconds window) const {
+    return metrics.getWindowedRates(window);
+}
+
+LatencySnapshot ThreadPool::getLatencySnapshot() const {
+    return metrics.getLatencySnapshot();
+}
+
+LatencySnapshot ThreadPool::takeLatencyInterval() {
+    return metrics.takeLatencyInterval();
+}
+
+void ThreadPool::resetLatencyHistograms() {
+    metrics.resetLatency();
+}
+
+void ThreadPool::enableTaskAccounting(bool enable, size_t maxCategories) {
+    metrics.accounting.setMaxCategories(maxCategories);
+    metrics.accounting.setEnabled(enable);
+}
+
+std::vector<CategoryUsage> ThreadPool::getTaskCategoryUsage() const {
+    return metrics.accounting.snapshot();
+}
+
+std::string ThreadPool::getTaskAccountingReport() const {
+    return metrics.accounting.getReport();
+}
+
+void ThreadPool::resetTaskAccounting() {
+    metrics.accounting.reset();
+}
+
+LockSiteReport ThreadPool::getLockStats(LockSite site) const {
+    return metrics.lockProfile.get(site);
+}
+
+std::string ThreadPool::getLockReport() const {
+    return metrics.lockProfile.getReport();
+}
+
+void ThreadPool::resetLockStats() {
+    metrics.lockProfile.reset();
+}
+
+std::string ThreadPool::exportOpenMetrics() const {
+    return formatOpenMetrics(metrics);
+}
+
+std::string ThreadPool::exportMetricsJson() const {
+    return formatMetricsJson(metrics);
+}
+
+bool ThreadPool::startMetricsServer(uint16_t port) {
+    std::lock_guard<std::mutex> lock(metricsServerMutex);
+    metricsServer = std::make_unique<MetricsHttpServer>(metrics);
+    if(!metricsServer->listenTcp(port)) {
+        metricsServer.reset();
+        TP_LOG(logger, LogLevel::ERROR, "指标服务监听端口失败: " + std::to_string(port));
+        return false;
+    }
+    TP_LOG(logger, LogLevel::INFO, "指标服务已启动: http://127.0.0.1:" +
+        std::to_string(metricsServer->getPort()) + "/metrics");
+    return true;
+}
+
+bool ThreadPool::startMetricsServerUnix(const std::string& socketPath) {
+    std::lock_guard<std::mutex> lock(metricsServerMutex);
+    metricsServer = std::make_unique<MetricsHttpServer>(metrics);
+    if(!metricsServer->listenUnix(socketPath)) {
+        metricsServer.reset();
+        TP_LOG(logger, LogLevel::ERROR, "指标服务监听Unix套接字失败: " + socketPath);
+        return false;
+    }
+    TP_LOG(logger, LogLevel::INFO, "指标服务已启动: " + socketPath);
+    return true;
+}
+
+uint16_t ThreadPool::getMetricsServerPort() const {
+    std::lock_guard<std::mutex> lock(metricsServerMutex);
+    return metricsServer ? metricsServer->getPort() : 0;
+}
+
+void ThreadPool::stopMetricsServer() {
+    std::lock_guard<std::mutex> lock(metricsServerMutex);
+    metricsServer.reset();
+}
+
+// 启动看门狗 第一次启用时为现有上限内的常规线程和替补线程预先登记槽位 之后创建的线程在执行任务时登记
+bool ThreadPool::enableWatchdog(const WatchdogOptions& options) {
+    std::lock_guard<std::mutex> lock(watchdogMutex);
+    if(stop) {
+        return false;
+    }
+    if(!watchdog) {
+        size_t regularSlots;
+        {
+            auto queueLock = lockQueue(LockSite::OTHER);
+            regularSlots = maxThreads;
+        }
+        std::vector<size_t> workerIds;
+        workerIds.reserve(regularSlots + kMaxTemporaryWorkers);
+        for(size_t i = 0; i < regularSlots; ++i) {
+            workerIds.push_back(i);
+        }
+        for(size_t i = 0; i < kMaxTemporaryWorkers; ++i) {
+            workerIds.push_back(kTemporaryWorkerIdBase + i);
+        }
+        watchdog = std::make_unique<TaskWatchdog>(std::move(workerIds));
+        watchdogPtr.store(watchdog.get(), std::memory_order_release);
+    }
+
+    bool replace = options.replaceStuckWorkers;
+    watchdog->start(options,
+        [this, replace](const StuckTaskInfo& info) {
+            metrics.stuckTasks.fetch_add(1, std::memory_order_relaxed);
+            metrics.currentStuckTasks.fetch_add(1, std::memory_order_relaxed);
+
+            std::string taskDesc = info.taskId.empty() ? "匿名任务" : "任务 " + info.taskId;
+            if(!info.description.empty()) {
+                taskDesc += " (" + info.description + ")";
+            }
+            std::string limit = info.timeout.count() > 0
+                ? ", 超时时间 " + std::to_string(info.timeout.count()) + " 毫秒" : "";
+            TP_LOG(logger, LogLevel::ERROR, "看门狗: 工作线程 " + std::to_string(info.workerId) + " 上的 " +
+                taskDesc + " 已运行 " + std::to_string(info.runningFor.count()) + " 毫秒" + limit);
+
+            if(!replace || !spawnTemporaryWorker()) {
+                return false;
+            }
+            metrics.replacementWorkers.fetch_add(1, std::memory_order_relaxed);
+            TP_LOG(logger, LogLevel::WARN, "看门狗: 为工作线程 " + std::to_string(info.workerId) + " 启动替补线程");
+            return true;
+        },
+        [this](const StuckTaskInfo& info) {
+            metrics.currentStuckTasks.fetch_sub(1, std::memory_order_relaxed);
+            if(info.replaced) {
+                retireTemporaryWorker();
+            }
+            TP_LOG(logger, LogLevel::INFO, "看门狗: 工作线程 " + std::to_string(info.workerId) + " 上的卡住任务已结束");
+        });
+
+    TP_LOG(logger, LogLevel::INFO, "看门狗已启动, 扫描间隔 " + std::to_string(options.scanInterval.count()) +
+        " 毫秒, 全局阈值 " + std::to_string(options.stuckThreshold.count()) + " 毫秒");
+    return true;
+}
+
+void ThreadPool::disableWatchdog() {
+    std::lock_guard<std::mutex> lock(watchdogMutex);
+    if(watchdog) {
+        watchdog->stop();
+    }
+    reapTemporaryWorkers(false);
+}
+
+std::vector<StuckTaskInfo> ThreadPool::getStuckTasks() const {
+    TaskWatchdog* current = watchdogPtr.load(std::memory_order_acquire);
+    return current ? current->stuckTasks() : std::vector<StuckTaskInfo>();
+}
+
+size_t ThreadPool::getTemporaryWorkerCount() {
+    auto lock = lockQueue(LockSite::OTHER);
+    return liveTemporaryWorkers;
+}
+
+// 每个工作线程缓存自己的槽位 看门狗启用后才创建的线程(扩容、替补、预留通道)第一次执行任务时登记
+// 外部线程帮助执行的任务不登记
+WorkerSlot* ThreadPool::watchdogSlot(size_t id) {
+    TaskWatchdog* current = watchdogPtr.load(std::memory_order_acquire);
+    if(current == nullptr || id == kExternalWorkerId) {
+        return nullptr;
+    }
+    if(cachedWatchdog != current || cachedWatchdogWorker != id) {
+        cachedWatchdogSlot = &current->slotFor(id);
+        cachedWatchdog = current;
+        cachedWatchdogWorker = id;
+    }
+    return cachedWatchdogSlot;
+}
+
+// 启动一个临时替补线程 与常规工作线程一样从队列取任务
+bool ThreadPool::spawnTemporaryWorker() {
+    reapTemporaryWorkers(false);
+
+    auto lock = lockQueue(LockSite::OTHER);
+    return spawnTemporaryWorkerLocked();
+}
+
+bool ThreadPool::spawnTemporaryWorkerLocked() {
+    if(stop) {
+        return false;
+    }
+    size_t index = 0;
+    while(index < kMaxTemporaryWorkers && temporaryIdsInUse[index]) {
+        ++index;
+    }
+    if(index == kMaxTemporaryWorkers) {
+        TP_LOG(logger, LogLevel::WARN, "替补线程已达上限 " + std::to_string(kMaxTemporaryWorkers));
+        return false;
+    }
+    temporaryIdsInUse[index] = true;
+    size_t id = kTemporaryWorkerIdBase + index;
+    temporaryWorkers.push_back(TemporaryWorker{id, WorkerThread(), false});
+    try {
+        temporaryWorkers.back().thread = WorkerThread([this, id]() { this->temporaryWorkerThread(id); },
+                                                      workerStackSize);
+    } catch(const std::system_error& e) {
+        temporaryWorkers.pop_back();
+        temporaryIdsInUse[index] = false;
+        TP_LOG(logger, LogLevel::ERROR, std::string("创建替补线程失败: ") + e.what());
+        return false;
+    }
+    ++liveTemporaryWorkers;
+    updateThreadCount();
+    return true;
+}
+
+// 请求一个替补线程退休 由空闲的替补线程认领
+void ThreadPool::retireTemporaryWorker() {
+    {
+        auto lock = lockQueue(LockSite::OTHER);
+        if(temporaryRetireRequests >= liveTemporaryWorkers) {
+            return;
+        }
+        ++temporaryRetireRequests;
+    }
+    condition.notify_all();
+}
+
+void ThreadPool::temporaryWorkerThread(size_t id) {
+    applyWorkerScheduling(id);
+    workerThread(id);
+
+    auto lock = lockQueue(LockSite::OTHER);
+    for(TemporaryWorker& worker : temporaryWorkers) {
+        if(worker.id == id && !worker.finished) {
+            worker.finished = true;
+            break;
+        }
+    }
+    temporaryIdsInUse[id - kTemporaryWorkerIdBase] = false;
+    --liveTemporaryWorkers;
+    updateThreadCount();
+}
+
+// 回收已退出的替补线程 all为true时(析构)等待全部替补线程退出
+void ThreadPool::reapTemporaryWorkers(bool all) {
+    std::list<TemporaryWorker> done;
+    {
+        auto lock = lockQueue(LockSite::OTHER);
+        for(auto it = temporaryWorkers.begin(); it != temporaryWorkers.end();) {
+            auto next = std::next(it);
+            if(all || it->finished) {
+                done.splice(done.end(), temporaryWorkers, it);
+            }
+            it = next;
+        }
+    }
+    for(TemporaryWorker& worker : done) {
+        if(worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+}
+
+// 进入阻塞区 有排队任务且没有空闲线程时补偿一个线程
+// 优先撤回尚未被认领的退休请求(唤醒一个将要退休的临时线程) 否则启动新的临时线程
+ThreadPool::BlockingScope ThreadPool::blockingScope() {
+    metrics.blockedThreads.fetch_add(1, std::memory_order_relaxed);
+    if(currentPool != this) {
+        return BlockingScope(this, false);
+    }
+    reapTemporaryWorkers(false);
+
+    //判断和启动在同一次加锁内完成 并发进入阻塞区的任务不会超过上限
+    auto lock = lockQueue(LockSite::OTHER);
+    size_t running = workers.size() + liveTemporaryWorkers - temporaryRetireRequests;
+    if(stop || paused || tasks.size() <= idleWorkers + startingWorkers || running >= maxThreads) {
+        return BlockingScope(this, false);
+    }
+    if(temporaryRetireRequests > 0) {
+        --temporaryRetireRequests;
+    } else if(!spawnTemporaryWorkerLocked()) {
+        return BlockingScope(this, false);
+    }
+    metrics.compensatingWorkers.fetch_add(1, std::memory_order_relaxed);
+    TP_LOG(logger, LogLevel::DEBUG, "工作线程 " + std::to_string(currentWorkerId) + " 进入阻塞区 启动补偿线程");
+    return BlockingScope(this, true);
+}
+
+void ThreadPool::endBlocking(bool compensated) {
+    metrics.blockedThreads.fetch_sub(1, std::memory_order_relaxed);
+    if(compensated) {
+        retireTemporaryWorker();
+    }
+}
+
 // 设置日志级别
 void ThreadPool::setLogLevel(LogLevel level) {
     logger.setLevel(level);
 }
 
+// 把构造好的任务放入队列
+void ThreadPool::pushTask(std::shared_ptr<TaskInfo> taskInfoPtr) {
+    QueueWakeups wakeups;
+    {
+        auto lock = lockQueue(LockSite::ENQUEUE);
+
+        if(stop) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        registerTask(taskInfoPtr);
+        queueTask(std::move(taskInfoPtr), wakeups);
+    }
+    notifyQueued(wakeups);
+}
+
+// 已完成的任务在cleanupTask中移出映射表 仍在表中的是排队、正在执行或已取消的任务
+std::shared_ptr<TaskInfo> ThreadPool::pushOrJoinTask(std::shared_ptr<TaskInfo> taskInfoPtr) {
+    QueueWakeups wakeups;
+    {
+        auto lock = lockQueue(LockSite::ENQUEUE);
+
+        if(stop) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        auto it = taskIdMap.find(taskInfoPtr->taskId);
+        if(it != taskIdMap.end()) {
+            if(it->second->status != TaskStatus::CANCELED) {
+                return it->second;
+            }
+            //已取消的记录留在队列里等工作线程跳过 映射表改为指向新任务
+            taskIdMap.erase(it);
+        }
+        registerTask(taskInfoPtr);
+        queueTask(std::move(taskInfoPtr), wakeups);
+    }
+    notifyQueued(wakeups);
+    return nullptr;
+}
+
+// 检查ID唯一性、分配入队序号、登记ID并计入提交数
+void ThreadPool::registerTask(const std::shared_ptr<TaskInfo>& taskInfoPtr) {
+    const std::string& taskId = taskInfoPtr->taskId;
+    //检查任务ID是否存在 任务是否唯一(可以通过map设置某些任务唯一)
+    if(!taskId.empty() && taskIdMap.find(taskId) != taskIdMap.end()) {
+        throw std::runtime_error("Task ID " + taskId + " already exists");
+    }
+
+    //记录任务提交日志
+    logTaskSubmission(taskId, taskInfoPtr->description, taskInfoPtr->priority);
+
+    taskInfoPtr->sequence = ++nextSequence;
+    TP_TRACE(tracer, TraceEventType::SUBMIT, currentWorkerId, taskInfoPtr->sequence,
+             taskInfoPtr->priority);
+
+    //把唯一任务的共享指针添加到map里面
+    if(!taskId.empty()) {
+        taskIdMap.emplace(taskId, taskInfoPtr);
+    }
+    metrics.addSubmitted(currentWorkerId);
+    if(taskInfoPtr->tenant) {
+        //enqueueForTenant在锁外查找租户 期间租户可能被removeTenant删除
+        taskInfoPtr->tenant = tenantScheduler.revalidate(std::move(taskInfoPtr->tenant));
+        taskInfoPtr->tenant->submitted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// 放入优先级队列 记录需要唤醒哪些线程
+void ThreadPool::queueTask(std::shared_ptr<TaskInfo> taskInfoPtr, QueueWakeups& wakeups) {
+    TaskPriority priority = taskInfoPtr->priority;
+    taskInfoPtr->fairTag = tenantScheduler.enqueue(taskInfoPtr->tenant.get(), priority);
+    tasks.push(std::move(taskInfoPtr));
+    if(lazyStart) {
+        spawnOnDemand();
+    }
+    metrics.updateQueueSize(tasks.size());
+    ++wakeups.workers;
+    if(reservedTarget > 0 && priority >= reservedMinPriority) {
+        ++wakeups.reserved;
+    }
+    wakeups.helpers = helpWaiters > 0;
+}
+
+void ThreadPool::notifyQueued(const QueueWakeups& wakeups) {
+    if(wakeups.workers == 1) {
+        condition.notify_one();
+    } else if(wakeups.workers > 1) {
+        condition.notify_all();
+    }
+    if(wakeups.reserved == 1) {
+        reservedCondition.notify_one();
+    } else if(wakeups.reserved > 1) {
+        reservedCondition.notify_all();
+    }
+    if(wakeups.helpers) {
+        waitCondition.notify_all();
+    }
+}
+
+// 限流类别的任务 没有令牌时进入侧队列 由限流器的定时线程放行
+void ThreadPool::pushRateLimited(const std::string& category, std::shared_ptr<TaskInfo> taskInfoPtr) {
+    QueueWakeups wakeups;
+    {
+        auto lock = lockQueue(LockSite::ENQUEUE);
+
+        if(stop) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        //类别只在queue_mutex内删除 检查之后不会消失
+        if(!rateLimiter.hasLimit(category)) {
+            throw std::invalid_argument("Unknown rate limit category: " + category);
+        }
+        registerTask(taskInfoPtr);
+        if(!rateLimiter.admit(category, taskInfoPtr)) {
+            ++throttledTasks;
+            return;
+        }
+        queueTask(std::move(taskInfoPtr), wakeups);
+    }
+    notifyQueued(wakeups);
+}
+
+// 限流器定时线程放行的任务 线程池已停止时直接丢弃
+void ThreadPool::releaseRateLimited(std::vector<std::shared_ptr<TaskInfo>>&& released) {
+    QueueWakeups wakeups;
+    {
+        auto lock = lockQueue(LockSite::ENQUEUE);
+        throttledTasks -= released.size();
+        if(stop) {
+            return;
+        }
+        for(std::shared_ptr<TaskInfo>& task : released) {
+            queueTask(std::move(task), wakeups);
+        }
+    }
+    notifyQueued(wakeups);
+}
+
+void ThreadPool::setRateLimit(const std::string& category, double tasksPerSecond, double burst) {
+    rateLimiter.setLimit(category, tasksPerSecond, burst);
+    TP_LOG(logger, LogLevel::INFO, "设置限流类别 " + category + ": " + std::to_string(tasksPerSecond) +
+        " 任务/秒, 突发 " + std::to_string(burst));
+}
+
+bool ThreadPool::removeRateLimit(const std::string& category) {
+    std::vector<std::shared_ptr<TaskInfo>> released;
+    {
+        auto lock = lockQueue(LockSite::OTHER);
+        if(!rateLimiter.removeLimit(category, released)) {
+            return false;
+        }
+    }
+    //侧队列中剩余的任务不再受限 立即放行 放行时扣除throttledTasks
+    if(!released.empty()) {
+        releaseRateLimited(std::move(released));
+    }
+    return true;
+}
+
+std::vector<RateLimitStats> ThreadPool::getRateLimitStats() const {
+    return rateLimiter.snapshot();
+}
+
+void ThreadPool::registerSharedHandler(const std::string& name, SharedTaskHandler handler) {
+    std::lock_guard<std::mutex> lock(sharedHandlersMutex);
+    sharedHandlers[name] = std::move(handler);
+}
+
+ThreadPool::SharedTaskHandler ThreadPool::findSharedHandler(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(sharedHandlersMutex);
+    auto it = sharedHandlers.find(name);
+    return it == sharedHandlers.end() ? SharedTaskHandler() : it->second;
+}
+
+bool ThreadPool::attachSharedQueue(const std::string& name, size_t maxInFlight,
+                                   std::chrono::milliseconds completionTimeout) {
+    std::unique_ptr<SharedTaskQueue> queue = SharedTaskQueue::open(name);
+    if(!queue) {
+        TP_LOG(logger, LogLevel::ERROR, "无法打开共享内存队列 " + name + ": " + std::strerror(errno));
+        return false;
+    }
+    if(maxInFlight == 0) {
+        auto lock = lockQueue(LockSite::OTHER);
+        maxInFlight = std::max<size_t>(1, targetThreads);
+    }
+
+    auto consumer = std::make_shared<SharedQueueConsumer>(std::move(queue), maxInFlight,
+        [this](const std::string& handlerName) { return findSharedHandler(handlerName); },
+        [this](TaskPriority priority, std::function<void()> task) {
+            post(priority, std::move(task));
+            metrics.sharedQueueTasks.fetch_add(1, std::memory_order_relaxed);
+        },
+        completionTimeout,
+        [this]() { metrics.sharedQueueDropped.fetch_add(1, std::memory_order_relaxed); });
+
+    detachSharedQueue();
+    std::lock_guard<std::mutex> lock(sharedQueueMutex);
+    sharedConsumer = std::move(consumer);
+    sharedConsumer->start();
+    TP_LOG(logger, LogLevel::INFO, "挂载共享内存队列 " + name + ", 最多同时执行 " +
+        std::to_string(maxInFlight) + " 个共享任务");
+    return true;
+}
+
+void ThreadPool::detachSharedQueue() {
+    std::shared_ptr<SharedQueueConsumer> consumer;
+    {
+        std::lock_guard<std::mutex> lock(sharedQueueMutex);
+        consumer = std::move(sharedConsumer);
+    }
+    if(consumer) {
+        consumer->stop();
+    }
+}
+
+bool ThreadPool::enableSpill(const SpillOptions& options) {
+    std::lock_guard<std::mutex> spillLock(spillMutex);
+    auto lock = lockQueue(LockSite::OTHER);
+    if(!spillStore.enable(options)) {
+        TP_LOG(logger, LogLevel::ERROR, "溢出目录不可写 " + options.directory + ": " + std::strerror(errno));
+        return false;
+    }
+    spillThreshold = spillStore.options().maxQueuedTasks;
+    TP_LOG(logger, LogLevel::INFO, "启用溢出到磁盘: 目录 " + options.directory + ", 内存队列上限 " +
+        std::to_string(spillThreshold) + " 个任务");
+    return true;
+}
+
+void ThreadPool::enqueueSpillable(const std::string& handler, const std::string& payload, TaskPriority priority) {
+    size_t p = static_cast<size_t>(priority);
+    bool spilled = false;
+    {
+        std::lock_guard<std::mutex> spillLock(spillMutex);
+        bool toDisk = false;
+        {
+            auto lock = lockQueue(LockSite::ENQUEUE);
+            if(stop) {
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            }
+            //同一优先级已有任务在磁盘上(或正在读回)时也写入磁盘 否则新任务会越过它们
+            toDisk = spillThreshold > 0 && SpillStore::canSpill(priority) &&
+                     (spillBacklog[p] > 0 || tasks.size() >= spillThreshold);
+            if(toDisk) {
+                ++spillBacklog[p];
+            }
+        }
+        if(toDisk) {
+            //写段文件只持有spillMutex 工作线程出队不受影响
+            size_t bytes = 0;
+            try {
+                bytes = spillStore.append(priority, handler, payload, std::chrono::steady_clock::now());
+            } catch(...) {
+                auto lock = lockQueue(LockSite::ENQUEUE);
+                --spillBacklog[p];
+                throw;
+            }
+            if(bytes > 0) {
+                logTaskSubmission("", handler, priority);
+                metrics.addSubmitted(currentWorkerId);
+                metrics.spilledBytes.fetch_add(bytes, std::memory_order_relaxed);
+                metrics.spilledTasks.store(spillStore.size(), std::memory_order_relaxed);
+                spilled = true;
+            } else {
+                //磁盘满等情况下退回内存队列
+                TP_LOG(logger, LogLevel::ERROR, std::string("写入溢出段失败, 任务留在内存中: ") + std::strerror(errno));
+                auto lock = lockQueue(LockSite::ENQUEUE);
+                --spillBacklog[p];
+            }
+        }
+    }
+    if(!spilled) {
+        pushTask(makeTaskInfo(makeHandlerTask(handler, payload), priority, "", handler, std::chrono::milliseconds(0)));
+        return;
+    }
+    //内存队列已经降到阈值一半以下时可能不会再有出队来认领读回 由提交线程读回
+    bool claimed = false;
+    {
+        auto lock = lockQueue(LockSite::ENQUEUE);
+        claimed = claimSpillReload();
+    }
+    if(claimed) {
+        reloadSpilled();
+    }
+}
+
+size_t ThreadPool::getSpilledTaskCount() const {
+    return metrics.spilledTasks.load(std::memory_order_relaxed);
+}
+
+std::function<void()> ThreadPool::makeHandlerTask(std::string handler, std::string payload) {
+    return [this, handler = std::move(handler), payload = std::move(payload)]() {
+        //没有promise可以传递异常 在这里记录失败后重新抛出 任务状态记为FAILED
+        try {
+            SharedTaskHandler function = findSharedHandler(handler);
+            if(!function) {
+                throw std::runtime_error("Unknown shared task handler: " + handler);
+            }
+            function(payload);
+        } catch(const std::exception& e) {
+            recordTaskFailure(e.what(), false);
+            throw;
+        } catch(...) {
+            recordTaskFailure("未知异常", false);
+            throw;
+        }
+    };
+}
+
+size_t ThreadPool::spillBacklogTotal() const {
+    size_t total = 0;
+    for(size_t count : spillBacklog) {
+        total += count;
+    }
+    return total;
+}
+
+void ThreadPool::reloadClaimedSpill() {
+    if(spillReloadOwner == this) {
+        spillReloadOwner = nullptr;
+        reloadSpilled();
+    }
+}
+
+bool ThreadPool::claimSpillReload() {
+    if(spillReloading || spillBacklogTotal() == 0 || tasks.size() * 2 >= spillThreshold) {
+        return false;
+    }
+    spillReloading = true;
+    spillReloadBudget = std::min(spillThreshold - tasks.size(), kSpillReloadBatch);
+    return true;
+}
+
+// 读回的任务在提交时已计入提交数 这里只分配入队序号
+void ThreadPool::reloadSpilled() {
+    bool claimed = true;
+    while(claimed) {
+        std::vector<std::pair<TaskPriority, SpilledTask>> staged;
+        uint64_t generation = 0;
+        uint64_t bytes = 0;
+        {
+            std::lock_guard<std::mutex> spillLock(spillMutex);
+            //spillReloadBudget只由认领者使用 其他线程在认领者清除spillReloading之前不会修改它
+            size_t budget = spillReloadBudget;
+            generation = spillGeneration;
+            SpilledTask spilled;
+            for(TaskPriority priority : {TaskPriority::MEDIUM, TaskPriority::LOW}) {
+                for(; budget > 0; --budget) {
+                    size_t read = spillStore.pop(priority, spilled);
+                    if(read == 0) {
+                        break;
+                    }
+                    bytes += read;
+                    staged.emplace_back(priority, std::move(spilled));
+                }
+            }
+            metrics.spilledTasks.store(spillStore.size(), std::memory_order_relaxed);
+        }
+        metrics.reloadedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        std::vector<std::shared_ptr<TaskInfo>> ready;
+        ready.reserve(staged.size());
+        for(auto& entry : staged) {
+            SpilledTask& spilled = entry.second;
+            auto taskInfoPtr = makeTaskInfo(makeHandlerTask(spilled.handler, std::move(spilled.payload)), entry.first,
+                                            "", spilled.handler, std::chrono::milliseconds(0));
+            taskInfoPtr->submitTime = spilled.submitTime;
+            ready.push_back(std::move(taskInfoPtr));
+        }
+
+        QueueWakeups wakeups;
+        {
+            auto lock = lockQueue(LockSite::OTHER);
+            //读出之后clearTasks清空过队列 这一批随之丢弃(在锁外析构)
+            if(generation == spillGeneration) {
+                for(std::shared_ptr<TaskInfo>& taskInfoPtr : ready) {
+                    --spillBacklog[static_cast<size_t>(taskInfoPtr->priority)];
+                    taskInfoPtr->sequence = ++nextSequence;
+                    queueTask(std::move(taskInfoPtr), wakeups);
+                }
+            }
+            spillReloading = false;
+            //读取期间又有任务写入段文件 队列仍低于阈值一半时继续读回
+            claimed = claimSpillReload();
+        }
+        notifyQueued(wakeups);
+    }
+}
+
+bool ThreadPool::setTenantWeight(const std::string& tenant, double weight) {
+    if(!(weight > 0.0)) {
+        throw std::invalid_argument("Tenant weight must be positive");
+    }
+    std::shared_ptr<TenantState> state = tenantScheduler.get(tenant);
+    {
+        auto lock = lockQueue(LockSite::OTHER);
+        //查找之后租户可能已被removeTenant删除 持锁重新确认
+        state = tenantScheduler.revalidate(std::move(state));
+        if(!tenantScheduler.isOverflow(*state, tenant)) {
+            tenantScheduler.setWeight(state, weight);
+            return true;
+        }
+    }
+    //溢出租户由多个租户共用 不能按其中一个修改
+    TP_LOG(logger, LogLevel::WARN, "租户数已达上限, 不能设置租户 " + tenant + " 的权重");
+    return false;
+}
+
+void ThreadPool::setMaxTenants(size_t limit) {
+    tenantScheduler.setMaxTenants(limit);
+}
+
+bool ThreadPool::removeTenant(const std::string& tenant) {
+    //排队数在queue_mutex内修改 持锁检查
+    auto lock = lockQueue(LockSite::OTHER);
+    return tenantScheduler.remove(tenant);
+}
+
+std::vector<TenantStats> ThreadPool::getTenantStats() const {
+    return tenantScheduler.snapshot();
+}
+
+// 提交不关心结果的任务
+void ThreadPool::post(TaskPriority priority, std::function<void()> task) {
+    pushTask(makeTaskInfo(std::move(task), priority, "", "", std::chrono::milliseconds(0)));
+}
+
+// 按分配策略创建任务记录
+std::shared_ptr<TaskInfo> ThreadPool::makeTaskInfo(std::function<void()> task, TaskPriority priority,
+                                                   std::string taskId, std::string description,
+                                                   std::chrono::milliseconds timeout) {
+    if(allocationPolicy.load(std::memory_order_relaxed) == AllocationPolicy::POOLED) {
+        return std::allocate_shared<TaskInfo>(PoolAllocator<TaskInfo>(), std::move(task), priority,
+                                              std::move(taskId), std::move(description), timeout);
+    }
+    return std::make_shared<TaskInfo>(std::move(task), priority,
+                                      std::move(taskId), std::move(description), timeout);
+}
+
+// 启用任务生命周期追踪 按最大线程数分配工作线程环
+bool ThreadPool::enableTracing(size_t eventsPerWorker, const std::string& mappedFile) {
+    auto lock = lockQueue(LockSite::OTHER);
+    return tracer.enable(maxThreads, eventsPerWorker, mappedFile);
+}
+
+void ThreadPool::disableTracing() {
+    auto lock = lockQueue(LockSite::OTHER);
+    tracer.disable();
+}
+
+// 导出追踪记录为Chrome trace JSON
+bool ThreadPool::dumpTrace(const std::string& jsonPath) const {
+    return tracer.writeChromeTrace(jsonPath);
+}
+
+// 设置任务记录和结果状态的分配策略
+void ThreadPool::setAllocationPolicy(AllocationPolicy policy) {
+    allocationPolicy.store(policy, std::memory_order_relaxed);
+}
+
+AllocationPolicy ThreadPool::getAllocationPolicy() const {
+    return allocationPolicy.load(std::memory_order_relaxed);
+}
+
+// 启用异步日志
+void ThreadPool::enableAsyncLogging(const AsyncLogOptions& options) {
+    logger.enableAsync(options);
+}
+
+// 日志文件按大小轮转
+void ThreadPool::setLogRotation(size_t maxFileSize, size_t maxBackupFiles) {
+    logger.setRotation(maxFileSize, maxBackupFiles);
+}
+
+size_t ThreadPool::getDroppedLogCount() const {
+    return logger.getDroppedCount();
+}
+
 // 记录任务提交日志
 void ThreadPool::logTaskSubmission(const std::string& taskId, const std::string& description,
                                    TaskPriority priority) {
+    if(!TP_LOG_ENABLED(logger, LogLevel::DEBUG)) {
+        return;
+    }
     std::string priorityStr = priorityToString(priority);
     
     if (!taskId.empty() || !description.empty()) {
-        logger.log(LogLevel::DEBUG, "提交任务 " + taskId + " (" + description + 
+        TP_LOG(logger, LogLevel::DEBUG, "提交任务 " + taskId + " (" + description + 
                    ") 优先级: " + priorityStr);
     } else {
-        logger.log(LogLevel::DEBUG, "提交" + priorityStr + "优先级任务");
+        TP_LOG(logger, LogLevel::DEBUG, "提交" + priorityStr + "优先级任务");
     }
 }
 
 //只能取消等待中的任务
 bool ThreadPool::cancelTask(const std::string& taskId) {
-    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::CANCEL_TASK);
 
     auto it = taskIdMap.find(taskId);
     if(it == taskIdMap.end()) {
-        logger.log(LogLevel::ERROR, "尝试取消不存在的任务 " + taskId);
+        TP_LOG(logger, LogLevel::ERROR, "尝试取消不存在的任务 " + taskId);
         return false;
     }
 
     auto& taskInfoPtr = it->second;
     if(taskInfoPtr->status == TaskStatus::RUNNING) {
-        logger.log(LogLevel::ERROR, "无法取消正在执行的任务 " + taskId);
+        TP_LOG(logger, LogLevel::ERROR, "无法取消正在执行的任务 " + taskId);
         return false;
     }
     if(taskInfoPtr->status == TaskStatus::COMPLETED ||
         taskInfoPtr->status == TaskStatus::CANCELED ||
         taskInfoPtr->status == TaskStatus::FAILED) {
-        logger.log(LogLevel::ERROR, "任务 " + taskId + " 已经终止: " + 
+        TP_LOG(logger, LogLevel::ERROR, "任务 " + taskId + " 已经终止: " + 
                     taskStatusToString(taskInfoPtr->status));
         return false;
     }
 
     taskInfoPtr->status = TaskStatus::CANCELED;
-    logger.log(LogLevel::INFO, "成功取消任务 " + taskId);
+    TP_TRACE(tracer, TraceEventType::CANCEL, currentWorkerId, taskInfoPtr->sequence, taskInfoPtr->priority);
+    TP_LOG(logger, LogLevel::INFO, "成功取消任务 " + taskId);
     //不会直接从工作队列中移除 只更新状态
     //worker遇到CANCLED状态任务会直接跳过
     return true;
@@ -378,19 +1599,26 @@ bool ThreadPool::cancelTask(const std::string& taskId) {
 
 // 清理任务
 void ThreadPool::cleanupTask(std::shared_ptr<TaskInfo> taskPtr) {
-    std::lock_guard<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::CLEANUP_TASK);
     if (!taskPtr->taskId.empty()) {
-        taskIdMap.erase(taskPtr->taskId);
+        //已取消的记录可能在cancelTask之前就被工作线程取走 此时同一ID已经映射到pushOrJoinTask登记的新任务
+        auto it = taskIdMap.find(taskPtr->taskId);
+        if (it != taskIdMap.end() && it->second == taskPtr) {
+            taskIdMap.erase(it);
+        }
     }
     waitCondition.notify_all();
 }
 
 // 记录任务完成日志
 void ThreadPool::logTaskCompletion(size_t id, std::shared_ptr<TaskInfo> taskPtr, const std::chrono::nanoseconds& duration) {
+    if(!TP_LOG_ENABLED(logger, LogLevel::DEBUG)) {
+        return;
+    }
     std::string taskDesc = taskPtr->taskId.empty() ? "匿名任务" : "任务 " + taskPtr->taskId;
     std::string statusStr = taskStatusToString(taskPtr->status);
 
-    logger.log(LogLevel::DEBUG,
+    TP_LOG(logger, LogLevel::DEBUG,
         "工作线程 " + std::to_string(id) + " " + statusStr + " " + taskDesc +
         " (用时: " + std::to_string(duration.count() / 1000000.0) + "ms)");
 }
@@ -398,7 +1626,7 @@ void ThreadPool::logTaskCompletion(size_t id, std::shared_ptr<TaskInfo> taskPtr,
 
 TaskStatus ThreadPool::getTaskStatus(const std::string& taskId)
  {
-    std::lock_guard<std::mutex> lock(queue_mutex);
+    auto lock = lockQueue(LockSite::GET_TASK_STATUS);
     auto it = taskIdMap.find(taskId);
     if(it != taskIdMap.end()) {
         return it->second->status;
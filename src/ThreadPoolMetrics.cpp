@@ -1,10 +1,227 @@
 #include "ThreadPoolMetrics.h"
+#include "RateLimiter.h"
+#include "TenantScheduler.h"
 #include <sstream>
 #include <iomanip>
+#include <functional>
+#include <thread>
+#include <algorithm>
+#include <time.h>
+
+int64_t coarseMonotonicNs() {
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
 
 // 构造函数
 ThreadPoolMetrics::ThreadPoolMetrics() : startTime(std::chrono::steady_clock::now()) {}
 
+ThreadPoolMetrics::~ThreadPoolMetrics() {
+  for(auto& shard : latencyShards) {
+    delete shard.load(std::memory_order_acquire);
+  }
+}
+
+// 选择当前线程写入的分片
+// 三类工作线程ID的低位都从0开始编号 直接取模会让预留线程i、替补线程i和常规线程i落在同一分片
+// 常规线程从低位分片向上 预留通道线程从最高分片向下 替补线程从中间向上
+size_t ThreadPoolMetrics::shardIndex(size_t workerId) {
+  if(workerId == kExternalWorkerId) {
+    //非工作线程按线程ID哈希 每个线程只算一次
+    thread_local size_t externalShard = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kShardCount;
+    return externalShard;
+  }
+  if(workerId >= kTemporaryWorkerIdBase) {
+    return (kShardCount / 2 + workerId - kTemporaryWorkerIdBase) % kShardCount;
+  }
+  if(workerId >= kReservedWorkerIdBase) {
+    return kShardCount - 1 - (workerId - kReservedWorkerIdBase) % kShardCount;
+  }
+  return workerId % kShardCount;
+}
+
+MetricsShard& ThreadPoolMetrics::shardFor(size_t workerId) {
+  return shards[shardIndex(workerId)];
+}
+
+int64_t ThreadPoolMetrics::taskBegan(size_t workerId, bool reserved) {
+  MetricsShard& shard = shardFor(workerId);
+  int64_t nowNs = coarseMonotonicNs();
+  for(size_t lane = 0; lane <= (reserved ? 1u : 0u); ++lane) {
+    shard.runningSinceNs[lane].fetch_add(nowNs, std::memory_order_relaxed);
+    shard.running[lane].fetch_add(1, std::memory_order_release);
+  }
+  return nowNs;
+}
+
+void ThreadPoolMetrics::addTaskTime(size_t workerId, uint64_t timeNs, int64_t beganNs, bool reserved) {
+  MetricsShard& shard = shardFor(workerId);
+  shard.totalTaskTimeNs.fetch_add(timeNs, std::memory_order_relaxed);
+  if(reserved) {
+    reservedTasks.fetch_add(1, std::memory_order_relaxed);
+  }
+  int64_t endNs = coarseMonotonicNs();
+  //先从进行中的任务里移除 再按秒记入窗口 读取者最多少算这一瞬间 不会重复计算
+  for(size_t lane = 0; lane <= (reserved ? 1u : 0u); ++lane) {
+    if(beganNs != kNotBegan) {
+      shard.running[lane].fetch_sub(1, std::memory_order_relaxed);
+      shard.runningSinceNs[lane].fetch_sub(beganNs, std::memory_order_release);
+    }
+    //执行时间用精确时钟测量 粗粒度时钟只决定分摊到哪几秒
+    shard.window.addSpan(lane == 0 ? RATE_BUSY_NS : RATE_RESERVED_BUSY_NS,
+                         endNs - static_cast<int64_t>(timeNs), endNs);
+  }
+}
+
+void ThreadPoolMetrics::recordLatency(size_t workerId, TaskPriority priority,
+                                      uint64_t waitNs, uint64_t executionNs) {
+  size_t index = shardIndex(workerId);
+  LatencyShard* shard = latencyShards[index].load(std::memory_order_acquire);
+  if(shard == nullptr) {
+    //同一分片可能被两个线程同时初始化(分片数少于线程数) 失败的一方释放自己的分片
+    LatencyShard* fresh = new LatencyShard();
+    if(latencyShards[index].compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)) {
+      shard = fresh;
+    } else {
+      delete fresh;
+    }
+  }
+
+  size_t p = static_cast<size_t>(priority);
+  shard->histograms[static_cast<size_t>(LatencyKind::WAIT)][p].record(waitNs);
+  shard->histograms[static_cast<size_t>(LatencyKind::EXECUTION)][p].record(executionNs);
+  shard->histograms[static_cast<size_t>(LatencyKind::END_TO_END)][p].record(waitNs + executionNs);
+}
+
+namespace {
+
+// 合并所有分片的累计值
+LatencySnapshot collectLatency(const std::atomic<LatencyShard*>* shards, size_t count) {
+  LatencySnapshot snapshot;
+  for(size_t i = 0; i < count; ++i) {
+    const LatencyShard* shard = shards[i].load(std::memory_order_acquire);
+    if(shard == nullptr) continue;
+    for(size_t k = 0; k < kLatencyKindCount; ++k) {
+      for(size_t p = 0; p < kPriorityCount; ++p) {
+        shard->histograms[k][p].addTo(snapshot.histograms[k][p]);
+      }
+    }
+  }
+  return snapshot;
+}
+
+}  // namespace
+
+LatencySnapshot ThreadPoolMetrics::getLatencySnapshot() const {
+  LatencySnapshot snapshot = collectLatency(latencyShards, kShardCount);
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  snapshot.subtract(resetBaseline);
+  return snapshot;
+}
+
+LatencySnapshot ThreadPoolMetrics::takeLatencyInterval() {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  LatencySnapshot current = collectLatency(latencyShards, kShardCount);
+  LatencySnapshot interval = current;
+  interval.subtract(intervalBaseline);
+  intervalBaseline = std::move(current);
+  return interval;
+}
+
+LatencySnapshot ThreadPoolMetrics::getLatencyTotals() const {
+  return collectLatency(latencyShards, kShardCount);
+}
+
+void ThreadPoolMetrics::resetLatency() {
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  resetBaseline = collectLatency(latencyShards, kShardCount);
+}
+
+size_t ThreadPoolMetrics::getTotalTasks() const {
+  size_t total = 0;
+  for(const auto& shard : shards) total += shard.totalTasks.load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t ThreadPoolMetrics::getCompletedTasks() const {
+  size_t total = 0;
+  for(const auto& shard : shards) total += shard.completedTasks.load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t ThreadPoolMetrics::getFailedTasks() const {
+  size_t total = 0;
+  for(const auto& shard : shards) total += shard.failedTasks.load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t ThreadPoolMetrics::getTimeoutTasks() const {
+  size_t total = 0;
+  for(const auto& shard : shards) total += shard.timeOutTasks.load(std::memory_order_relaxed);
+  return total;
+}
+
+uint64_t ThreadPoolMetrics::getTotalTaskTimeNs() const {
+  uint64_t total = 0;
+  for(const auto& shard : shards) total += shard.totalTaskTimeNs.load(std::memory_order_relaxed);
+  return total;
+}
+
+// 窗口由最近window个整秒桶加当前这一秒组成 最旧的桶按当前秒已过去的比例扣除
+// 这样窗口长度始终是window秒 不会在每秒开始时跳变
+WindowedRates ThreadPoolMetrics::getWindowedRates(std::chrono::seconds window) const {
+  int64_t seconds = std::clamp<int64_t>(window.count(), 1, RateWindow::kMaxWindowSeconds);
+  int64_t nowNs = coarseMonotonicNs();
+  int64_t current = nowNs / 1000000000;
+  double elapsedInSecond = static_cast<double>(nowNs % 1000000000) / 1e9;
+
+  double totals[kRateCounterCount] = {};
+  int64_t windowStartNs = nowNs - seconds * 1000000000;
+  for(const auto& shard : shards) {
+    for(size_t c = 0; c < kRateCounterCount; ++c) {
+      RateCounter counter = static_cast<RateCounter>(c);
+      double sum = static_cast<double>(shard.window.get(current - seconds, counter)) * (1.0 - elapsedInSecond);
+      for(int64_t s = current - seconds + 1; s <= current; ++s) {
+        sum += static_cast<double>(shard.window.get(s, counter));
+      }
+      totals[c] += sum;
+    }
+    //还没有结束的任务从开始时间(不早于窗口起点)算到现在
+    //同一分片上有多个任务时用平均开始时间近似 两个计数之间的并发更新可能造成短暂误差 结果截断到合理范围
+    for(size_t lane = 0; lane < 2; ++lane) {
+      uint32_t running = shard.running[lane].load(std::memory_order_acquire);
+      if(running == 0) {
+        continue;
+      }
+      int64_t since = shard.runningSinceNs[lane].load(std::memory_order_acquire) / static_cast<int64_t>(running);
+      int64_t busy = std::clamp<int64_t>(nowNs - std::max(since, windowStartNs), 0, seconds * 1000000000);
+      totals[lane == 0 ? RATE_BUSY_NS : RATE_RESERVED_BUSY_NS] += static_cast<double>(busy) * running;
+    }
+  }
+
+  //线程池运行时间不足一个窗口时按实际运行时间计算
+  double span = std::min(static_cast<double>(seconds), getUptime());
+  if(span <= 0.0) span = static_cast<double>(seconds);
+
+  WindowedRates rates;
+  rates.submittedPerSec = totals[RATE_SUBMITTED] / span;
+  rates.completedPerSec = totals[RATE_COMPLETED] / span;
+  rates.failedPerSec = totals[RATE_FAILED] / span;
+  rates.timeoutPerSec = totals[RATE_TIMEOUT] / span;
+  size_t threads = threadCount.load(std::memory_order_relaxed);
+  if(threads > 0) {
+    double sharedBusy = std::max(0.0, totals[RATE_BUSY_NS] - totals[RATE_RESERVED_BUSY_NS]);
+    rates.utilization = std::min(1.0, sharedBusy / 1e9 / (span * static_cast<double>(threads)));
+  }
+  size_t reserved = reservedThreads.load(std::memory_order_relaxed);
+  if(reserved > 0) {
+    rates.reservedUtilization = std::min(1.0, totals[RATE_RESERVED_BUSY_NS] / 1e9 /
+                                         (span * static_cast<double>(reserved)));
+  }
+  return rates;
+}
+
 // 更新队列大小并记录峰值
 void ThreadPoolMetrics::updateQueueSize(size_t size) {
   /*
@@ -12,37 +229,39 @@ void ThreadPoolMetrics::updateQueueSize(size_t size) {
   memory_order_relaxed：只保证原子性，不保证顺序性。
   memory_order_acquire：当前线程之后的读写不能重排到这个 load 之前。
   memory_order_seq_cst：顺序一致性，最严格，所有线程看到的顺序相同*/
-  size_t currentPeak = peakQueueSize.load();
-  
+  queueSize.store(size, std::memory_order_relaxed);
+  size_t currentPeak = peakQueueSize.load(std::memory_order_relaxed);
+
   //并发编程原语 用来在多线程条件下更新
   //如果当前原子值 == expected，则更新为 desired，返回 true。
   //否则，返回 false，并把实际值写回 expected。
+  //峰值很少变化 大多数情况下只有一次读取 不会写缓存行
   while(size > currentPeak && !peakQueueSize.compare_exchange_weak(currentPeak, size)){
     // 如果更新失败，currentPeak会被更新为当前值(把当前的实际值写回currentPeak)，然后重试
   }
 
 }
 
-// 更新活跃线程数并记录峰值
-void ThreadPoolMetrics::updateActiveThreads(size_t count) {
-  activeThreads.store(count);
-  size_t currentPeak = peakThreads.load();
+// 活跃线程数加一并记录峰值
+void ThreadPoolMetrics::threadStarted() {
+  size_t count = activeThreads.fetch_add(1) + 1;
+  size_t currentPeak = peakThreads.load(std::memory_order_relaxed);
   while(count > currentPeak && !peakThreads.compare_exchange_weak(currentPeak, count)) {
 
   }
 
 }
 
-// 添加任务执行时间
-void ThreadPoolMetrics::addTaskTime(uint64_t timeNs) {
-  totalTaskTimeNs.fetch_add(timeNs);
+// 活跃线程数减一
+void ThreadPoolMetrics::threadFinished() {
+  activeThreads.fetch_sub(1);
 }
 
 // 获取平均任务执行时间（毫秒）
 double ThreadPoolMetrics::getAverageTaskTime() const {
-  size_t completed = completedTasks.load();
+  size_t completed = getCompletedTasks();
   if(completed == 0)  return 0.0;
-  return static_cast<double>(totalTaskTimeNs.load()) / completed / 1000000.0;
+  return static_cast<double>(getTotalTaskTimeNs()) / completed / 1000000.0;
 }
 
 // 获取线程池运行时间（秒）
@@ -55,7 +274,7 @@ double ThreadPoolMetrics::getUptime() const {
 double ThreadPoolMetrics::getThroughput() const {
   double uptime = getUptime();
   if(uptime <= 0.0) return 0.0;
-  return static_cast<double>(completedTasks.load()) / uptime;
+  return static_cast<double>(getCompletedTasks()) / uptime;
 }
 
 // 获取性能报告
@@ -63,13 +282,63 @@ std::string ThreadPoolMetrics::getReport() const {
   std::stringstream ss;
   ss << "线程池性能报告:" << std::endl;
   ss << "  运行时间: " << getUptime() << " 秒" << std::endl;
-  ss << "  总任务数: " << totalTasks.load() << std::endl;
-  ss << "  已完成任务数: " << completedTasks.load() << std::endl;
-  ss << "  失败任务数: " << failedTasks.load() << std::endl;
+  ss << "  总任务数: " << getTotalTasks() << std::endl;
+  ss << "  已完成任务数: " << getCompletedTasks() << std::endl;
+  ss << "  失败任务数: " << getFailedTasks() << std::endl;
   ss << "  当前活跃线程数: " << activeThreads.load() << std::endl;
   ss << "  峰值活跃线程数: " << peakThreads.load() << std::endl;
   ss << "  峰值队列大小: " << peakQueueSize.load() << std::endl;
+  if(stuckTasks.load() > 0) {
+    ss << "  卡住任务数: " << stuckTasks.load() << " (当前 " << currentStuckTasks.load()
+       << ", 替补线程 " << replacementWorkers.load() << ")" << std::endl;
+  }
+  if(compensatingWorkers.load() > 0) {
+    ss << "  阻塞区补偿线程数: " << compensatingWorkers.load() << " (当前阻塞 " << blockedThreads.load()
+       << ")" << std::endl;
+  }
+  if(reservedThreads.load() > 0 || reservedTasks.load() > 0) {
+    ss << "  预留通道: " << reservedThreads.load() << " 个线程, 执行任务 " << reservedTasks.load()
+       << ", 最近60秒利用率 " << getWindowedRates(std::chrono::seconds(60)).reservedUtilization * 100.0
+       << "%" << std::endl;
+  }
+  if(schedulingErrors.load() > 0) {
+    ss << "  调度参数设置失败次数: " << schedulingErrors.load() << std::endl;
+  }
+  if(helpedTasks.load() > 0) {
+    ss << "  等待线程代为执行的任务数: " << helpedTasks.load() << std::endl;
+  }
+  if(spilledBytes.load() > 0) {
+    ss << "  溢出到磁盘: 写入 " << spilledBytes.load() << " 字节, 读回 " << reloadedBytes.load()
+       << " 字节, 仍在磁盘上的任务 " << spilledTasks.load() << std::endl;
+  }
+  if(sharedQueueTasks.load() > 0) {
+    ss << "  来自共享内存队列的任务数: " << sharedQueueTasks.load();
+    if(sharedQueueDropped.load() > 0) {
+      ss << " (丢弃结果 " << sharedQueueDropped.load() << ")";
+    }
+    ss << std::endl;
+  }
+  if(coalescedTasks.load() > 0) {
+    ss << "  合并到同ID任务的提交数: " << coalescedTasks.load() << std::endl;
+  }
+  if(rateLimiter) {
+    ss << rateLimiter->getReport();
+  }
+  if(tenants) {
+    ss << tenants->getReport();
+  }
   ss << "  平均任务执行时间: " << getAverageTaskTime() << " 毫秒" << std::endl;
   ss << "  任务吞吐量: " << getThroughput() << " 任务/秒" << std::endl;
+  WindowedRates recent = getWindowedRates(std::chrono::seconds(10));
+  ss << "  最近10秒: 完成 " << recent.completedPerSec << " 任务/秒, 利用率 "
+     << recent.utilization * 100.0 << "%" << std::endl;
+
+  HistogramSnapshot endToEnd = getLatencySnapshot().merged(LatencyKind::END_TO_END);
+  if(endToEnd.count() > 0) {
+    ss << "  端到端延迟(微秒): p50=" << endToEnd.percentile(50) / 1000.0
+       << " p99=" << endToEnd.percentile(99) / 1000.0
+       << " p99.9=" << endToEnd.percentile(99.9) / 1000.0
+       << " max=" << endToEnd.max() / 1000.0 << std::endl;
+  }
   return ss.str();
-}
\ No newline at end of file
+}
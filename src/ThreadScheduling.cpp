@@ -0,0 +1,72 @@
+#include "ThreadScheduling.h"
+#include <cerrno>
+#include <linux/capability.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Linux上nice值是线程属性 setpriority(PRIO_PROCESS, tid)只作用于该线程
+id_t currentTid() {
+  return static_cast<id_t>(::syscall(SYS_gettid));
+}
+
+// 只查询有效能力集 不依赖libcap
+bool hasCapSysNice() {
+  __user_cap_header_struct header{};
+  __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3] = {};
+  header.version = _LINUX_CAPABILITY_VERSION_3;
+  header.pid = 0;
+  if(::syscall(SYS_capget, &header, data) != 0) {
+    return false;
+  }
+  return (data[CAP_TO_INDEX(CAP_SYS_NICE)].effective & CAP_TO_MASK(CAP_SYS_NICE)) != 0;
+}
+
+}  // namespace
+
+bool applySchedulingTier(const SchedulingTier& tier) {
+  sched_param param{};
+  param.sched_priority = tier.isRealtime() ? tier.realtimePriority : 0;
+  int rc = pthread_setschedparam(pthread_self(), tier.policy, &param);
+  if(rc != 0) {
+    errno = rc;
+    return false;
+  }
+  if(!tier.isRealtime()) {
+    return setCurrentThreadNice(tier.niceValue);
+  }
+  return true;
+}
+
+int getCurrentThreadNice() {
+  errno = 0;
+  return ::getpriority(PRIO_PROCESS, currentTid());
+}
+
+bool setCurrentThreadNice(int niceValue) {
+  return ::setpriority(PRIO_PROCESS, currentTid(), niceValue) == 0;
+}
+
+// 内核的规则: 降低nice值时要求 20 - niceValue <= RLIMIT_NICE软限制 或者有CAP_SYS_NICE
+bool canLowerNiceTo(int niceValue) {
+  rlimit limit{};
+  if(::getrlimit(RLIMIT_NICE, &limit) == 0 &&
+     (limit.rlim_cur == RLIM_INFINITY || static_cast<rlim_t>(20 - niceValue) <= limit.rlim_cur)) {
+    return true;
+  }
+  return hasCapSysNice();
+}
+
+const char* schedulingPolicyName(int policy) {
+  switch(policy) {
+    case SCHED_OTHER: return "SCHED_OTHER";
+    case SCHED_BATCH: return "SCHED_BATCH";
+    case SCHED_IDLE:  return "SCHED_IDLE";
+    case SCHED_FIFO:  return "SCHED_FIFO";
+    case SCHED_RR:    return "SCHED_RR";
+    default:          return "unknown";
+  }
+}
@@ -0,0 +1,87 @@
+#include "WorkerThread.h"
+#include <alloca.h>
+#include <algorithm>
+#include <climits>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <unistd.h>
+
+WorkerThread::WorkerThread(std::function<void()> body, size_t stackSize) {
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  if(stackSize > 0) {
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = std::max(stackSize, static_cast<size_t>(PTHREAD_STACK_MIN));
+    size = (size + pageSize - 1) / pageSize * pageSize;
+    pthread_attr_setstacksize(&attr, size);
+  }
+
+  auto* arg = new std::function<void()>(std::move(body));
+  int rc = pthread_create(&handle, &attr, &WorkerThread::trampoline, arg);
+  pthread_attr_destroy(&attr);
+  if(rc != 0) {
+    delete arg;
+    throw std::system_error(rc, std::generic_category(), "pthread_create");
+  }
+  started = true;
+}
+
+WorkerThread::WorkerThread(WorkerThread&& other) noexcept
+  : handle(other.handle), started(other.started) {
+  other.started = false;
+}
+
+WorkerThread& WorkerThread::operator=(WorkerThread&& other) noexcept {
+  if(started) {
+    std::terminate();
+  }
+  handle = other.handle;
+  started = other.started;
+  other.started = false;
+  return *this;
+}
+
+WorkerThread::~WorkerThread() {
+  if(started) {
+    std::terminate();
+  }
+}
+
+void WorkerThread::join() {
+  if(!started) {
+    throw std::system_error(std::make_error_code(std::errc::invalid_argument), "join");
+  }
+  int rc = pthread_join(handle, nullptr);
+  if(rc != 0) {
+    throw std::system_error(rc, std::generic_category(), "pthread_join");
+  }
+  started = false;
+}
+
+void* WorkerThread::trampoline(void* arg) {
+  std::unique_ptr<std::function<void()>> body(static_cast<std::function<void()>*>(arg));
+  (*body)();
+  return nullptr;
+}
+
+void WorkerThread::prefaultStack(size_t bytes) {
+  if(bytes == 0) {
+    return;
+  }
+  //留出余量 不超过当前线程栈的一半
+  pthread_attr_t attr;
+  if(pthread_getattr_np(pthread_self(), &attr) == 0) {
+    size_t stackSize = 0;
+    pthread_attr_getstacksize(&attr, &stackSize);
+    pthread_attr_destroy(&attr);
+    if(stackSize > 0) {
+      bytes = std::min(bytes, stackSize / 2);
+    }
+  }
+  const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  volatile char* base = static_cast<volatile char*>(alloca(bytes));
+  for(size_t offset = 0; offset < bytes; offset += pageSize) {
+    base[offset] = 0;
+  }
+}
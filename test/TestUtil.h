@@ -0,0 +1,44 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// 各测试共用的输出和断言 每个测试是独立的可执行文件 failures在main结束时决定退出码
+
+// 打印分隔线
+inline void printSeparator(const std::string& title) {
+    std::cout << "\n" << std::string(50, '=') << std::endl;
+    std::cout << "  " << title << std::endl;
+    std::cout << std::string(50, '=') << std::endl;
+}
+
+inline int failures = 0;
+
+inline void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "  ✓ " : "  ✗ ") << what << std::endl;
+    if (!ok) {
+        ++failures;
+    }
+}
+
+inline bool contains(const std::string& text, const std::string& needle) {
+    return text.find(needle) != std::string::npos;
+}
+
+// 轮询直到条件成立或超时
+template<class Predicate>
+bool waitUntil(Predicate predicate, std::chrono::milliseconds limit) {
+    auto deadline = std::chrono::steady_clock::now() + limit;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (predicate()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return predicate();
+}
+
+#endif
@@ -0,0 +1,156 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator("对数线性分桶测试");
+    {
+        bool consistent = true;
+        for (uint64_t v : {0ull, 1ull, 63ull, 64ull, 65ull, 1000ull, 123456ull, 999999999ull, 1ull << 39}) {
+            size_t index = LatencyBuckets::indexOf(v);
+            if (v < LatencyBuckets::lowerBound(index) || v > LatencyBuckets::upperBound(index)) {
+                consistent = false;
+                std::cout << "  值 " << v << " 不在桶 " << index << " 的范围内" << std::endl;
+            }
+        }
+        check(consistent, "每个值都落在所在桶的上下界之间");
+        check(LatencyBuckets::indexOf(UINT64_MAX) == LatencyBuckets::kBucketCount - 1, "超出范围的值计入最后一个桶");
+
+        // 1..10000微秒均匀分布 分位数误差应在1/32以内
+        LatencyHistogram histogram;
+        for (uint64_t us = 1; us <= 10000; ++us) {
+            histogram.record(us * 1000);
+        }
+        HistogramSnapshot snapshot;
+        histogram.addTo(snapshot);
+        uint64_t p50 = snapshot.percentile(50);
+        uint64_t p99 = snapshot.percentile(99);
+        std::cout << "  p50=" << p50 << "ns p99=" << p99 << "ns max=" << snapshot.max() << "ns" << std::endl;
+        check(snapshot.count() == 10000, "样本数正确");
+        check(p50 >= 5000000 && p50 <= 5000000 + 5000000 / 32, "p50误差在分桶精度内");
+        check(p99 >= 9900000 && p99 <= 9900000 + 9900000 / 32, "p99误差在分桶精度内");
+    }
+
+    printSeparator("线程池延迟直方图测试");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 20; ++i) {
+            futures.push_back(pool.enqueueWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), []() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }));
+        }
+        for (int i = 0; i < 50; ++i) {
+            futures.push_back(pool.enqueueWithPriority(TaskPriority::LOW, std::chrono::milliseconds(0), []() {}));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+        pool.waitForTasks();
+
+        LatencySnapshot snapshot = pool.getLatencySnapshot();
+        const HistogramSnapshot& highExec = snapshot.get(LatencyKind::EXECUTION, TaskPriority::HIGH);
+        const HistogramSnapshot& lowWait = snapshot.get(LatencyKind::WAIT, TaskPriority::LOW);
+        check(highExec.count() == 20, "HIGH优先级记录了20次执行时间");
+        check(lowWait.count() == 50, "LOW优先级记录了50次排队时间");
+        check(highExec.percentile(50) >= 2000000, "执行时间p50不小于任务的睡眠时间");
+        check(snapshot.merged(LatencyKind::END_TO_END).count() == 70, "端到端直方图合并所有优先级");
+        // LOW任务排在HIGH任务之后 排队时间至少包含部分HIGH任务的执行时间
+        check(lowWait.percentile(99) >= 2000000, "LOW任务的排队时间反映了优先级调度");
+
+        LatencySnapshot first = pool.takeLatencyInterval();
+        check(first.merged(LatencyKind::END_TO_END).count() == 70, "第一个区间包含全部样本");
+        pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {}).get();
+        pool.waitForTasks();
+        LatencySnapshot second = pool.takeLatencyInterval();
+        check(second.merged(LatencyKind::END_TO_END).count() == 1, "第二个区间只包含新样本");
+
+        pool.resetLatencyHistograms();
+        check(pool.getLatencySnapshot().merged(LatencyKind::WAIT).count() == 0, "重置后快照为空");
+
+        std::cout << pool.getMetricsReport();
+    }
+
+    printSeparator("任务CPU时间统计测试");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.enableTaskAccounting();
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 4; ++i) {
+            // 计算型任务: 固定的计算量 被抢占时只是耗时变长
+            futures.push_back(pool.enqueueWithInfo("", "cpu", TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {
+                volatile uint64_t x = 0;
+                for (int n = 0; n < 20000000; ++n) {
+                    x = x + 1;
+                }
+            }));
+            // 阻塞型任务: 睡眠20毫秒
+            futures.push_back(pool.enqueueWithInfo("", "io", TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+        pool.waitForTasks();
+
+        std::vector<CategoryUsage> usage = pool.getTaskCategoryUsage();
+        const CategoryUsage* cpu = nullptr;
+        const CategoryUsage* io = nullptr;
+        for (const auto& u : usage) {
+            if (u.category == "cpu") cpu = &u;
+            if (u.category == "io") io = &u;
+        }
+        std::cout << pool.getTaskAccountingReport();
+        check(cpu != nullptr && io != nullptr && cpu->tasks == 4 && io->tasks == 4, "按描述分类统计任务数");
+        // 负载高时计算型任务会被抢占 绝对占比不稳定 只比较两类任务
+        check(cpu != nullptr && io != nullptr && cpu->cpuRatio() > io->cpuRatio(), "计算型任务的CPU占比高于阻塞型任务");
+        check(io != nullptr && io->cpuRatio() < 0.2, "阻塞型任务的CPU占比低");
+        check(io != nullptr && io->voluntarySwitches >= 4, "阻塞型任务产生主动上下文切换");
+
+        pool.resetTaskAccounting();
+        check(pool.getTaskCategoryUsage().empty(), "重置后统计为空");
+    }
+
+    printSeparator("任务类别数有上限");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.enableTaskAccounting(true, 3);
+        std::vector<std::function<void()>> batch(50, []() {});
+        // 描述为"batch 0" ~ "batch 49" 归一化为同一个类别
+        for (auto& f : pool.enqueueManyWithIdPrefix("b", "batch", batch)) {
+            f.get();
+        }
+        for (const char* name : {"a", "b", "c", "d\"\n\x01"}) {
+            pool.enqueueWithInfo("", name, TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {}).get();
+        }
+        pool.waitForTasks();
+
+        std::vector<CategoryUsage> usage = pool.getTaskCategoryUsage();
+        uint64_t batched = 0;
+        uint64_t overflow = 0;
+        for (const auto& u : usage) {
+            if (u.category == "batch #") batched = u.tasks;
+            if (u.category == TaskAccounting::kOverflowCategory) overflow = u.tasks;
+        }
+        check(batched == 50, "描述中的编号归一化为一个类别");
+        check(usage.size() == 4 && overflow == 2, "超过上限的新类别计入溢出类别");
+
+        std::string json = pool.exportMetricsJson();
+        check(contains(json, "\"category\":\"batch #\""), "JSON中的类别");
+
+        pool.resetTaskAccounting();
+        pool.enqueueWithInfo("", "d\"\n\x01", TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {}).get();
+        pool.waitForTasks();
+        check(contains(pool.exportMetricsJson(), "\"category\":\"d\\\"\\u000a\\u0001\""),
+              "JSON字符串中的控制字符转义为\\uXXXX");
+    }
+
+    printSeparator(failures == 0 ? "延迟与资源统计测试通过" : "延迟与资源统计测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 发送一个GET请求并读取完整响应
+std::string httpGet(int fd, const std::string& path) {
+    std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return response;
+}
+
+std::string getTcp(uint16_t port, const std::string& path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return "";
+    }
+    return httpGet(fd, path);
+}
+
+std::string getUnix(const std::string& socketPath, const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return "";
+    }
+    return httpGet(fd, path);
+}
+
+int main() {
+    ThreadPool pool(2, LogLevel::ERROR);
+
+    printSeparator("OpenMetrics序列化测试");
+    {
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 10; ++i) {
+            futures.push_back(pool.enqueueWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), []() {}));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+        pool.waitForTasks();
+
+        std::string text = pool.exportOpenMetrics();
+        check(contains(text, "threadpool_tasks_completed_total 10\n"), "完成计数器");
+        check(contains(text, "threadpool_threads 2\n"), "线程数仪表");
+        check(contains(text, "threadpool_task_wait_seconds_count{priority=\"high\"} 10\n"), "按优先级的排队时间直方图");
+        check(contains(text, "threadpool_task_execution_seconds_bucket{priority=\"high\",le=\"+Inf\"} 10\n"), "直方图+Inf桶等于样本数");
+        check(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0, "以# EOF结尾");
+        // 秒数由整数纳秒精确写出 不受浮点默认6位有效数字的限制
+        check(contains(text, "le=\"0.000001\"} ") && contains(text, "le=\"10\"} "), "桶边界精确输出");
+        const std::string taskTimeName = "threadpool_task_time_seconds_total ";
+        size_t pos = text.find(taskTimeName) + taskTimeName.size();
+        std::string taskTime = text.substr(pos, text.find('\n', pos) - pos);
+        check(taskTime.find('e') == std::string::npos && taskTime.find('.') != std::string::npos,
+              "累计执行时间不用科学计数法: " + taskTime);
+
+        // 暂停时任务留在队列中 队列长度仪表无需加锁即可读到
+        pool.pause();
+        for (int i = 0; i < 5; ++i) {
+            pool.post(TaskPriority::LOW, []() {});
+        }
+        check(contains(pool.exportOpenMetrics(), "threadpool_queue_size 5\n"), "队列长度仪表");
+        pool.resume();
+        pool.waitForTasks();
+
+        std::string json = pool.exportMetricsJson();
+        check(contains(json, "\"completed\":15"), "JSON快照包含完成数");
+        check(contains(json, "\"latency_ns\":{\"wait\":{\"low\":{\"count\":5"), "JSON快照包含延迟分布");
+    }
+
+    printSeparator("滑动窗口速率测试");
+    {
+        // 两个线程各忙碌约100毫秒
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 4; ++i) {
+            futures.push_back(pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+        pool.waitForTasks();
+
+        WindowedRates rates = pool.getWindowedRates(std::chrono::seconds(10));
+        std::cout << "  10秒窗口: 提交 " << rates.submittedPerSec << "/s, 完成 " << rates.completedPerSec
+                  << "/s, 利用率 " << rates.utilization << std::endl;
+        check(rates.completedPerSec > 0.0, "窗口内完成速率大于0");
+        check(rates.submittedPerSec >= rates.completedPerSec * 0.9, "提交速率与完成速率一致");
+        check(rates.failedPerSec == 0.0 && rates.timeoutPerSec == 0.0, "没有失败和超时");
+        check(rates.utilization > 0.0 && rates.utilization <= 1.0, "利用率在(0, 1]之间");
+
+        std::string text = pool.exportOpenMetrics();
+        check(contains(text, "threadpool_completed_rate{window=\"10s\"} "), "OpenMetrics包含窗口速率");
+        check(contains(pool.exportMetricsJson(), "\"rates\":{\"1s\":"), "JSON包含窗口速率");
+    }
+    {
+        // 还没有结束的任务同样计入忙碌时间 不会等到结束的那一秒才一次性计入
+        ThreadPool busyPool(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        busyPool.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        double running = busyPool.getWindowedRates(std::chrono::seconds(1)).utilization;
+        check(running > 0.8, "执行中的任务计入利用率: " + std::to_string(running));
+        gate.set_value();
+        busyPool.waitForTasks();
+        double finished = busyPool.getWindowedRates(std::chrono::seconds(1)).utilization;
+        check(finished > 0.8 && finished <= 1.0, "结束后按秒分摊: " + std::to_string(finished));
+    }
+
+    printSeparator("指标分片");
+    {
+        // 预留通道线程和替补线程不与同编号的常规线程共享分片
+        size_t regular = ThreadPoolMetrics::shardIndex(0);
+        size_t reserved = ThreadPoolMetrics::shardIndex(ThreadPool::kReservedWorkerIdBase);
+        size_t temporary = ThreadPoolMetrics::shardIndex(ThreadPool::kTemporaryWorkerIdBase);
+        check(regular != reserved && regular != temporary && reserved != temporary, "三类工作线程使用不同分片");
+    }
+
+    printSeparator("HTTP服务测试");
+    {
+        check(pool.startMetricsServer(0), "在本机随机端口启动指标服务");
+        uint16_t port = pool.getMetricsServerPort();
+        std::cout << "  端口: " << port << std::endl;
+
+        std::string response = getTcp(port, "/metrics");
+        check(contains(response, "HTTP/1.1 200 OK"), "GET /metrics 返回200");
+        check(contains(response, "application/openmetrics-text"), "OpenMetrics内容类型");
+        check(contains(response, "threadpool_tasks_submitted_total 19"), "响应体包含指标");
+
+        check(contains(getTcp(port, "/metrics.json"), "\"submitted\":19"), "GET /metrics.json 返回JSON");
+        check(contains(getTcp(port, "/other"), "404"), "未知路径返回404");
+
+        const std::string socketPath = "test_day11_metrics.sock";
+        check(pool.startMetricsServerUnix(socketPath), "在Unix域套接字上启动指标服务");
+        check(pool.getMetricsServerPort() == 0, "Unix套接字模式没有TCP端口");
+        check(contains(getUnix(socketPath, "/metrics"), "threadpool_tasks_completed_total 19"), "通过Unix套接字抓取");
+
+        pool.stopMetricsServer();
+        check(access(socketPath.c_str(), F_OK) != 0, "停止后删除套接字文件");
+    }
+
+    printSeparator(failures == 0 ? "指标导出测试通过" : "指标导出测试失败");
+    return failures == 0 ? 0 : 1;
+}
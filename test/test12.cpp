@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator(kLockProfilingEnabled ? "锁竞争统计测试(已编译)" : "锁竞争统计测试(未编译)");
+    {
+        ThreadPool pool(4, LogLevel::ERROR);
+        pool.resetLockStats();
+
+        // 四个生产者并发提交 制造queue_mutex竞争
+        const int producers = 4;
+        const int perProducer = 2000;
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&pool, p]() {
+                for (int i = 0; i < perProducer; ++i) {
+                    pool.post(TaskPriority::MEDIUM, []() {});
+                }
+                pool.enqueueWithInfo("lock-" + std::to_string(p), "", TaskPriority::LOW,
+                                     std::chrono::milliseconds(0), []() {}).get();
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        pool.waitForTasks();
+        pool.getTaskStatus("lock-0");
+        pool.cancelTask("missing");
+
+        LockSiteReport enqueue = pool.getLockStats(LockSite::ENQUEUE);
+        LockSiteReport next = pool.getLockStats(LockSite::GET_NEXT_TASK);
+        LockSiteReport status = pool.getLockStats(LockSite::GET_TASK_STATUS);
+        LockSiteReport cancel = pool.getLockStats(LockSite::CANCEL_TASK);
+        LockSiteReport wait = pool.getLockStats(LockSite::WAIT_FOR_TASKS);
+        std::cout << pool.getLockReport();
+
+        if (kLockProfilingEnabled) {
+            const uint64_t submitted = producers * (perProducer + 1);
+            check(enqueue.acquisitions == submitted, "每次提交记录一次enqueue加锁");
+            check(next.acquisitions >= submitted / 4, "工作线程取任务的加锁被记录");
+            check(enqueue.holdNs > 0 && next.holdNs > 0, "记录了持锁时间");
+            check(enqueue.contended <= enqueue.acquisitions, "竞争次数不超过加锁次数");
+            check(enqueue.maxHoldNs * enqueue.acquisitions >= enqueue.holdNs, "最长持锁时间不小于平均值");
+            check(status.acquisitions == 1 && cancel.acquisitions == 1, "查询与取消按各自位置统计");
+            check(wait.acquisitions == 1, "waitForTasks按自己的位置统计");
+            check(pool.exportOpenMetrics().find("threadpool_lock_wait_seconds_total{site=\"enqueue\"}") != std::string::npos,
+                  "OpenMetrics导出锁统计");
+
+            pool.resetLockStats();
+            check(pool.getLockStats(LockSite::ENQUEUE).acquisitions == 0, "重置后统计清零");
+        } else {
+            check(enqueue.acquisitions == 0 && next.acquisitions == 0, "未编译时不记录任何统计");
+            check(pool.exportOpenMetrics().find("threadpool_lock_") == std::string::npos, "未编译时不导出锁统计");
+        }
+    }
+
+    printSeparator(failures == 0 ? "锁竞争统计测试通过" : "锁竞争统计测试失败");
+    return failures == 0 ? 0 : 1;
+}
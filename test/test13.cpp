@@ -0,0 +1,147 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator("卡住任务检测与替补线程");
+    {
+        // 只有一个工作线程 卡住后其他任务只能靠替补线程执行
+        ThreadPool pool(1, LogLevel::NONE);
+        WatchdogOptions options;
+        options.scanInterval = std::chrono::milliseconds(10);
+        options.stuckThreshold = std::chrono::milliseconds(50);
+        options.replaceStuckWorkers = true;
+        check(pool.enableWatchdog(options), "启动看门狗");
+
+        std::atomic<bool> release{false};
+        auto stuck = pool.enqueueWithInfo("stuck-1", "等待外部信号", TaskPriority::HIGH,
+                                          std::chrono::milliseconds(0), [&release]() {
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        check(waitUntil([&pool]() { return pool.getStuckTasks().size() == 1; }, std::chrono::seconds(2)),
+              "超过全局阈值的任务被报告");
+        std::vector<StuckTaskInfo> report = pool.getStuckTasks();
+        if (!report.empty()) {
+            check(report[0].taskId == "stuck-1" && report[0].description == "等待外部信号",
+                  "报告包含任务ID和描述");
+            check(report[0].workerId == 0 && report[0].priority == TaskPriority::HIGH, "报告包含工作线程和优先级");
+            check(report[0].runningFor >= options.stuckThreshold, "报告运行时长");
+            check(report[0].replaced, "为卡住的工作线程启动了替补线程");
+        }
+        check(pool.getTemporaryWorkerCount() == 1, "替补线程在运行");
+
+        // 唯一的常规工作线程被占住 这些任务由替补线程完成
+        auto quick = pool.enqueue([]() { return 42; });
+        check(quick.wait_for(std::chrono::seconds(2)) == std::future_status::ready && quick.get() == 42,
+              "卡住期间其他任务仍被执行");
+        check(contains(pool.exportOpenMetrics(), "threadpool_tasks_stuck_total 1\n"), "导出卡住任务计数");
+        check(contains(pool.exportOpenMetrics(), "threadpool_stuck_tasks 1\n"), "导出当前卡住任务数");
+
+        release = true;
+        stuck.get();
+        check(waitUntil([&pool]() { return pool.getStuckTasks().empty(); }, std::chrono::seconds(2)),
+              "任务结束后从卡住列表移除");
+        check(waitUntil([&pool]() { return pool.getTemporaryWorkerCount() == 0; }, std::chrono::seconds(2)),
+              "任务结束后替补线程退休");
+        check(contains(pool.exportMetricsJson(), "\"watchdog\":{\"stuck_total\":1,\"stuck\":0,\"replacement_workers\":1}"),
+              "JSON包含看门狗统计");
+
+        // 快速任务不会被报告
+        for (int i = 0; i < 100; ++i) {
+            pool.post(TaskPriority::MEDIUM, []() {});
+        }
+        pool.waitForTasks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(pool.getStuckTasks().empty(), "短任务不会被报告");
+    }
+
+    printSeparator("看门狗启用后创建的线程");
+    {
+        ThreadPool pool(1, LogLevel::NONE);
+        WatchdogOptions options;
+        options.scanInterval = std::chrono::milliseconds(10);
+        options.stuckThreshold = std::chrono::milliseconds(50);
+        pool.enableWatchdog(options);
+
+        // 扩容超过启用时的线程上限 再加一个预留通道线程 它们卡住同样会被发现
+        pool.setMaxThreads(8);
+        pool.resize(6);
+        pool.setReservedWorkers(1, TaskPriority::CRITICAL);
+        std::atomic<bool> release{false};
+        std::atomic<int> running{0};
+        auto block = [&release, &running]() {
+            running.fetch_add(1);
+            while (!release.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        };
+        for (int i = 0; i < 6; ++i) {
+            pool.post(TaskPriority::MEDIUM, block);
+        }
+        // 常规线程都被占住后 CRITICAL任务只能由预留线程执行
+        waitUntil([&running]() { return running.load() == 6; }, std::chrono::seconds(2));
+        pool.post(TaskPriority::CRITICAL, block);
+        check(waitUntil([&running]() { return running.load() == 7; }, std::chrono::seconds(2)), "7个线程都在执行任务");
+        check(waitUntil([&pool]() { return pool.getStuckTasks().size() == 7; }, std::chrono::seconds(2)),
+              "扩容和预留通道的线程同样被监视: " + std::to_string(pool.getStuckTasks().size()));
+        release = true;
+        pool.waitForTasks();
+        check(waitUntil([&pool]() { return pool.getStuckTasks().empty(); }, std::chrono::seconds(2)),
+              "任务结束后全部移除");
+    }
+
+    printSeparator("看门狗负责任务超时");
+    {
+        ThreadPool pool(2, LogLevel::NONE);
+        WatchdogOptions options;
+        options.scanInterval = std::chrono::milliseconds(10);
+        pool.enableWatchdog(options);
+
+        auto start = std::chrono::steady_clock::now();
+        auto slow = pool.enqueueWithInfo("slow", "超时任务", TaskPriority::MEDIUM, std::chrono::milliseconds(50), []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(400));
+            return 1;
+        });
+        bool timedOut = false;
+        try {
+            slow.get();
+        } catch (const std::runtime_error& e) {
+            timedOut = contains(e.what(), "timed out after 50ms");
+        }
+        auto waited = std::chrono::steady_clock::now() - start;
+        check(timedOut, "超时任务的future收到超时异常");
+        check(waited < std::chrono::milliseconds(350), "不必等待任务结束就报告超时");
+
+        auto fast = pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(500), []() { return 7; });
+        check(fast.get() == 7, "按时完成的任务正常返回结果");
+
+        auto throwing = pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(500), []() -> int {
+            throw std::logic_error("bad input");
+        });
+        bool rethrown = false;
+        try {
+            throwing.get();
+        } catch (const std::logic_error&) {
+            rethrown = true;
+        }
+        check(rethrown, "任务异常原样传给future");
+
+        pool.waitForTasks();
+        std::string json = pool.exportMetricsJson();
+        check(contains(json, "\"timeout\":1,"), "超时计数一次");
+        check(contains(json, "\"failed\":1,"), "异常计数一次");
+
+        pool.disableWatchdog();
+        check(pool.getStuckTasks().empty(), "停止看门狗后清空卡住列表");
+    }
+
+    printSeparator(failures == 0 ? "看门狗测试通过" : "看门狗测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "BasicThreadPool.h"
+#include "TestUtil.h"
+
+// 关闭的策略都是空类 作为基类不占空间
+static_assert(std::is_empty_v<NoMetricsPolicy> && std::is_empty_v<NoLoggingPolicy> &&
+              std::is_empty_v<NoTrackingPolicy>, "关闭的策略必须是空类");
+
+int main() {
+    printSeparator("最小配置");
+    {
+        MinimalThreadPool pool(4);
+        check(pool.getThreadCount() == 4, "线程数");
+
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 100; ++i) {
+            results.push_back(pool.submit([](int x) { return x * x; }, i));
+        }
+        int sum = 0;
+        for (auto& r : results) {
+            sum += r.get();
+        }
+        check(sum == 328350, "submit返回结果");
+
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 1000; ++i) {
+            pool.post([&counter]() { counter.fetch_add(1); });
+        }
+        pool.waitForTasks();
+        check(counter.load() == 1000, "waitForTasks等待所有post任务");
+
+        auto failing = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+        bool thrown = false;
+        try {
+            failing.get();
+        } catch (const std::runtime_error& e) {
+            thrown = std::string(e.what()) == "boom";
+        }
+        check(thrown, "任务异常传给future");
+        pool.post([]() { throw std::logic_error("ignored"); });
+        pool.waitForTasks();
+        check(pool.submit([]() { return 1; }).get() == 1, "任务异常后工作线程继续运行");
+    }
+
+    printSeparator("完整配置");
+    {
+        FullBasicThreadPool pool(1);
+        pool.setLogLevel(LogLevel::NONE);
+
+        // 暂停后按优先级排队 恢复后高优先级先执行
+        pool.pause();
+        std::vector<int> order;
+        std::mutex orderMutex;
+        auto record = [&order, &orderMutex](int value) {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(value);
+        };
+        pool.submitWithPriority(TaskPriority::LOW, record, 1);
+        pool.submitWithPriority(TaskPriority::HIGH, record, 3);
+        pool.submitWithPriority(TaskPriority::MEDIUM, record, 2);
+        pool.submitWithPriority(TaskPriority::HIGH, record, 4);
+        auto canceled = pool.submitWithId("cancel-me", TaskPriority::CRITICAL, record, 99);
+
+        check(pool.getTaskCount() == 5, "暂停时任务留在队列");
+        check(pool.getTaskStatus("cancel-me") == TaskStatus::WAITING, "查询等待中的任务");
+        check(pool.cancelTask("cancel-me"), "取消等待中的任务");
+        check(pool.getTaskStatus("cancel-me") == TaskStatus::CANCELED, "取消后状态为CANCELED");
+        check(!pool.cancelTask("missing"), "不存在的任务无法取消");
+
+        bool duplicate = false;
+        pool.submitWithId("dup", TaskPriority::LOW, []() {});
+        try {
+            pool.submitWithId("dup", TaskPriority::LOW, []() {});
+        } catch (const std::runtime_error&) {
+            duplicate = true;
+        }
+        check(duplicate, "重复ID被拒绝");
+
+        pool.resume();
+        pool.waitForTasks();
+        check(order == std::vector<int>({3, 4, 2, 1}), "按优先级执行 同优先级先进先出");
+        check(pool.getTaskStatus("cancel-me") == TaskStatus::NOT_FOUND, "被取消的任务跳过后移出映射表");
+
+        bool broken = false;
+        try {
+            canceled.get();
+        } catch (const std::future_error&) {
+            broken = true;
+        }
+        check(broken, "被取消任务的future得到broken_promise");
+
+        pool.post([]() { throw std::runtime_error("x"); });
+        pool.waitForTasks();
+        const ThreadPoolMetrics& metrics = pool.getMetrics();
+        check(metrics.getTotalTasks() == 7, "统计提交数");
+        check(metrics.getCompletedTasks() == 5 && metrics.getFailedTasks() == 1, "统计完成数和失败数");
+        check(pool.getMetricsReport().find("总任务数: 7") != std::string::npos, "性能报告");
+    }
+
+    printSeparator(failures == 0 ? "策略线程池测试通过" : "策略线程池测试失败");
+    return failures == 0 ? 0 : 1;
+}
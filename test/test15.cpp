@@ -0,0 +1,115 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 当前线程的栈大小
+size_t currentStackSize() {
+    pthread_attr_t attr;
+    size_t size = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstacksize(&attr, &size);
+        pthread_attr_destroy(&attr);
+    }
+    return size;
+}
+
+int main() {
+    printSeparator("按需创建工作线程");
+    {
+        WorkerStartOptions options;
+        options.lazyStart = true;
+        ThreadPool pool(8, options, LogLevel::ERROR);
+        check(pool.getThreadCount() == 0, "构造时不创建线程");
+
+        check(pool.enqueue([]() { return 5; }).get() == 5, "第一个任务触发创建线程");
+        check(pool.getThreadCount() == 1, "只创建了一个线程");
+
+        // 顺序提交、逐个等待 线程回到等待状态后再提交 不会创建新线程
+        for (int i = 0; i < 5; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            pool.enqueue([]() {}).get();
+        }
+        check(pool.getThreadCount() == 1, "有空闲线程时不创建新线程");
+
+        // 同时阻塞的任务多于线程数 线程数增长到上限为止
+        std::atomic<bool> release{false};
+        std::atomic<int> running{0};
+        std::vector<std::future<void>> blocked;
+        for (int i = 0; i < 12; ++i) {
+            blocked.push_back(pool.enqueue([&release, &running]() {
+                running.fetch_add(1);
+                while (!release.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }));
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (running.load() < 8 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        check(running.load() == 8 && pool.getThreadCount() == 8, "并发需求增长到目标线程数");
+        release = true;
+        for (auto& f : blocked) {
+            f.get();
+        }
+        check(pool.getThreadCount() == 8, "不超过目标线程数");
+
+        pool.resize(10);
+        check(pool.getThreadCount() == 8, "按需模式下扩容只提高上限");
+        pool.resize(4);
+        check(pool.getThreadCount() == 4, "缩容照常回收线程");
+        check(pool.enqueue([]() { return 1; }).get() == 1, "缩容后继续执行任务");
+    }
+
+    printSeparator("预热与栈大小");
+    {
+        WorkerStartOptions options;
+        options.lazyStart = true;
+        options.stackSize = 256 * 1024;
+        ThreadPool pool(4, options, LogLevel::ERROR);
+        check(pool.getThreadCount() == 0, "预热前没有线程");
+
+        pool.prewarm(128 * 1024);
+        check(pool.getThreadCount() == 4, "预热创建全部线程");
+        check(pool.getIdleThreadCount() == 4, "预热返回时4个线程都在等待任务");
+        // 4个互相等待的任务必须同时在4个已有线程上开始 任何一个线程没有就绪都会让它们等到超时
+        std::atomic<int> started{0};
+        std::vector<std::future<bool>> together;
+        for (int i = 0; i < 4; ++i) {
+            together.push_back(pool.enqueue([&started]() {
+                started.fetch_add(1);
+                return waitUntil([&started]() { return started.load() == 4; }, std::chrono::seconds(5));
+            }));
+        }
+        bool allStarted = true;
+        for (auto& f : together) {
+            allStarted = f.get() && allStarted;
+        }
+        check(allStarted, "4个任务同时开始");
+        check(pool.getThreadCount() == 4, "同时执行没有创建新线程");
+
+        size_t stackSize = pool.enqueue([]() { return currentStackSize(); }).get();
+        check(stackSize >= 256 * 1024 && stackSize < 512 * 1024, "工作线程使用指定的栈大小");
+        check(pool.getThreadCount() == 4, "预热后提交不再创建线程");
+
+        pool.prewarm();
+        check(pool.getThreadCount() == 4, "重复预热没有副作用");
+    }
+
+    printSeparator("默认模式");
+    {
+        ThreadPool pool(3, LogLevel::ERROR);
+        check(pool.getThreadCount() == 3, "构造时创建全部线程");
+        check(pool.enqueue([]() { return currentStackSize(); }).get() > 256 * 1024, "默认栈大小");
+    }
+
+    printSeparator(failures == 0 ? "线程启动方式测试通过" : "线程启动方式测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 二分递归求和 每一层在任务内部等待两个子任务
+long long rangeSum(ThreadPool& pool, long long begin, long long end) {
+    if (end - begin <= 64) {
+        long long sum = 0;
+        for (long long i = begin; i < end; ++i) {
+            sum += i;
+        }
+        return sum;
+    }
+    long long mid = begin + (end - begin) / 2;
+    auto left = pool.enqueue(rangeSum, std::ref(pool), begin, mid);
+    auto right = pool.enqueue(rangeSum, std::ref(pool), mid, end);
+    return pool.helpGet(left) + pool.helpGet(right);
+}
+
+int main() {
+    printSeparator("任务内部等待子任务");
+    {
+        // 只有一个工作线程 普通get会永久阻塞
+        ThreadPool pool(1, LogLevel::ERROR);
+        auto fanOut = pool.enqueue([&pool]() {
+            std::vector<std::future<int>> children;
+            for (int i = 0; i < 32; ++i) {
+                children.push_back(pool.enqueue([i]() { return i; }));
+            }
+            int sum = 0;
+            for (auto& child : children) {
+                sum += pool.helpGet(child);
+            }
+            return sum;
+        });
+        check(fanOut.get() == 496, "单线程任务等待子任务不死锁");
+
+        auto total = pool.enqueue(rangeSum, std::ref(pool), 0LL, 256LL);
+        check(total.get() == 256LL * 255 / 2, "嵌套的分治任务");
+        check(pool.getMetricsReport().find("等待线程代为执行的任务数") != std::string::npos, "统计代为执行的任务数");
+    }
+
+    printSeparator("外部线程帮助等待");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        auto blocker = pool.enqueue([opened]() { opened.wait(); });
+        while (pool.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+
+        std::vector<std::string> order;
+        std::mutex orderMutex;
+        auto record = [&order, &orderMutex](const std::string& name) {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(name);
+            return std::this_thread::get_id();
+        };
+        auto low = pool.enqueueWithPriority(TaskPriority::LOW, std::chrono::milliseconds(0), record, "low");
+        auto high = pool.enqueueWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), record, "high");
+        auto target = pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(0), record, "target");
+
+        check(pool.helpGet(target) == std::this_thread::get_id(), "目标任务在调用线程上执行");
+        check(order == std::vector<std::string>({"high", "target"}), "按优先级执行 目标完成后停止");
+        check(pool.getTaskCount() == 1, "低优先级任务留在队列");
+
+        std::shared_future<std::thread::id> shared = low.share();
+        pool.helpWait(shared);
+        check(shared.get() == std::this_thread::get_id(), "helpWait支持shared_future");
+        high.get();
+
+        gate.set_value();
+        blocker.get();
+    }
+
+    printSeparator("帮助等待全部任务");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.post(TaskPriority::CRITICAL, [opened]() { opened.wait(); });
+        while (pool.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 10; ++i) {
+            pool.post(TaskPriority::MEDIUM, [&counter]() { counter.fetch_add(1); });
+        }
+        // 最后执行的低优先级任务放开被阻塞的工作线程
+        pool.post(TaskPriority::LOW, [&gate]() { gate.set_value(); });
+        pool.helpWaitForTasks();
+        check(counter.load() == 10 && pool.getTaskCount() == 0, "外部线程执行排队任务直到全部完成");
+        check(pool.getActiveThreadCount() == 0, "返回时没有正在执行的任务");
+
+        // 任务内部等待自己提交的任务 不把自身计入
+        auto nested = pool.enqueue([&pool, &counter]() {
+            for (int i = 0; i < 5; ++i) {
+                pool.post(TaskPriority::MEDIUM, [&counter]() { counter.fetch_add(1); });
+            }
+            pool.helpWaitForTasks();
+            return counter.load();
+        });
+        check(nested.get() == 15, "任务内部helpWaitForTasks不死锁");
+    }
+
+    printSeparator("暂停时不代为执行");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.pause();
+        auto task = pool.enqueue([]() { return 7; });
+        check(!pool.runPendingTask(), "暂停时runPendingTask返回false");
+        pool.resume();
+        check(pool.helpGet(task) == 7, "恢复后正常完成");
+    }
+
+    printSeparator(failures == 0 ? "帮助等待测试通过" : "帮助等待测试失败");
+    return failures == 0 ? 0 : 1;
+}
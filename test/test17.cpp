@@ -0,0 +1,112 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 提交count个任务: 等到queued为true后进入阻塞区(entered计数) 阻塞在gate上
+std::vector<std::future<bool>> submitBlockers(ThreadPool& pool, size_t count, std::atomic<bool>& queued,
+                                              std::atomic<int>& entered, std::shared_future<void> gate) {
+    std::vector<std::future<bool>> blockers;
+    for (size_t i = 0; i < count; ++i) {
+        blockers.push_back(pool.enqueue([&pool, &queued, &entered, gate]() {
+            while (!queued.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            auto scope = pool.blockingScope();
+            entered.fetch_add(1);
+            gate.wait();
+            return scope.isCompensated();
+        }));
+    }
+    return blockers;
+}
+
+int main() {
+    printSeparator("阻塞区补偿线程");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.setMaxThreads(4);
+        std::atomic<bool> queued{false};
+        std::atomic<int> entered{0};
+        std::promise<void> gate;
+        auto blockers = submitBlockers(pool, 2, queued, entered, gate.get_future().share());
+
+        // 排队任务等两个阻塞区都进入后才完成 保证第二个阻塞区进入时队列仍不为空
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 6; ++i) {
+            pool.post(TaskPriority::MEDIUM, [&counter, &entered]() {
+                while (entered.load() < 2) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                counter.fetch_add(1);
+            });
+        }
+        queued = true;
+
+        check(waitUntil([&counter]() { return counter.load() == 6; }, std::chrono::seconds(5)),
+              "工作线程全部阻塞时排队任务仍然执行");
+        check(pool.getTemporaryWorkerCount() == 2, "每个阻塞区一个补偿线程");
+        check(pool.exportMetricsJson().find("\"blocked\":2") != std::string::npos, "导出阻塞线程数");
+
+        gate.set_value();
+        bool allCompensated = true;
+        for (auto& blocker : blockers) {
+            allCompensated = blocker.get() && allCompensated;
+        }
+        check(allCompensated, "阻塞区报告已补偿");
+        check(waitUntil([&pool]() { return pool.getTemporaryWorkerCount() == 0; }, std::chrono::seconds(5)),
+              "阻塞结束后补偿线程退休");
+        check(pool.getThreadCount() == 2, "常规工作线程不变");
+        check(pool.exportOpenMetrics().find("threadpool_compensating_workers_total 2") != std::string::npos,
+              "导出补偿线程计数");
+    }
+
+    printSeparator("补偿上限");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.setMaxThreads(3);
+        std::atomic<bool> queued{false};
+        std::atomic<int> entered{0};
+        std::promise<void> gate;
+        auto blockers = submitBlockers(pool, 2, queued, entered, gate.get_future().share());
+        for (int i = 0; i < 2; ++i) {
+            pool.post(TaskPriority::MEDIUM, [&entered]() {
+                while (entered.load() < 2) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+        queued = true;
+
+        check(waitUntil([&pool]() { return pool.getTaskCount() == 0; }, std::chrono::seconds(5)),
+              "补偿线程执行排队任务");
+        check(pool.getTemporaryWorkerCount() == 1, "线程总数不超过maxThreads");
+        gate.set_value();
+        int compensated = 0;
+        for (auto& blocker : blockers) {
+            compensated += blocker.get() ? 1 : 0;
+        }
+        check(compensated == 1, "只有一个阻塞区得到补偿");
+    }
+
+    printSeparator("无需补偿");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        {
+            auto scope = pool.blockingScope();
+            check(!scope.isCompensated(), "外部线程的阻塞区不补偿");
+        }
+        bool compensated = pool.enqueue([&pool]() { return pool.blockingScope().isCompensated(); }).get();
+        check(!compensated, "队列为空时不补偿");
+        check(pool.getTemporaryWorkerCount() == 0, "没有临时线程");
+        check(pool.exportMetricsJson().find("\"blocked\":0") != std::string::npos, "阻塞计数归零");
+    }
+
+    printSeparator(failures == 0 ? "阻塞区测试通过" : "阻塞区测试失败");
+    return failures == 0 ? 0 : 1;
+}
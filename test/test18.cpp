@@ -0,0 +1,79 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator("预留通道");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.setReservedWorkers(1);
+        check(pool.getReservedWorkerCount() == 1 && pool.getThreadCount() == 1, "预留线程不计入共享线程数");
+
+        // 唯一的共享线程被长时间运行的低优先级任务占住
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        auto longLow = pool.enqueueWithPriority(TaskPriority::LOW, std::chrono::milliseconds(0),
+                                                [opened]() { opened.wait(); });
+        while (pool.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+
+        auto critical = pool.enqueueWithPriority(TaskPriority::CRITICAL, std::chrono::milliseconds(0), []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return std::this_thread::get_id();
+        });
+        check(critical.wait_for(std::chrono::seconds(5)) == std::future_status::ready,
+              "共享线程忙时CRITICAL任务由预留线程执行");
+
+        auto medium = pool.enqueueWithPriority(TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {});
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        check(pool.getTaskCount() == 1, "预留线程不执行低于预留优先级的任务");
+
+        WindowedRates rates = pool.getWindowedRates(std::chrono::seconds(10));
+        check(rates.reservedUtilization > 0.0 && rates.reservedUtilization <= 1.0, "预留通道利用率");
+        check(contains(pool.exportMetricsJson(), "\"reserved\":1,\"reserved_tasks\":1"), "JSON导出预留通道");
+        check(contains(pool.exportOpenMetrics(), "threadpool_reserved_tasks_total 1"), "OpenMetrics导出预留通道");
+        check(contains(pool.getMetricsReport(), "预留通道: 1 个线程"), "性能报告");
+
+        // 降低预留优先级后已排队的MEDIUM任务可以由预留线程执行
+        pool.setReservedWorkers(1, TaskPriority::MEDIUM);
+        check(medium.wait_for(std::chrono::seconds(5)) == std::future_status::ready, "降低预留优先级");
+
+        gate.set_value();
+        longLow.get();
+        pool.setReservedWorkers(0);
+        check(pool.getReservedWorkerCount() == 0, "撤销预留通道");
+        check(pool.enqueueWithPriority(TaskPriority::CRITICAL, std::chrono::milliseconds(0),
+                                       []() { return 3; }).get() == 3, "撤销后高优先级任务由共享线程执行");
+    }
+
+    printSeparator("构造时指定预留通道");
+    {
+        WorkerStartOptions options;
+        options.reservedWorkers = 2;
+        options.reservedMinPriority = TaskPriority::HIGH;
+        ThreadPool pool(1, options, LogLevel::ERROR);
+        check(pool.getReservedWorkerCount() == 2, "预留线程数");
+
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+        while (pool.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+        auto high = pool.enqueueWithPriority(TaskPriority::HIGH, std::chrono::milliseconds(0), []() { return 1; });
+        auto critical = pool.enqueueWithPriority(TaskPriority::CRITICAL, std::chrono::milliseconds(0),
+                                                 []() { return 2; });
+        check(high.get() + critical.get() == 3, "HIGH和CRITICAL任务都进入预留通道");
+        gate.set_value();
+        pool.waitForTasks();
+    }
+
+    printSeparator(failures == 0 ? "预留通道测试通过" : "预留通道测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int currentPolicy() {
+    int policy = 0;
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    return policy;
+}
+
+int main() {
+    printSeparator("按通道设置nice值");
+    {
+        // 提高nice值不需要权限
+        WorkerStartOptions options;
+        options.reservedWorkers = 1;
+        options.scheduling.shared.niceValue = 10;
+        options.scheduling.reserved.niceValue = 2;
+        ThreadPool pool(1, options, LogLevel::ERROR);
+
+        check(pool.enqueue([]() { return getCurrentThreadNice(); }).get() == 10, "共享线程使用共享层级的nice值");
+
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.post(TaskPriority::LOW, [opened]() { opened.wait(); });
+        while (pool.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+        int reservedNice = pool.enqueueWithPriority(TaskPriority::CRITICAL, std::chrono::milliseconds(0),
+                                                    []() { return getCurrentThreadNice(); }).get();
+        check(reservedNice == 2, "预留线程使用预留层级的nice值");
+        gate.set_value();
+
+        check(getCurrentThreadNice() == 0, "不影响调用线程");
+    }
+
+    printSeparator("按任务优先级调整nice值");
+    {
+        WorkerStartOptions options;
+        options.scheduling.perTaskNice = true;
+        options.scheduling.taskNice[static_cast<size_t>(TaskPriority::LOW)] = 12;
+        options.scheduling.taskNice[static_cast<size_t>(TaskPriority::MEDIUM)] = 8;
+        options.scheduling.taskNice[static_cast<size_t>(TaskPriority::HIGH)] = 4;
+        ThreadPool pool(1, options, LogLevel::NONE);
+        auto niceAt = [&pool](TaskPriority priority) {
+            return pool.enqueueWithPriority(priority, std::chrono::milliseconds(0),
+                                            []() { return getCurrentThreadNice(); }).get();
+        };
+
+        // 调回更小的nice值需要CAP_SYS_NICE或RLIMIT_NICE 线程池构造时检查 做不到时关闭按任务调整
+        if (canLowerNiceTo(4)) {
+            check(niceAt(TaskPriority::HIGH) == 4, "HIGH任务");
+            check(niceAt(TaskPriority::MEDIUM) == 8, "MEDIUM任务");
+            check(niceAt(TaskPriority::LOW) == 12, "LOW任务");
+            check(niceAt(TaskPriority::HIGH) == 4, "LOW任务之后调回较小的nice值");
+            check(niceAt(TaskPriority::MEDIUM) == 8, "再次调整");
+        } else {
+            check(niceAt(TaskPriority::LOW) == 0 && niceAt(TaskPriority::HIGH) == 0, "无权限时不按任务调整");
+        }
+        check(contains(pool.exportMetricsJson(), "\"scheduling_errors\":0"), "没有调整失败");
+    }
+
+    printSeparator("实时调度策略");
+    {
+        WorkerStartOptions options;
+        options.scheduling.shared.policy = SCHED_RR;
+        options.scheduling.shared.realtimePriority = 1;
+        ThreadPool pool(1, options, LogLevel::NONE);
+        int policy = pool.enqueue([]() { return currentPolicy(); }).get();
+        bool applied = policy == SCHED_RR;
+        bool refused = policy == SCHED_OTHER &&
+                       contains(pool.exportOpenMetrics(), "threadpool_scheduling_errors_total 1");
+        check(applied || refused, applied ? "工作线程使用SCHED_RR" : "无权限时保持SCHED_OTHER并计数");
+
+        options.scheduling.shared = SchedulingTier();
+        ThreadPool plain(1, options, LogLevel::NONE);
+        check(plain.enqueue([]() { return currentPolicy(); }).get() == SCHED_OTHER, "默认策略不做设置");
+    }
+
+    printSeparator(failures == 0 ? "调度层级测试通过" : "调度层级测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+RateLimitStats statsOf(const ThreadPool& pool, const std::string& category) {
+    for (const RateLimitStats& stats : pool.getRateLimitStats()) {
+        if (stats.category == category) {
+            return stats;
+        }
+    }
+    return RateLimitStats();
+}
+
+int main() {
+    printSeparator("令牌桶限流");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.setRateLimit("api", 20.0, 5.0);
+
+        // 突发的5个任务立即放行 之后的15个按每秒20个放行 约需750毫秒
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<int>> results;
+        for (int i = 0; i < 20; ++i) {
+            results.push_back(pool.enqueueRateLimited("api", TaskPriority::MEDIUM, [i]() { return i; }));
+        }
+        RateLimitStats queued = statsOf(pool, "api");
+        check(queued.throttled == 15 && queued.queued >= 14, "超出突发的任务进入侧队列");
+
+        results[4].wait();
+        check(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300), "突发任务立即执行");
+
+        int sum = 0;
+        for (auto& result : results) {
+            sum += result.get();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        check(sum == 190, "所有任务都被放行并执行");
+        check(elapsed >= std::chrono::milliseconds(650), "按速率放行 (" +
+              std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + "ms)");
+
+        RateLimitStats done = statsOf(pool, "api");
+        check(done.admitted == 20 && done.queued == 0 && done.peakQueued == 15, "放行计数和侧队列峰值");
+
+        // 不限流的任务不受影响
+        check(pool.enqueue([]() { return 1; }).wait_for(std::chrono::milliseconds(200)) ==
+              std::future_status::ready, "其他任务不受限流影响");
+    }
+
+    printSeparator("等待、删除和暂停");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.setRateLimit("batch", 50.0, 1.0);
+        std::atomic<int> done{0};
+        for (int i = 0; i < 6; ++i) {
+            pool.enqueueRateLimited("batch", TaskPriority::LOW, [&done]() { ++done; });
+        }
+        pool.waitForTasks();
+        check(done == 6, "waitForTasks等待侧队列中的任务");
+
+        // 速率为0时暂停放行 删除类别后剩余任务立即放行
+        pool.setRateLimit("batch", 0.0, 1.0);
+        pool.enqueueRateLimited("batch", TaskPriority::LOW, [&done]() { ++done; });
+        auto held = pool.enqueueRateLimited("batch", TaskPriority::LOW, [&done]() { ++done; });
+        check(held.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout, "速率为0时暂停放行");
+        check(pool.removeRateLimit("batch"), "删除限流类别");
+        check(held.wait_for(std::chrono::seconds(5)) == std::future_status::ready, "删除后剩余任务立即放行");
+        check(!pool.removeRateLimit("batch"), "重复删除返回false");
+
+        bool threw = false;
+        try {
+            pool.enqueueRateLimited("batch", TaskPriority::LOW, []() {});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "未知类别抛出异常");
+
+        // clearTasks丢弃侧队列中的任务
+        pool.setRateLimit("slow", 0.0, 1.0);
+        pool.enqueueRateLimited("slow", TaskPriority::LOW, []() {});
+        auto dropped = pool.enqueueRateLimited("slow", TaskPriority::LOW, []() {});
+        pool.clearTasks();
+        check(statsOf(pool, "slow").queued == 0, "clearTasks清空侧队列");
+        pool.waitForTasks();
+        bool broken = false;
+        try {
+            dropped.get();
+        } catch (const std::future_error&) {
+            broken = true;
+        }
+        check(broken, "被丢弃任务的future收到broken_promise");
+    }
+
+    printSeparator("限流指标导出");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.setRateLimit("mail", 1000.0, 1.0);
+        pool.enqueueRateLimited("mail", TaskPriority::MEDIUM, []() {});
+        pool.enqueueRateLimited("mail", TaskPriority::MEDIUM, []() {});
+        pool.waitForTasks();
+
+        std::string text = pool.exportOpenMetrics();
+        check(contains(text, "threadpool_rate_limit_queued{category=\"mail\"} 0"), "OpenMetrics侧队列深度");
+        check(contains(text, "threadpool_rate_limit_admitted_total{category=\"mail\"} 2"), "OpenMetrics放行计数");
+        check(contains(text, "threadpool_rate_limit_throttled_total{category=\"mail\"} 1"), "OpenMetrics限流计数");
+        check(contains(pool.exportMetricsJson(), "\"category\":\"mail\",\"tasks_per_second\":1000,\"burst\":1"),
+              "JSON导出限流类别");
+        check(contains(pool.getMetricsReport(), "限流 mail"), "性能报告");
+    }
+
+    printSeparator(failures == 0 ? "限流测试通过" : "限流测试失败");
+    return failures == 0 ? 0 : 1;
+}
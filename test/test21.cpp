@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator("同ID提交合并");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        std::atomic<int> executions{0};
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        auto fill = [&executions, opened]() {
+            opened.wait();
+            ++executions;
+            return std::string("value");
+        };
+
+        std::vector<std::shared_future<std::string>> results(8);
+        results[0] = pool.enqueueShared("cache:key", "缓存填充", TaskPriority::MEDIUM, fill);
+        std::vector<std::thread> callers;
+        for (size_t i = 1; i < results.size(); ++i) {
+            callers.emplace_back([&pool, &results, &fill, i]() {
+                results[i] = pool.enqueueShared("cache:key", "缓存填充", TaskPriority::MEDIUM, fill);
+            });
+        }
+        for (std::thread& caller : callers) {
+            caller.join();
+        }
+        gate.set_value();
+
+        bool allSame = true;
+        for (auto& result : results) {
+            allSame = allSame && result.get() == "value";
+        }
+        check(allSame, "所有提交者得到同一个结果");
+        check(executions == 1, "8个并发提交只执行一次");
+
+        pool.waitForTasks();
+        check(pool.enqueueShared("cache:key", "缓存填充", TaskPriority::MEDIUM, fill).get() == "value" &&
+              executions == 2, "任务结束后再提交会重新执行");
+
+        std::string json = pool.exportMetricsJson();
+        check(contains(json, "\"coalesced\":7"), "JSON导出合并次数");
+        check(contains(pool.exportOpenMetrics(), "threadpool_tasks_coalesced_total 7"), "OpenMetrics导出合并次数");
+        check(contains(pool.getMetricsReport(), "合并到同ID任务的提交数: 7"), "性能报告");
+    }
+
+    printSeparator("异常、取消和冲突");
+    {
+        ThreadPool pool(1, LogLevel::NONE);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.post(TaskPriority::HIGH, [opened]() { opened.wait(); });
+
+        // 异常同样由所有提交者共享
+        auto failing = []() -> int { throw std::runtime_error("load failed"); };
+        auto first = pool.enqueueShared("bad", "", TaskPriority::MEDIUM, failing);
+        auto second = pool.enqueueShared("bad", "", TaskPriority::MEDIUM, failing);
+
+        // 已取消的任务被新提交替换
+        auto canceled = pool.enqueueShared("c", "", TaskPriority::MEDIUM, []() { return 1; });
+        check(pool.cancelTask("c"), "取消排队中的任务");
+        auto replaced = pool.enqueueShared("c", "", TaskPriority::MEDIUM, []() { return 2; });
+
+        // 普通提交的ID或返回类型不同时仍然报冲突
+        pool.enqueueWithInfo("plain", "", TaskPriority::MEDIUM, std::chrono::milliseconds(0), []() {});
+        bool plainConflict = false;
+        try {
+            pool.enqueueShared("plain", "", TaskPriority::MEDIUM, []() {});
+        } catch (const std::runtime_error& e) {
+            plainConflict = contains(e.what(), "already exists");
+        }
+        check(plainConflict, "与普通提交的ID冲突时抛出异常");
+
+        bool typeConflict = false;
+        try {
+            pool.enqueueShared("c", "", TaskPriority::MEDIUM, []() { return std::string(); });
+        } catch (const std::runtime_error&) {
+            typeConflict = true;
+        }
+        check(typeConflict, "返回类型不同时抛出异常");
+
+        bool emptyId = false;
+        try {
+            pool.enqueueShared("", "", TaskPriority::MEDIUM, []() {});
+        } catch (const std::invalid_argument&) {
+            emptyId = true;
+        }
+        check(emptyId, "空ID抛出std::invalid_argument");
+
+        gate.set_value();
+        int thrown = 0;
+        for (auto* result : {&first, &second}) {
+            try {
+                result->get();
+            } catch (const std::runtime_error&) {
+                ++thrown;
+            }
+        }
+        check(thrown == 2, "异常传给所有提交者");
+        check(replaced.get() == 2, "已取消的任务被新任务替换");
+        pool.waitForTasks();
+        bool broken = false;
+        try {
+            canceled.get();
+        } catch (const std::future_error&) {
+            broken = true;
+        }
+        check(broken, "被取消的任务不执行 其future收到broken_promise");
+    }
+
+    printSeparator(failures == 0 ? "单飞提交测试通过" : "单飞提交测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 记录任务的执行顺序
+struct ExecutionLog {
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    void add(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(name);
+    }
+};
+
+// 用一个任务占住唯一的工作线程 期间提交的任务全部排队
+std::promise<void> blockWorker(ThreadPool& pool) {
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+    while (pool.getActiveThreadCount() == 0) {
+        std::this_thread::yield();
+    }
+    return gate;
+}
+
+int main() {
+    printSeparator("积压的租户不会饿死其他租户");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        ExecutionLog log;
+        std::promise<void> gate = blockWorker(pool);
+        for (int i = 0; i < 100; ++i) {
+            pool.enqueueForTenant("bulk", TaskPriority::MEDIUM, [&log]() { log.add("bulk"); });
+        }
+        for (int i = 0; i < 5; ++i) {
+            pool.enqueueForTenant("small", TaskPriority::MEDIUM, [&log]() { log.add("small"); });
+        }
+        gate.set_value();
+        pool.waitForTasks();
+
+        auto lastSmall = std::find(log.order.rbegin(), log.order.rend(), "small");
+        size_t position = log.order.size() - static_cast<size_t>(lastSmall - log.order.rbegin());
+        check(position <= 10, "后提交的小租户在前10个任务内完成 (第" + std::to_string(position) + "个)");
+
+        // 优先级仍然优先于租户公平
+        std::promise<void> again = blockWorker(pool);
+        log.order.clear();
+        pool.enqueueForTenant("small", TaskPriority::LOW, [&log]() { log.add("low"); });
+        pool.enqueueForTenant("bulk", TaskPriority::HIGH, [&log]() { log.add("high"); });
+        again.set_value();
+        pool.waitForTasks();
+        check(log.order.size() == 2 && log.order[0] == "high", "高优先级任务先执行");
+    }
+
+    printSeparator("按权重分配");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.setTenantWeight("gold", 3.0);
+        ExecutionLog log;
+        std::promise<void> gate = blockWorker(pool);
+        for (int i = 0; i < 40; ++i) {
+            pool.enqueueForTenant("bronze", TaskPriority::MEDIUM, [&log]() { log.add("bronze"); });
+            pool.enqueueForTenant("gold", TaskPriority::MEDIUM, [&log]() { log.add("gold"); });
+        }
+        gate.set_value();
+        pool.waitForTasks();
+
+        long gold = std::count(log.order.begin(), log.order.begin() + 20, "gold");
+        check(gold >= 14 && gold <= 16, "权重3:1 前20个任务中gold占 " + std::to_string(gold));
+
+        bool threw = false;
+        try {
+            pool.setTenantWeight("gold", 0.0);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "权重必须大于0");
+    }
+
+    printSeparator("没有租户时保持FIFO");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        ExecutionLog log;
+        std::promise<void> gate = blockWorker(pool);
+        for (int i = 0; i < 20; ++i) {
+            pool.enqueue([&log, i]() { log.add(std::to_string(i)); });
+        }
+        gate.set_value();
+        pool.waitForTasks();
+        bool fifo = log.order.size() == 20;
+        for (size_t i = 0; fifo && i < log.order.size(); ++i) {
+            fifo = log.order[i] == std::to_string(i);
+        }
+        check(fifo, "按提交顺序执行");
+    }
+
+    printSeparator("租户指标");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.setTenantWeight("acme", 2.0);
+        for (int i = 0; i < 10; ++i) {
+            pool.enqueueForTenant("acme", TaskPriority::MEDIUM, []() {});
+        }
+        pool.enqueueForTenant("beta", TaskPriority::MEDIUM, []() {}).get();
+        pool.waitForTasks();
+
+        std::vector<TenantStats> stats = pool.getTenantStats();
+        check(stats.size() == 2 && stats[0].tenant == "acme" && stats[1].tenant == "beta", "按租户名排序");
+        check(stats[0].submitted == 10 && stats[0].completed == 10 && stats[0].queued == 0 &&
+              stats[0].weight == 2.0, "提交数、完成数和权重");
+        check(stats[0].wait.count() == 10 && stats[0].endToEnd.count() == 10, "每个租户的延迟直方图");
+
+        std::string text = pool.exportOpenMetrics();
+        check(contains(text, "threadpool_tenant_completed_total{tenant=\"acme\"} 10"), "OpenMetrics完成数");
+        check(contains(text, "threadpool_tenant_wait_seconds_count{tenant=\"beta\"} 1"), "OpenMetrics延迟直方图");
+        check(contains(pool.exportMetricsJson(), "{\"tenant\":\"acme\",\"weight\":2,\"queued\":0,\"submitted\":10"),
+              "JSON导出租户");
+        check(contains(pool.getMetricsReport(), "租户 beta"), "性能报告");
+    }
+
+    printSeparator("租户数上限和删除租户");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.setMaxTenants(3);
+        for (int i = 0; i < 10; ++i) {
+            pool.enqueueForTenant("user-" + std::to_string(i), TaskPriority::MEDIUM, []() {});
+        }
+        pool.waitForTasks();
+        std::vector<TenantStats> stats = pool.getTenantStats();
+        check(stats.size() == 4, "只创建3个租户和共用的溢出租户: " + std::to_string(stats.size()));
+        bool overflow = false;
+        for (const TenantStats& tenant : stats) {
+            overflow = overflow || (tenant.tenant == TenantScheduler::kOverflowTenant && tenant.completed == 7);
+        }
+        check(overflow, "其余租户的任务计入溢出租户");
+        check(!pool.setTenantWeight("user-9", 2.0), "不能为溢出的租户设置权重");
+
+        std::promise<void> gate = blockWorker(pool);
+        pool.enqueueForTenant("user-0", TaskPriority::MEDIUM, []() {});
+        check(!pool.removeTenant("user-0"), "有任务排队时不能删除");
+        check(!pool.removeTenant("missing"), "不存在的租户");
+        gate.set_value();
+        pool.waitForTasks();
+        check(pool.removeTenant("user-0") && pool.getTenantStats().size() == 3, "删除空闲租户");
+        pool.enqueueForTenant("user-new", TaskPriority::MEDIUM, []() {}).get();
+        check(pool.getTenantStats().size() == 4, "删除后腾出的名额给新租户");
+
+        // enqueueForTenant在锁外查找租户 入队前被删除的租户按名字重新登记 任务不会记到孤立的状态上
+        TenantScheduler scheduler;
+        std::shared_ptr<TenantState> stale = scheduler.get("gone");
+        scheduler.remove("gone");
+        std::shared_ptr<TenantState> fresh = scheduler.revalidate(stale);
+        check(fresh != stale && scheduler.snapshot().size() == 1 && scheduler.revalidate(fresh) == fresh,
+              "入队前重新确认租户仍在注册表中");
+    }
+
+    printSeparator(failures == 0 ? "租户公平排队测试通过" : "租户公平排队测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+std::string segmentName(const std::string& suffix) {
+    return "/threadpool-test23-" + std::to_string(getpid()) + "-" + suffix;
+}
+
+std::string upper(const std::string& text) {
+    std::string result = text;
+    for (char& c : result) {
+        if (c >= 'a' && c <= 'z') {
+            c = static_cast<char>(c - 'a' + 'A');
+        }
+    }
+    return result;
+}
+
+bool throwsRuntimeError(std::future<std::string>& result, const std::string& message) {
+    try {
+        result.get();
+    } catch (const std::runtime_error& e) {
+        return contains(e.what(), message);
+    }
+    return false;
+}
+
+size_t jsonCount(const ThreadPool& pool, const std::string& field) {
+    const std::string key = "\"" + field + "\":";
+    std::string json = pool.exportMetricsJson();
+    size_t pos = json.find(key);
+    return pos == std::string::npos ? 0 : std::stoul(json.substr(pos + key.size()));
+}
+
+size_t sharedQueueTasks(const ThreadPool& pool) {
+    return jsonCount(pool, "shared_queue");
+}
+
+bool throwsDropped(std::future<std::string>& result) {
+    if (result.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+        return false;
+    }
+    return throwsRuntimeError(result, "dropped before execution");
+}
+
+// 在段的映射中找到marker所在的槽位 把槽位头中的名字长度改成越界值(模拟损坏或恶意的对端)
+bool corruptSlot(const std::string& name, const std::string& marker) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        return false;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    char* begin = static_cast<char*>(base);
+    char* found = static_cast<char*>(memmem(begin, bytes, marker.data(), marker.size()));
+    bool ok = found != nullptr;
+    if (ok) {
+        // 槽位头32字节: sequence(8) requestId(8) tag(4) nameBytes(4) dataBytes(4) reserved(4)
+        uint32_t hugeLength = 0xfffffff0u;
+        std::memcpy(found - 32 + 20, &hugeLength, sizeof(hugeLength));
+    }
+    munmap(base, bytes);
+    return ok;
+}
+
+// 子进程: 挂在段上执行square 收到quit后退出
+int runWorkerProcess(const std::string& name) {
+    ThreadPool pool(2, LogLevel::ERROR);
+    std::promise<void> quit;
+    std::future<void> quitRequested = quit.get_future();
+    pool.registerSharedHandler("square", [](const std::string& payload) {
+        long value = std::stol(payload);
+        return std::to_string(value * value);
+    });
+    pool.registerSharedHandler("quit", [&quit](const std::string&) {
+        quit.set_value();
+        return std::string("bye");
+    });
+    if (!pool.attachSharedQueue(name)) {
+        return 1;
+    }
+    if (quitRequested.wait_for(std::chrono::seconds(30)) != std::future_status::ready) {
+        return 2;
+    }
+    pool.waitForTasks();
+    return 0;
+}
+
+int main() {
+    printSeparator("进程内往返");
+    {
+        std::string name = segmentName("roundtrip");
+        auto owner = SharedTaskQueue::create(name);
+        check(owner != nullptr, "创建共享内存段");
+        SharedTaskClient client(SharedTaskQueue::open(name));
+
+        ThreadPool pool(2, LogLevel::ERROR);
+        pool.registerSharedHandler("upper", upper);
+        pool.registerSharedHandler("fail", [](const std::string&) -> std::string {
+            throw std::runtime_error("handler failed");
+        });
+        check(pool.attachSharedQueue(name), "线程池挂载段");
+
+        std::vector<std::future<std::string>> results;
+        for (int i = 0; i < 50; ++i) {
+            results.push_back(client.submit("upper", "task-" + std::to_string(i)));
+        }
+        bool allOk = true;
+        for (int i = 0; i < 50; ++i) {
+            allOk = allOk && results[i].get() == "TASK-" + std::to_string(i);
+        }
+        check(allOk, "50个请求的结果按请求ID对应");
+
+        std::future<std::string> unknown = client.submit("missing", "");
+        check(throwsRuntimeError(unknown, "Unknown shared task handler: missing"), "未注册的处理函数");
+        std::future<std::string> failed = client.submit("fail", "", TaskPriority::HIGH);
+        check(throwsRuntimeError(failed, "handler failed"), "处理函数的异常传回提交进程");
+        check(client.pendingCount() == 0, "没有未完成的请求");
+
+        pool.waitForTasks();
+        check(contains(pool.exportOpenMetrics(), "threadpool_shared_queue_tasks_total 52"), "OpenMetrics导出取得的共享任务数");
+        check(contains(pool.exportMetricsJson(), "\"shared_queue\":52"), "JSON导出");
+        check(!pool.attachSharedQueue(segmentName("absent")), "不存在的段挂载失败");
+    }
+
+    printSeparator("多个线程池分担负载");
+    {
+        std::string name = segmentName("share");
+        auto owner = SharedTaskQueue::create(name);
+        SharedTaskClient client(SharedTaskQueue::open(name));
+
+        ThreadPool first(1, LogLevel::ERROR);
+        ThreadPool second(1, LogLevel::ERROR);
+        auto slow = [](const std::string& payload) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return payload;
+        };
+        first.registerSharedHandler("slow", slow);
+        second.registerSharedHandler("slow", slow);
+        first.attachSharedQueue(name, 1);
+        second.attachSharedQueue(name, 1);
+
+        std::vector<std::future<std::string>> results;
+        for (int i = 0; i < 40; ++i) {
+            results.push_back(client.submit("slow", std::to_string(i)));
+        }
+        for (auto& result : results) {
+            result.get();
+        }
+        first.waitForTasks();
+        second.waitForTasks();
+        size_t a = sharedQueueTasks(first);
+        size_t b = sharedQueueTasks(second);
+        check(a + b == 40, "每个请求只执行一次");
+        check(a >= 5 && b >= 5, "两个线程池都取得任务 (" + std::to_string(a) + "/" + std::to_string(b) + ")");
+    }
+
+    printSeparator("容量限制");
+    {
+        std::string name = segmentName("full");
+        SharedQueueOptions options;
+        options.slots = 4;
+        options.slotBytes = 128;
+        auto queue = SharedTaskQueue::create(name, options);
+        check(queue->slotCount() == 4 && queue->maxMessageBytes() == 96, "槽位数和消息上限");
+        bool pushed = true;
+        for (int i = 0; i < 4; ++i) {
+            pushed = pushed && queue->pushRequest(queue->nextRequestId(), TaskPriority::LOW, "h", "x");
+        }
+        check(pushed && !queue->pushRequest(queue->nextRequestId(), TaskPriority::LOW, "h", "x"),
+              "环满时pushRequest返回false");
+
+        SharedTaskRequest request;
+        check(queue->popRequest(request) && request.requestId == 1 && request.handler == "h" &&
+              request.payload == "x" && request.priority == TaskPriority::LOW, "按FIFO取出请求");
+
+        bool threw = false;
+        try {
+            queue->pushRequest(queue->nextRequestId(), TaskPriority::LOW, "h", std::string(96, 'x'));
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "超过槽位大小的消息抛出invalid_argument");
+    }
+
+    printSeparator("没有执行的共享任务回报失败");
+    {
+        std::string name = segmentName("dropped");
+        auto owner = SharedTaskQueue::create(name);
+        SharedTaskClient client(SharedTaskQueue::open(name));
+
+        auto pool = std::make_unique<ThreadPool>(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool->registerSharedHandler("block", [opened](const std::string&) {
+            opened.wait();
+            return std::string("done");
+        });
+        pool->registerSharedHandler("upper", upper);
+        pool->attachSharedQueue(name, 8);
+
+        // 唯一的工作线程被占住 之后取得的请求在本地队列中排队
+        std::future<std::string> blocker = client.submit("block", "");
+        std::vector<std::future<std::string>> queued;
+        for (int i = 0; i < 3; ++i) {
+            queued.push_back(client.submit("upper", "x"));
+        }
+        check(waitUntil([&]() { return sharedQueueTasks(*pool) == 4; }, std::chrono::seconds(5)),
+              "4个请求都已提交到线程池");
+        pool->clearTasks();
+        bool allDropped = true;
+        for (auto& result : queued) {
+            allDropped = throwsDropped(result) && allDropped;
+        }
+        check(allDropped, "clearTasks丢弃的请求收到失败结果");
+
+        // 析构时排队的请求同样回报失败 而不是让前端永远等待
+        queued.clear();
+        for (int i = 0; i < 2; ++i) {
+            queued.push_back(client.submit("upper", "y"));
+        }
+        check(waitUntil([&]() { return sharedQueueTasks(*pool) == 6; }, std::chrono::seconds(5)),
+              "新的请求已提交到线程池");
+        std::thread releaser([&gate]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            gate.set_value();
+        });
+        pool.reset();
+        releaser.join();
+        allDropped = blocker.get() == "done";
+        for (auto& result : queued) {
+            allDropped = throwsDropped(result) && allDropped;
+        }
+        check(allDropped, "线程池析构时未执行的请求收到失败结果");
+        check(client.pendingCount() == 0, "没有永远等待的请求");
+    }
+
+    printSeparator("完成环一直满时丢弃结果");
+    {
+        std::string name = segmentName("stalled");
+        SharedQueueOptions options;
+        options.slots = 2;
+        // 前端只提交不读取完成环
+        auto queue = SharedTaskQueue::create(name, options);
+        ThreadPool pool(1, LogLevel::NONE);
+        pool.registerSharedHandler("echo", [](const std::string& payload) { return payload; });
+        pool.attachSharedQueue(name, 1, std::chrono::milliseconds(20));
+        for (int i = 0; i < 4; ++i) {
+            uint64_t id = queue->nextRequestId();
+            while (!queue->pushRequest(id, TaskPriority::MEDIUM, "echo", "x")) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        check(waitUntil([&]() { return jsonCount(pool, "shared_queue_dropped") == 2; }, std::chrono::seconds(5)),
+              "完成环满后工作线程不再阻塞 丢弃2个结果");
+        pool.waitForTasks();
+        check(contains(pool.exportOpenMetrics(), "threadpool_shared_queue_dropped_total 2"), "OpenMetrics导出丢弃数");
+    }
+
+    printSeparator("槽位头中的长度越界");
+    {
+        std::string name = segmentName("corrupt");
+        auto queue = SharedTaskQueue::create(name);
+        queue->pushRequest(queue->nextRequestId(), TaskPriority::MEDIUM, "h", "CORRUPT-MARKER");
+        check(corruptSlot(name, "hCORRUPT-MARKER"), "改写槽位头");
+        SharedTaskRequest request;
+        check(queue->popRequest(request) && !request.valid && request.requestId == 1 &&
+              request.handler.empty() && request.payload.empty(), "越界的消息被丢弃 不越界读取");
+
+        queue->pushCompletion(7, true, "CORRUPT-RESULT");
+        corruptSlot(name, "CORRUPT-RESULT");
+        SharedTaskCompletion completion;
+        check(queue->popCompletion(completion) && !completion.valid && !completion.ok &&
+              completion.requestId == 7, "越界的完成消息作为失败结果");
+
+        // 挂载的线程池对越界的请求直接回报失败
+        SharedTaskClient client(SharedTaskQueue::open(name));
+        ThreadPool pool(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.registerSharedHandler("wait", [opened](const std::string&) {
+            opened.wait();
+            return std::string();
+        });
+        // 先占住拉取名额 再改写排在后面的请求
+        pool.attachSharedQueue(name, 1);
+        std::future<std::string> first = client.submit("wait", "");
+        check(waitUntil([&]() { return sharedQueueTasks(pool) == 1; }, std::chrono::seconds(5)), "第一个请求开始执行");
+        std::future<std::string> corrupt = client.submit("h", "CORRUPT-QUEUED");
+        corruptSlot(name, "hCORRUPT-QUEUED");
+        gate.set_value();
+        first.get();
+        check(throwsRuntimeError(corrupt, "Corrupt shared task request"), "越界的请求回报失败");
+    }
+
+    printSeparator("跨进程");
+    {
+        std::string name = segmentName("fork");
+        auto owner = SharedTaskQueue::create(name);
+        // 在启动任何线程之前fork
+        pid_t child = fork();
+        if (child == 0) {
+            _exit(runWorkerProcess(name));
+        }
+        check(child > 0, "启动工作进程");
+
+        SharedTaskClient client(SharedTaskQueue::open(name));
+        std::vector<std::future<std::string>> results;
+        for (int i = 0; i < 100; ++i) {
+            results.push_back(client.submit("square", std::to_string(i)));
+        }
+        bool allOk = true;
+        for (int i = 0; i < 100; ++i) {
+            allOk = allOk && results[i].get() == std::to_string(i * i);
+        }
+        check(allOk, "另一个进程的线程池计算出100个结果");
+        check(client.submit("quit", "").get() == "bye", "通知工作进程退出");
+
+        int status = 0;
+        waitpid(child, &status, 0);
+        check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "工作进程正常退出");
+    }
+
+    printSeparator(failures == 0 ? "共享内存队列测试通过" : "共享内存队列测试失败");
+    return failures == 0 ? 0 : 1;
+}
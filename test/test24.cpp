@@ -0,0 +1,206 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 记录任务的执行顺序
+struct ExecutionLog {
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    void add(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(name);
+    }
+};
+
+// 用一个任务占住唯一的工作线程 期间提交的任务全部排队
+std::promise<void> blockWorker(ThreadPool& pool) {
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+    while (pool.getActiveThreadCount() == 0) {
+        std::this_thread::yield();
+    }
+    return gate;
+}
+
+uint64_t jsonValue(const std::string& json, const std::string& key) {
+    size_t pos = json.find("\"" + key + "\":");
+    return pos == std::string::npos ? 0 : std::stoull(json.substr(pos + key.size() + 3));
+}
+
+SpillOptions smallSpill(size_t maxQueuedTasks) {
+    SpillOptions options;
+    options.maxQueuedTasks = maxQueuedTasks;
+    options.segmentBytes = 4096;
+    return options;
+}
+
+int main() {
+    printSeparator("超过阈值的任务写入段文件并按FIFO读回");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        ExecutionLog log;
+        pool.registerSharedHandler("record", [&log](const std::string& payload) {
+            log.add(payload.substr(0, payload.find(':')));
+            return std::string();
+        });
+        check(pool.enableSpill(smallSpill(8)), "启用溢出");
+
+        std::promise<void> gate = blockWorker(pool);
+        for (int i = 0; i < 200; ++i) {
+            // 每条记录约130字节 一个4KB的段放不下全部任务
+            pool.enqueueSpillable("record", std::to_string(i) + ":" + std::string(100, 'x'));
+        }
+        check(pool.getTaskCount() == 8, "内存队列停在阈值");
+        check(pool.getSpilledTaskCount() == 192, "其余192个任务在段文件中");
+
+        gate.set_value();
+        pool.waitForTasks();
+        bool fifo = log.order.size() == 200;
+        for (size_t i = 0; fifo && i < log.order.size(); ++i) {
+            fifo = log.order[i] == std::to_string(i);
+        }
+        check(fifo, "200个任务按提交顺序执行");
+        check(pool.getSpilledTaskCount() == 0, "段文件中的任务全部读回");
+
+        std::string json = pool.exportMetricsJson();
+        uint64_t spilled = jsonValue(json, "spilled_bytes");
+        check(spilled >= 192 * 100 && spilled == jsonValue(json, "reloaded_bytes"), "写入字节数等于读回字节数");
+        check(contains(pool.exportOpenMetrics(), "threadpool_reloaded_bytes_total " + std::to_string(spilled)),
+              "OpenMetrics导出");
+        check(contains(pool.getMetricsReport(), "溢出到磁盘"), "性能报告");
+    }
+
+    printSeparator("只溢出LOW/MEDIUM任务");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        ExecutionLog log;
+        pool.registerSharedHandler("record", [&log](const std::string& payload) {
+            log.add(payload);
+            return std::string();
+        });
+        pool.enableSpill(smallSpill(4));
+
+        std::promise<void> gate = blockWorker(pool);
+        // 普通任务同样占用内存队列的额度
+        for (int i = 0; i < 4; ++i) {
+            pool.enqueueAsync(TaskPriority::LOW, [&log, i]() { log.add("L" + std::to_string(i)); });
+        }
+        for (int i = 0; i < 3; ++i) {
+            pool.enqueueSpillable("record", "M" + std::to_string(i), TaskPriority::MEDIUM);
+            pool.enqueueSpillable("record", "L" + std::to_string(4 + i), TaskPriority::LOW);
+        }
+        pool.enqueueSpillable("record", "H", TaskPriority::HIGH);
+        check(pool.getSpilledTaskCount() == 6, "高优先级任务不溢出");
+
+        gate.set_value();
+        pool.waitForTasks();
+        check(log.order.size() == 11 && log.order[0] == "H", "高优先级任务先执行");
+        std::vector<std::string> medium;
+        std::vector<std::string> low;
+        for (size_t i = 1; i < log.order.size(); ++i) {
+            (log.order[i][0] == 'M' ? medium : low).push_back(log.order[i]);
+        }
+        bool ordered = medium == std::vector<std::string>{"M0", "M1", "M2"} && low.size() == 7;
+        for (size_t i = 0; ordered && i < low.size(); ++i) {
+            ordered = low[i] == "L" + std::to_string(i);
+        }
+        std::string order;
+        for (const std::string& name : log.order) {
+            order += " " + name;
+        }
+        check(ordered, "各优先级内保持FIFO:" + order);
+    }
+
+    printSeparator("错误处理");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        check(!pool.enableSpill(SpillOptions{"/nonexistent/spill", 8, 4096}), "目录不可写时启用失败");
+
+        pool.enqueueSpillable("missing", "");
+        pool.waitForTasks();
+        check(pool.getFailedTaskCount() == 1, "处理函数不存在时任务失败");
+
+        pool.registerSharedHandler("noop", [](const std::string&) { return std::string(); });
+        pool.enableSpill(smallSpill(2));
+        std::promise<void> gate = blockWorker(pool);
+        for (int i = 0; i < 10; ++i) {
+            pool.enqueueSpillable("noop", "", TaskPriority::LOW);
+        }
+        check(pool.getSpilledTaskCount() == 8, "溢出8个任务");
+        pool.clearTasks();
+        check(pool.getSpilledTaskCount() == 0 && pool.getTaskCount() == 0, "clearTasks同时丢弃段文件中的任务");
+        gate.set_value();
+        pool.waitForTasks();
+    }
+
+    printSeparator("多个工作线程和提交线程并发");
+    {
+        // 读回在queue_mutex之外进行 每个任务仍然只执行一次 clearTasks丢弃正在读回的一批
+        ThreadPool pool(4, LogLevel::ERROR);
+        std::atomic<int> executed{0};
+        pool.registerSharedHandler("count", [&executed](const std::string&) {
+            executed.fetch_add(1);
+            return std::string();
+        });
+        pool.enableSpill(smallSpill(16));
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 3; ++p) {
+            producers.emplace_back([&pool]() {
+                for (int i = 0; i < 500; ++i) {
+                    pool.enqueueSpillable("count", std::string(64, 'x'), i % 2 ? TaskPriority::LOW : TaskPriority::MEDIUM);
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        pool.waitForTasks();
+        check(executed.load() == 1500, "1500个任务全部执行一次: " + std::to_string(executed.load()));
+        check(pool.getSpilledTaskCount() == 0 && pool.getTaskCount() == 0, "队列和段文件都已清空");
+
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        for (int i = 0; i < 4; ++i) {
+            pool.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+        }
+        waitUntil([&pool]() { return pool.getActiveThreadCount() == 4; }, std::chrono::seconds(5));
+        executed.store(0);
+        for (int i = 0; i < 200; ++i) {
+            pool.enqueueSpillable("count", "", TaskPriority::LOW);
+        }
+        pool.clearTasks();
+        gate.set_value();
+        pool.waitForTasks();
+        check(executed.load() == 0 && pool.getSpilledTaskCount() == 0, "清空后没有任务被读回执行");
+    }
+
+    printSeparator("帮助等待同样等段文件中的任务");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        std::atomic<int> executed{0};
+        pool.registerSharedHandler("count", [&executed](const std::string&) {
+            executed.fetch_add(1);
+            return std::string();
+        });
+        pool.enableSpill(smallSpill(4));
+        // 提交线程在enqueueSpillable中也会认领读回 读回期间它不计入活跃线程
+        for (int i = 0; i < 300; ++i) {
+            pool.enqueueSpillable("count", std::string(64, 'x'), TaskPriority::LOW);
+        }
+        pool.helpWaitForTasks();
+        check(executed.load() == 300 && pool.getSpilledTaskCount() == 0,
+              "helpWaitForTasks返回时段文件中的任务全部执行: " + std::to_string(executed.load()));
+    }
+
+    printSeparator(failures == 0 ? "溢出到磁盘测试通过" : "溢出到磁盘测试失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+int main() {
+    const std::string jsonPath = "/tmp/threadpool_test25_trace.json";
+    const std::string binPath = "/tmp/threadpool_test25_trace.bin";
+
+    printSeparator("启用追踪 运行任务 导出Chrome trace");
+    {
+        ThreadPool pool(2, LogLevel::ERROR);
+        check(pool.enableTracing(1024), "启用追踪");
+        for (int i = 0; i < 20; ++i) {
+            pool.post(TaskPriority::MEDIUM, []() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            });
+        }
+        pool.waitForTasks();
+        check(pool.dumpTrace(jsonPath), "导出trace文件");
+
+        std::string json = readFile(jsonPath);
+        check(contains(json, "{\"traceEvents\":[") && contains(json, "\n]}"), "JSON结构完整");
+        check(contains(json, "\"thread_name\"") && contains(json, "\"external\""), "包含线程名元数据");
+        size_t begins = countOf(json, "{\"name\":\"task\",\"ph\":\"B\"");
+        size_t ends = countOf(json, "{\"name\":\"task\",\"ph\":\"E\"");
+        check(begins == 20 && ends == 20, "每个任务一对开始/结束事件 B=" + std::to_string(begins) +
+                                          " E=" + std::to_string(ends));
+        check(countOf(json, "{\"name\":\"submit\"") == 20, "提交事件");
+    }
+
+    printSeparator("停止追踪后不再记录");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        pool.enableTracing(1024);
+        pool.post(TaskPriority::MEDIUM, []() {});
+        pool.waitForTasks();
+        pool.disableTracing();
+        pool.post(TaskPriority::MEDIUM, []() {});
+        pool.waitForTasks();
+        pool.dumpTrace(jsonPath);
+        check(countOf(readFile(jsonPath), "\"ph\":\"B\"") == 1, "只有启用期间的任务");
+    }
+
+    printSeparator("任务运行时重新配置追踪");
+    {
+        // 工作线程在记录事件时不持锁 重新配置不能释放它们正在写的存储
+        ThreadPool pool(4, LogLevel::ERROR);
+        std::atomic<bool> stop{false};
+        std::thread producer([&pool, &stop]() {
+            while (!stop.load()) {
+                pool.post(TaskPriority::MEDIUM, []() {});
+                std::this_thread::yield();
+            }
+        });
+        for (int round = 0; round < 50; ++round) {
+            pool.enableTracing(16 << (round % 4));
+            if (round % 5 == 0) {
+                pool.disableTracing();
+            }
+        }
+        stop.store(true);
+        producer.join();
+        pool.waitForTasks();
+        check(pool.dumpTrace(jsonPath) && contains(readFile(jsonPath), "\n]}"), "反复重新配置后仍可导出");
+    }
+
+    printSeparator("映射到文件的追踪");
+    {
+        ThreadPool pool(1, LogLevel::ERROR);
+        check(pool.enableTracing(256, binPath), "映射到文件");
+        for (int i = 0; i < 5; ++i) {
+            pool.post(TaskPriority::HIGH, []() {});
+        }
+        pool.waitForTasks();
+        // 重新映射同名文件 旧映射仍然有效
+        check(pool.enableTracing(64, binPath), "同名文件重新映射");
+        pool.post(TaskPriority::HIGH, []() {});
+        pool.waitForTasks();
+        pool.disableTracing();
+        check(TaskTracer::convertMappedFile(binPath, jsonPath), "转换映射文件");
+        std::string json = readFile(jsonPath);
+        check(countOf(json, "\"ph\":\"B\"") == 1 && countOf(json, "\"ph\":\"E\"") == 1,
+              "文件中只有重新映射后的事件");
+        check(contains(json, "\"priority\":2"), "事件带优先级");
+    }
+
+    std::remove(jsonPath.c_str());
+    std::remove(binPath.c_str());
+
+    printSeparator(failures == 0 ? "任务追踪测试通过" : "任务追踪测试失败");
+    return failures == 0 ? 0 : 1;
+}
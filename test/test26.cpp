@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+// 写入特征字节 释放前检查没有被其他分配覆盖
+struct Block {
+    unsigned char* data;
+    unsigned char tag;
+};
+
+Block allocateTagged(size_t size, unsigned char tag) {
+    auto* data = static_cast<unsigned char*>(SlabAllocator::allocate(size));
+    std::memset(data, tag, size);
+    return Block{data, tag};
+}
+
+bool intact(const Block& block, size_t size) {
+    return std::all_of(block.data, block.data + size, [&block](unsigned char c) { return c == block.tag; });
+}
+
+bool allDistinct(const std::vector<Block>& blocks) {
+    std::set<unsigned char*> addresses;
+    for (const Block& block : blocks) {
+        addresses.insert(block.data);
+    }
+    return addresses.size() == blocks.size();
+}
+
+// 在分配器的缓存交出之后析构: 构造早于本线程第一次分配 按构造的逆序析构
+struct LateReleaser {
+    std::vector<Block>* blocks = nullptr;
+    std::atomic<size_t>* corrupted = nullptr;
+
+    ~LateReleaser() {
+        if (blocks == nullptr) {
+            return;
+        }
+        // 线程退出阶段分配和释放 都不能碰已经被其他线程接管的缓存
+        std::vector<Block> late;
+        for (int i = 0; i < 32; ++i) {
+            late.push_back(allocateTagged(64, static_cast<unsigned char>(0xA0 + i)));
+        }
+        for (const Block& block : *blocks) {
+            if (!intact(block, 64)) {
+                corrupted->fetch_add(1);
+            }
+            SlabAllocator::deallocate(block.data, 64);
+        }
+        for (const Block& block : late) {
+            if (!intact(block, 64)) {
+                corrupted->fetch_add(1);
+            }
+            SlabAllocator::deallocate(block.data, 64);
+        }
+    }
+};
+
+thread_local LateReleaser lateReleaser;
+
+int main() {
+    printSeparator("跨线程释放");
+    {
+        std::vector<Block> blocks;
+        std::thread owner([&blocks]() {
+            for (int i = 0; i < 500; ++i) {
+                blocks.push_back(allocateTagged(48, static_cast<unsigned char>(i)));
+            }
+        });
+        owner.join();
+        check(allDistinct(blocks), "分配的块互不重叠");
+
+        size_t remoteBefore = SlabAllocator::remoteFreeCount();
+        bool allIntact = true;
+        for (const Block& block : blocks) {
+            allIntact = allIntact && intact(block, 48);
+            SlabAllocator::deallocate(block.data, 48);
+        }
+        check(allIntact, "其他线程的块内容完好");
+        check(SlabAllocator::remoteFreeCount() - remoteBefore == blocks.size(), "全部走跨线程归还");
+    }
+
+    printSeparator("线程退出后缓存被新线程接管");
+    {
+        // 上一节的线程退出时交出了缓存 新线程接管后复用已经归还的块 不新建slab
+        size_t slabsBefore = SlabAllocator::slabCount();
+        std::vector<Block> blocks;
+        std::thread adopter([&blocks]() {
+            for (int i = 0; i < 500; ++i) {
+                blocks.push_back(allocateTagged(48, static_cast<unsigned char>(i)));
+            }
+            for (const Block& block : blocks) {
+                SlabAllocator::deallocate(block.data, 48);
+            }
+        });
+        adopter.join();
+        check(SlabAllocator::slabCount() == slabsBefore, "接管的缓存复用已有slab");
+        check(allDistinct(blocks), "复用的块互不重叠");
+    }
+
+    printSeparator("线程退出阶段的分配和释放");
+    {
+        // 缓存交出后 本线程释放的块(包括退出阶段新分配的)都按跨线程归还 不再写交出的缓存
+        std::atomic<size_t> corrupted{0};
+        std::vector<Block> kept;
+        size_t remoteBefore = SlabAllocator::remoteFreeCount();
+        std::thread exiting([&kept, &corrupted]() {
+            lateReleaser.blocks = &kept;
+            lateReleaser.corrupted = &corrupted;
+            for (int i = 0; i < 200; ++i) {
+                kept.push_back(allocateTagged(64, static_cast<unsigned char>(i % 16)));
+            }
+        });
+        exiting.join();
+        check(SlabAllocator::remoteFreeCount() - remoteBefore == 200 + 32, "退出阶段的释放走跨线程归还");
+        check(corrupted.load() == 0, "退出阶段块内容完好");
+    }
+    {
+        std::atomic<size_t> corrupted{0};
+        std::vector<std::thread> threads;
+        std::vector<std::vector<Block>> kept(8);
+        for (size_t t = 0; t < kept.size(); ++t) {
+            threads.emplace_back([t, &kept, &corrupted]() {
+                lateReleaser.blocks = &kept[t];
+                lateReleaser.corrupted = &corrupted;
+                for (int i = 0; i < 200; ++i) {
+                    kept[t].push_back(allocateTagged(64, static_cast<unsigned char>(t * 16 + i % 16)));
+                }
+            });
+        }
+        // 同时有线程不断接管交出的缓存
+        std::vector<std::thread> adopters;
+        for (int t = 0; t < 8; ++t) {
+            adopters.emplace_back([&corrupted]() {
+                std::vector<Block> blocks;
+                for (int i = 0; i < 300; ++i) {
+                    blocks.push_back(allocateTagged(64, static_cast<unsigned char>(0x50 + i % 16)));
+                }
+                for (const Block& block : blocks) {
+                    if (!intact(block, 64)) {
+                        corrupted.fetch_add(1);
+                    }
+                    SlabAllocator::deallocate(block.data, 64);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (auto& thread : adopters) {
+            thread.join();
+        }
+        check(corrupted.load() == 0, "没有块被重复分配");
+    }
+
+    printSeparator("POOLED策略下的线程池");
+    {
+        bool correct = true;
+        for (int round = 0; round < 5; ++round) {
+            // 每轮新建线程池 工作线程退出后缓存交给下一轮的线程
+            ThreadPool pool(4, LogLevel::ERROR);
+            pool.setAllocationPolicy(AllocationPolicy::POOLED);
+            std::vector<std::thread> producers;
+            std::vector<std::vector<std::future<std::string>>> results(3);
+            for (size_t p = 0; p < results.size(); ++p) {
+                producers.emplace_back([&pool, &results, p]() {
+                    for (int i = 0; i < 300; ++i) {
+                        results[p].push_back(pool.enqueue([p, i]() {
+                            return std::to_string(p) + ":" + std::to_string(i);
+                        }));
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            for (size_t p = 0; p < results.size(); ++p) {
+                for (int i = 0; i < 300; ++i) {
+                    correct = correct && results[p][i].get() == std::to_string(p) + ":" + std::to_string(i);
+                }
+            }
+        }
+        check(correct, "多生产者提交 结果由工作线程跨线程释放");
+    }
+
+    printSeparator(failures == 0 ? "任务分配器测试通过" : "任务分配器测试失败");
+    return failures == 0 ? 0 : 1;
+}
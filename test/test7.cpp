@@ -0,0 +1,121 @@
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+int main() {
+    printSeparator("PoolFuture续延测试");
+
+    ThreadPool pool(4, LogLevel::ERROR);
+
+    // then链: 每一阶段作为新任务投递到线程池
+    auto chained = pool.enqueueAsync(TaskPriority::MEDIUM, [](int x) { return x * 2; }, 21)
+        .then([](int v) { return std::to_string(v); }, TaskPriority::HIGH)
+        .then([](std::string s) { return s + "!"; });
+    check(chained.get() == "42!", "then链式续延结果为 42!");
+
+    // 异常沿续延链传递 中间阶段被跳过
+    bool skipped = true;
+    auto failing = pool.enqueueAsync(TaskPriority::MEDIUM, []() -> int {
+            throw std::runtime_error("第一阶段失败");
+        })
+        .then([&skipped](int v) { skipped = false; return v; });
+    try {
+        failing.get();
+        check(false, "失败的阶段应当抛出异常");
+    } catch (const std::exception& e) {
+        check(skipped && std::string(e.what()) == "第一阶段失败", "异常传递到链尾且跳过后续阶段");
+    }
+
+    // 对已经完成的future挂续延
+    auto early = pool.enqueueAsync(TaskPriority::LOW, []() { return 7; });
+    early.wait();
+    check(early.then([](int v) { return v + 1; }).get() == 8, "已完成future上的续延立即调度");
+
+    printSeparator("whenAll / whenAny");
+
+    std::vector<PoolFuture<int>> parts;
+    for (int i = 0; i < 16; ++i) {
+        parts.push_back(pool.enqueueAsync(TaskPriority::MEDIUM, [i]() { return i * i; }));
+    }
+    auto all = whenAll(std::move(parts)).get();
+    int sum = 0;
+    for (int v : all) {
+        sum += v;
+    }
+    check(all.size() == 16 && sum == 1240, "whenAll按提交顺序汇总全部结果");
+
+    std::atomic<int> voidsDone{0};
+    std::vector<PoolFuture<void>> voids;
+    for (int i = 0; i < 4; ++i) {
+        voids.push_back(pool.enqueueAsync(TaskPriority::MEDIUM, [&voidsDone]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ++voidsDone;
+        }));
+    }
+    whenAll(std::move(voids)).get();
+    check(voidsDone.load() == 4, "whenAll<void>在全部输入完成后就绪");
+
+    bool emptyRejected = false;
+    try {
+        whenAll(std::vector<PoolFuture<int>>{});
+    } catch (const std::invalid_argument&) {
+        emptyRejected = true;
+    }
+    check(emptyRejected, "whenAll拒绝空输入");
+
+    std::vector<PoolFuture<int>> racers;
+    racers.push_back(pool.enqueueAsync(TaskPriority::MEDIUM, []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return 0;
+    }));
+    racers.push_back(pool.enqueueAsync(TaskPriority::MEDIUM, []() { return 1; }));
+    check(whenAny(std::move(racers)).get() == 1, "whenAny返回最先完成的下标");
+
+    printSeparator("转换为std::future");
+
+    std::future<int> std_future = pool.enqueueAsync(TaskPriority::MEDIUM, []() { return 99; })
+        .toStdFuture();
+    check(std_future.get() == 99, "toStdFuture结果正确");
+
+    pool.waitForTasks();
+
+    printSeparator("未执行就被丢弃的任务");
+    {
+        ThreadPool single(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        single.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+        while (single.getActiveThreadCount() == 0) {
+            std::this_thread::yield();
+        }
+
+        auto dropped = single.enqueueAsync(TaskPriority::MEDIUM, []() { return 1; });
+        auto chainedDrop = single.enqueueAsync(TaskPriority::MEDIUM, []() { return 2; })
+            .then([](int v) { return v + 1; });
+        single.clearTasks();
+
+        auto brokenPromise = [](auto& future) {
+            try {
+                future.get();
+            } catch (const std::future_error& e) {
+                return e.code() == std::future_errc::broken_promise;
+            } catch (...) {
+            }
+            return false;
+        };
+        check(brokenPromise(dropped), "clearTasks丢弃的任务 get()抛出broken_promise");
+        // 续延作为新任务排在阻塞任务之后 跳过函数只传递异常
+        gate.set_value();
+        check(brokenPromise(chainedDrop), "异常沿续延链传递");
+        single.waitForTasks();
+    }
+
+    printSeparator(failures == 0 ? "PoolFuture测试通过" : "PoolFuture测试失败");
+    return failures == 0 ? 0 : 1;
+}
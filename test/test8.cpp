@@ -0,0 +1,146 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <future>
+#include "Strand.h"
+#include "TestUtil.h"
+
+// 模拟账户: 串行执行时不需要任何锁
+struct Account {
+    std::vector<int> events;
+    std::atomic<int> inFlight{0};
+    bool overlapped = false;
+};
+
+int main() {
+    printSeparator("Strand串行执行测试");
+
+    const int accountCount = 8;
+    const int eventsPerAccount = 500;
+
+    ThreadPool pool(4, LogLevel::ERROR);
+    KeyedExecutor<int> executor(pool);
+    std::vector<std::unique_ptr<Account>> accounts;
+    for (int i = 0; i < accountCount; ++i) {
+        accounts.push_back(std::make_unique<Account>());
+    }
+
+    // 交错提交不同账户的事件
+    for (int e = 0; e < eventsPerAccount; ++e) {
+        for (int a = 0; a < accountCount; ++a) {
+            Account* account = accounts[a].get();
+            executor.post(a, [account, e]() {
+                if (account->inFlight.fetch_add(1) != 0) {
+                    account->overlapped = true;
+                }
+                account->events.push_back(e);
+                account->inFlight.fetch_sub(1);
+            });
+        }
+    }
+
+    // 每个账户最后一个事件返回的future完成即表示该账户全部事件完成
+    std::vector<std::future<size_t>> done;
+    for (int a = 0; a < accountCount; ++a) {
+        Account* account = accounts[a].get();
+        done.push_back(executor.enqueue(a, [account]() { return account->events.size(); }));
+    }
+    for (int a = 0; a < accountCount; ++a) {
+        check(done[a].get() == static_cast<size_t>(eventsPerAccount),
+              "账户 " + std::to_string(a) + " 收到全部事件");
+    }
+
+    bool ordered = true;
+    bool overlapped = false;
+    for (auto& account : accounts) {
+        for (int e = 0; e < eventsPerAccount; ++e) {
+            ordered = ordered && account->events[e] == e;
+        }
+        overlapped = overlapped || account->overlapped;
+    }
+    check(ordered, "同一账户内事件严格按提交顺序执行");
+    check(!overlapped, "同一账户的事件从不并发执行");
+
+    pool.waitForTasks();
+    // 工作线程释放drain任务持有的引用可能稍晚于waitForTasks返回
+    size_t purged = 0;
+    for (int i = 0; i < 100 && purged < static_cast<size_t>(accountCount); ++i) {
+        purged += executor.purgeIdle();
+        if (purged < static_cast<size_t>(accountCount)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    check(purged == static_cast<size_t>(accountCount), "空闲Strand可以回收");
+
+    printSeparator("线程池停止后投递");
+    {
+        std::shared_ptr<Strand> strand;
+        std::atomic<int> thrown{0};
+        std::atomic<bool> ran{false};
+        size_t pendingAfter = 1;
+        {
+            auto stopping = std::make_unique<ThreadPool>(1, LogLevel::NONE);
+            strand = Strand::create(*stopping);
+            ThreadPool* raw = stopping.get();
+            raw->post(TaskPriority::MEDIUM, [&, raw]() {
+                // 析构函数设置stop后等待工作线程 此时投递drain任务会失败
+                waitUntil([raw]() { return raw->isStopped(); }, std::chrono::seconds(5));
+                for (int i = 0; i < 2; ++i) {
+                    try {
+                        strand->post([&ran]() { ran = true; });
+                    } catch (const std::runtime_error&) {
+                        ++thrown;
+                    }
+                }
+                pendingAfter = strand->pending();
+                try {
+                    strand->enqueue([]() { return 1; });
+                } catch (const std::runtime_error&) {
+                    ++thrown;
+                }
+            });
+            while (raw->getActiveThreadCount() == 0) {
+                std::this_thread::yield();
+            }
+            stopping.reset();
+        }
+        check(thrown == 3, "每次投递都重新尝试调度并抛出异常");
+        check(pendingAfter == 0 && strand->pending() == 0 && !ran, "失败的投递回滚计数 任务不会执行");
+    }
+
+    printSeparator("drain任务被clearTasks丢弃");
+    {
+        ThreadPool single(1, LogLevel::ERROR);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        single.post(TaskPriority::MEDIUM, [opened]() { opened.wait(); });
+        waitUntil([&single]() { return single.getActiveThreadCount() == 1; }, std::chrono::seconds(5));
+
+        // drain任务排在被占住的工作线程后面 清空队列时没有执行就被丢弃
+        auto strand = Strand::create(single);
+        std::atomic<bool> dropped{false};
+        strand->post([&dropped]() { dropped = true; });
+        auto brokenFuture = strand->enqueue([]() { return 1; });
+        single.clearTasks();
+        check(strand->pending() == 0, "丢弃drain任务时释放调度权");
+        bool broken = false;
+        try {
+            brokenFuture.get();
+        } catch (const std::future_error& e) {
+            broken = e.code() == std::future_errc::broken_promise;
+        }
+        check(broken && !dropped, "被丢弃的任务不执行 future得到broken_promise");
+
+        gate.set_value();
+        auto next = strand->enqueue([]() { return 2; });
+        check(next.wait_for(std::chrono::seconds(5)) == std::future_status::ready && next.get() == 2,
+              "之后投递的任务正常执行");
+    }
+
+    printSeparator(failures == 0 ? "Strand测试通过" : "Strand测试失败");
+    return failures == 0 ? 0 : 1;
+}
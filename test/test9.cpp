@@ -0,0 +1,120 @@
+#include <atomic>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include "Logger.h"
+#include "TestUtil.h"
+
+size_t countLines(const std::string& path) {
+    std::ifstream in(path);
+    size_t lines = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        ++lines;
+    }
+    return lines;
+}
+
+bool fileExists(const std::string& path) {
+    std::ifstream in(path);
+    return in.good();
+}
+
+int main() {
+    printSeparator("异步日志测试");
+
+    const std::string logPath = "test_day9_async.log";
+    const int threads = 4;
+    const int perThread = 2000;
+    for (const auto& p : {logPath, logPath + ".1", logPath + ".2"}) {
+        std::remove(p.c_str());
+    }
+
+    size_t dropped = 0;
+    {
+        Logger logger(LogLevel::DEBUG, false, logPath);
+        AsyncLogOptions options;
+        options.ringCapacity = 256;
+        logger.enableAsync(options);
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&logger, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    logger.log(LogLevel::DEBUG, "工作线程 " + std::to_string(t) + " 消息 " + std::to_string(i));
+                }
+            });
+        }
+        for (auto& p : producers) {
+            p.join();
+        }
+        logger.flush();
+        dropped = logger.getDroppedCount();
+
+        size_t written = countLines(logPath);
+        std::cout << "  写出 " << written << " 条, 丢弃 " << dropped << " 条" << std::endl;
+        check(written + dropped == static_cast<size_t>(threads * perThread), "写出数 + 丢弃数 = 提交数");
+
+        // 超长消息在缓冲区记录中截断
+        logger.log(LogLevel::INFO, std::string(1000, 'x'));
+        logger.flush();
+        check(countLines(logPath) == written + 1, "超长消息被截断为一条记录");
+    }
+
+    printSeparator("生产者写日志时关闭异步模式");
+    std::remove(logPath.c_str());
+    {
+        Logger logger(LogLevel::DEBUG, false, logPath);
+        AsyncLogOptions options;
+        options.ringCapacity = 4096;
+        logger.enableAsync(options);
+
+        std::atomic<int> started{0};
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&logger, &started, t]() {
+                started.fetch_add(1);
+                for (int i = 0; i < perThread; ++i) {
+                    logger.log(LogLevel::DEBUG, "切换 " + std::to_string(t) + " 消息 " + std::to_string(i));
+                }
+            });
+        }
+        while (started.load() < threads) {
+            std::this_thread::yield();
+        }
+        // 切换瞬间已经开始写缓冲区的消息要么写进缓冲区后被写出 要么改走同步路径
+        logger.disableAsync();
+        check(!logger.isAsync(), "已回到同步模式");
+        for (auto& p : producers) {
+            p.join();
+        }
+        size_t written = countLines(logPath);
+        size_t lost = logger.getDroppedCount();
+        std::cout << "  写出 " << written << " 条, 丢弃 " << lost << " 条" << std::endl;
+        check(written + lost == static_cast<size_t>(threads * perThread), "切换时没有消息丢失");
+    }
+
+    printSeparator("日志轮转测试");
+    for (const auto& p : {logPath, logPath + ".1", logPath + ".2"}) {
+        std::remove(p.c_str());
+    }
+    {
+        Logger logger(LogLevel::INFO, false, logPath);
+        logger.setRotation(4 * 1024, 2);
+        for (int i = 0; i < 500; ++i) {
+            logger.log(LogLevel::INFO, "轮转测试消息 " + std::to_string(i));
+        }
+    }
+    check(fileExists(logPath + ".1") && fileExists(logPath + ".2"), "生成了两个备份文件");
+    check(!fileExists(logPath + ".3"), "备份数量不超过上限");
+
+    for (const auto& p : {logPath, logPath + ".1", logPath + ".2"}) {
+        std::remove(p.c_str());
+    }
+
+    printSeparator(failures == 0 ? "日志测试通过" : "日志测试失败");
+    return failures == 0 ? 0 : 1;
+}